@@ -15,6 +15,8 @@ int main(array<System::String ^> ^args)
     Application::EnableVisualStyles();
     Application::SetCompatibleTextRenderingDefault(false); 
 
+    sdrbindrcv(&sdrrcvdef); /* UI thread refers to default receiver */
+
     Application::Run(gcnew maindlg());
     return 0;
 }
@@ -40,8 +42,10 @@ int SDR::get_sat_info(int index, char * info)
 		//Tracking
 
 		info += sprintf(info, " Tracking ");
-		info += sprintf(info, "SNR: %4.1f ", sdrch[index].trk.S[0]);
-		double summ_value = sdrch[index].trk.Isum_fin / 1000.0;
+		sdrtrksnap_t snap;
+		trkgetsnap(&sdrch[index].trk, &snap);
+		info += sprintf(info, "SNR: %4.1f ", snap.S);
+		double summ_value = snap.Isum / 1000.0;
 		info += sprintf(info, "I-Summ: %.1f K ", summ_value);
 
 		if ((summ_value < TRACK_LOST_SUMM) && (summ_value > 0.0))
@@ -52,10 +56,12 @@ int SDR::get_sat_info(int index, char * info)
 		else
 		{
 			//Tracking stable
+			sdreph_t eph;
+			navgeteph(&sdrch[index].nav, &eph);
 
 			if (sdrch[index].nav.flagtow)
 			{
-				info += sprintf(info, "Week=%i ", sdrch[index].nav.sdreph.week_gpst);
+				info += sprintf(info, "Week=%i ", eph.week_gpst);
 			}
 			else if (sdrch[index].nav.flagsyncf)
 			{
@@ -70,7 +76,7 @@ int SDR::get_sat_info(int index, char * info)
 			else
 			{
 				//Count bits
-				uint8_t eph_state = sdrch[index].nav.sdreph.received_mask;
+				uint8_t eph_state = eph.received_mask;
 				uint8_t eph_count = 0;
 				for (uint8_t i = 0; i < 5; i++)
 				{
@@ -89,12 +95,23 @@ int SDR::get_sat_info(int index, char * info)
 	info += sprintf(info, "\n");
 	return 1;
 }
+int SDR::get_pos_info(char * info)
+{
+	sdrsol_t sol;
+
+	if (!pvtgetsol(&sol))
+		return -1;
+
+	sprintf(info, "Pos: %.7f %.7f %.1f m Ns=%i GDOP=%.1f\n",
+		sol.pos[0] * R2D, sol.pos[1] * R2D, sol.pos[2], sol.ns, sol.gdop);
+	return 1;
+}
 
 /* sdr start function */
 System::Void SDR::start(System::Object^ obj)
 {
     int i=0;
-    sdrini_t sdrini={0};
+    sdrini_t ini={0};
     maindlg^form=(maindlg^)obj;
     char *str,split;
     struct lconv *lc;
@@ -105,185 +122,186 @@ System::Void SDR::start(System::Object^ obj)
 
     /* reciver setting */
     str=(char*)(void*)Marshal::StringToHGlobalAnsi(form->tb_input1->Text);
-    memcpy(sdrini.file1,str,strlen(str));
+    memcpy(ini.file1,str,strlen(str));
     str=(char*)(void*)Marshal::StringToHGlobalAnsi(form->tb_input2->Text);
-    memcpy(sdrini.file2,str,strlen(str));
-    sdrini.fend=form->cmb_input->SelectedIndex + 1;
-    sdrini.f_sf[0]=str2double(form->tb_f1sf->Text,split)*1e6;
-    sdrini.f_sf[1]=str2double(form->tb_f2sf->Text,split)*1e6;
-    sdrini.f_if[0]=str2double(form->tb_f1if->Text,split)*1e6;
-    sdrini.f_if[1]=str2double(form->tb_f2if->Text,split)*1e6;
-    sdrini.useif1=1;
-    sdrini.useif2=(int)form->chk_input2->Checked;
-    sdrini.dtype[0]=(int)form->rb_f1IQ->Checked+1;
-    sdrini.dtype[1]=(int)form->rb_f2IQ->Checked+1;
+    memcpy(ini.file2,str,strlen(str));
+    ini.fend=form->cmb_input->SelectedIndex + 1;
+    ini.f_sf[0]=str2double(form->tb_f1sf->Text,split)*1e6;
+    ini.f_sf[1]=str2double(form->tb_f2sf->Text,split)*1e6;
+    ini.f_if[0]=str2double(form->tb_f1if->Text,split)*1e6;
+    ini.f_if[1]=str2double(form->tb_f2if->Text,split)*1e6;
+    ini.useif1=1;
+    ini.useif2=(int)form->chk_input2->Checked;
+    ini.dtype[0]=(int)form->rb_f1IQ->Checked+1;
+    ini.dtype[1]=(int)form->rb_f2IQ->Checked+1;
 
     if (form->cb_cf1->SelectedIndex>=0) {
         array<String^,1>^str1=form->cb_cf1->Items[form->cb_cf1->SelectedIndex]->ToString()->Split(' ',0);
-        sdrini.f_cf[0]=str2double(str1[0],split)*1e6;
+        ini.f_cf[0]=str2double(str1[0],split)*1e6;
     } else {
-        sdrini.f_cf[0]=0.0;
+        ini.f_cf[0]=0.0;
     }
 
     if (form->cb_cf2->SelectedIndex>=0) {
         array<String^,1>^str2=form->cb_cf2->Items[form->cb_cf2->SelectedIndex]->ToString()->Split(' ',0);
-        sdrini.f_cf[1]=str2double(str2[0],split)*1e6;
+        ini.f_cf[1]=str2double(str2[0],split)*1e6;
     } else {
-        sdrini.f_cf[1]=0.0;
+        ini.f_cf[1]=0.0;
     }
-    sdrini.rtlsdrppmerr=Convert::ToInt32(form->tb_clk->Text);
+    ini.rtlsdrppmerr=Convert::ToInt32(form->tb_clk->Text);
 
     /* tracking setting */
-    sdrini.trkcorrn=Convert::ToInt32(form->config->tb_corrn);
-    sdrini.trkcorrd=Convert::ToInt32(form->config->tb_corrd);
-    sdrini.trkcorrp=Convert::ToInt32(form->config->tb_corrp);
-    sdrini.trkdllb[0]=str2double(form->config->tb_dll1,split);
-    sdrini.trkdllb[1]=str2double(form->config->tb_dll2,split);
-    sdrini.trkpllb[0]=str2double(form->config->tb_pll1,split);
-    sdrini.trkpllb[1]=str2double(form->config->tb_pll2,split);
-    sdrini.trkfllb[0]=str2double(form->config->tb_fll1,split);
-    sdrini.trkfllb[1]=str2double(form->config->tb_fll2,split);
+    ini.trkcorrn=Convert::ToInt32(form->config->tb_corrn);
+    ini.trkcorrd=Convert::ToInt32(form->config->tb_corrd);
+    ini.trkcorrp=Convert::ToInt32(form->config->tb_corrp);
+    ini.trkdllb[0]=str2double(form->config->tb_dll1,split);
+    ini.trkdllb[1]=str2double(form->config->tb_dll2,split);
+    ini.trkpllb[0]=str2double(form->config->tb_pll1,split);
+    ini.trkpllb[1]=str2double(form->config->tb_pll2,split);
+    ini.trkfllb[0]=str2double(form->config->tb_fll1,split);
+    ini.trkfllb[1]=str2double(form->config->tb_fll2,split);
 
     /* channel setting */ /* GPS */
-    setsdrini(form->chk_G01->Checked, 1,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G02->Checked, 2,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G03->Checked, 3,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G04->Checked, 4,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G05->Checked, 5,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G06->Checked, 6,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G07->Checked, 7,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G08->Checked, 8,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G09->Checked, 9,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G10->Checked,10,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G11->Checked,11,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G12->Checked,12,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G13->Checked,13,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G14->Checked,14,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G15->Checked,15,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G16->Checked,16,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G17->Checked,17,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G18->Checked,18,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G19->Checked,19,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G20->Checked,20,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G21->Checked,21,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G22->Checked,22,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G23->Checked,23,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G24->Checked,24,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G25->Checked,25,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G26->Checked,26,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G27->Checked,27,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G28->Checked,28,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G29->Checked,29,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G30->Checked,30,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G31->Checked,31,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
-    setsdrini(form->chk_G32->Checked,32,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&sdrini);
+    setsdrini(form->chk_G01->Checked, 1,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G02->Checked, 2,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G03->Checked, 3,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G04->Checked, 4,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G05->Checked, 5,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G06->Checked, 6,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G07->Checked, 7,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G08->Checked, 8,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G09->Checked, 9,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G10->Checked,10,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G11->Checked,11,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G12->Checked,12,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G13->Checked,13,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G14->Checked,14,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G15->Checked,15,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G16->Checked,16,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G17->Checked,17,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G18->Checked,18,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G19->Checked,19,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G20->Checked,20,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G21->Checked,21,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G22->Checked,22,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G23->Checked,23,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G24->Checked,24,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G25->Checked,25,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G26->Checked,26,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G27->Checked,27,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G28->Checked,28,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G29->Checked,29,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G30->Checked,30,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G31->Checked,31,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
+    setsdrini(form->chk_G32->Checked,32,SYS_GPS,form->rb_G_FE2->Checked,form->chk_TYPE_L1CA->Checked,false,false,&ini);
 
     /* channel setting */ /* GLONASS */
-    setsdrini(form->chk_R_7->Checked,-7,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&sdrini);
-    setsdrini(form->chk_R_6->Checked,-6,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&sdrini);
-    setsdrini(form->chk_R_5->Checked,-5,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&sdrini);
-    setsdrini(form->chk_R_4->Checked,-4,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&sdrini);
-    setsdrini(form->chk_R_3->Checked,-3,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&sdrini);
-    setsdrini(form->chk_R_2->Checked,-2,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&sdrini);
-    setsdrini(form->chk_R_1->Checked,-1,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&sdrini);
-    setsdrini(form->chk_R0->Checked, 0,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&sdrini);
-    setsdrini(form->chk_R1->Checked, 1,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&sdrini);
-    setsdrini(form->chk_R2->Checked, 2,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&sdrini);
-    setsdrini(form->chk_R3->Checked, 3,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&sdrini);
-    setsdrini(form->chk_R4->Checked, 4,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&sdrini);
-    setsdrini(form->chk_R5->Checked, 5,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&sdrini);
-    setsdrini(form->chk_R6->Checked, 6,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&sdrini);
+    setsdrini(form->chk_R_7->Checked,-7,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&ini);
+    setsdrini(form->chk_R_6->Checked,-6,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&ini);
+    setsdrini(form->chk_R_5->Checked,-5,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&ini);
+    setsdrini(form->chk_R_4->Checked,-4,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&ini);
+    setsdrini(form->chk_R_3->Checked,-3,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&ini);
+    setsdrini(form->chk_R_2->Checked,-2,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&ini);
+    setsdrini(form->chk_R_1->Checked,-1,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&ini);
+    setsdrini(form->chk_R0->Checked, 0,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&ini);
+    setsdrini(form->chk_R1->Checked, 1,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&ini);
+    setsdrini(form->chk_R2->Checked, 2,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&ini);
+    setsdrini(form->chk_R3->Checked, 3,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&ini);
+    setsdrini(form->chk_R4->Checked, 4,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&ini);
+    setsdrini(form->chk_R5->Checked, 5,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&ini);
+    setsdrini(form->chk_R6->Checked, 6,SYS_GLO,form->rb_R_FE2->Checked,form->chk_TYPE_G1->Checked,false,false,&ini);
 
     /* channel setting */ /* GAL */
-    setsdrini(form->chk_E11->Checked,11,SYS_GAL,form->rb_E_FE2->Checked,form->chk_TYPE_E1B->Checked,false,false,&sdrini);
-    setsdrini(form->chk_E12->Checked,12,SYS_GAL,form->rb_E_FE2->Checked,form->chk_TYPE_E1B->Checked,false,false,&sdrini);
-    setsdrini(form->chk_E19->Checked,19,SYS_GAL,form->rb_E_FE2->Checked,form->chk_TYPE_E1B->Checked,false,false,&sdrini);
-    setsdrini(form->chk_E20->Checked,20,SYS_GAL,form->rb_E_FE2->Checked,form->chk_TYPE_E1B->Checked,false,false,&sdrini);
-	setsdrini(form->chk_E22->Checked,22,SYS_GAL,form->rb_E_FE2->Checked,form->chk_TYPE_E1B->Checked, false, false, &sdrini);
-	setsdrini(form->chk_E25->Checked, 25, SYS_GAL, form->rb_E_FE2->Checked, form->chk_TYPE_E1B->Checked, false, false, &sdrini);
-	setsdrini(form->chk_E27->Checked, 27, SYS_GAL, form->rb_E_FE2->Checked, form->chk_TYPE_E1B->Checked, false, false, &sdrini);
-	setsdrini(form->chk_E14->Checked, 14, SYS_GAL, form->rb_E_FE2->Checked, form->chk_TYPE_E1B->Checked, false, false, &sdrini);
-	setsdrini(form->chk_E30->Checked, 30, SYS_GAL, form->rb_E_FE2->Checked, form->chk_TYPE_E1B->Checked, false, false, &sdrini);
-	setsdrini(form->chk_E2->Checked, 2, SYS_GAL, form->rb_E_FE2->Checked, form->chk_TYPE_E1B->Checked, false, false, &sdrini);
-	setsdrini(form->chk_E4->Checked, 4, SYS_GAL, form->rb_E_FE2->Checked, form->chk_TYPE_E1B->Checked, false, false, &sdrini);
-	setsdrini(form->chk_E21->Checked, 21, SYS_GAL, form->rb_E_FE2->Checked, form->chk_TYPE_E1B->Checked, false, false, &sdrini);
-	setsdrini(form->chk_E9->Checked, 9, SYS_GAL, form->rb_E_FE2->Checked, form->chk_TYPE_E1B->Checked, false, false, &sdrini);
-	setsdrini(form->chk_E7->Checked, 7, SYS_GAL, form->rb_E_FE2->Checked, form->chk_TYPE_E1B->Checked, false, false, &sdrini);
+    setsdrini(form->chk_E11->Checked,11,SYS_GAL,form->rb_E_FE2->Checked,form->chk_TYPE_E1B->Checked,false,false,&ini);
+    setsdrini(form->chk_E12->Checked,12,SYS_GAL,form->rb_E_FE2->Checked,form->chk_TYPE_E1B->Checked,false,false,&ini);
+    setsdrini(form->chk_E19->Checked,19,SYS_GAL,form->rb_E_FE2->Checked,form->chk_TYPE_E1B->Checked,false,false,&ini);
+    setsdrini(form->chk_E20->Checked,20,SYS_GAL,form->rb_E_FE2->Checked,form->chk_TYPE_E1B->Checked,false,false,&ini);
+	setsdrini(form->chk_E22->Checked,22,SYS_GAL,form->rb_E_FE2->Checked,form->chk_TYPE_E1B->Checked, false, false, &ini);
+	setsdrini(form->chk_E25->Checked, 25, SYS_GAL, form->rb_E_FE2->Checked, form->chk_TYPE_E1B->Checked, false, false, &ini);
+	setsdrini(form->chk_E27->Checked, 27, SYS_GAL, form->rb_E_FE2->Checked, form->chk_TYPE_E1B->Checked, false, false, &ini);
+	setsdrini(form->chk_E14->Checked, 14, SYS_GAL, form->rb_E_FE2->Checked, form->chk_TYPE_E1B->Checked, false, false, &ini);
+	setsdrini(form->chk_E30->Checked, 30, SYS_GAL, form->rb_E_FE2->Checked, form->chk_TYPE_E1B->Checked, false, false, &ini);
+	setsdrini(form->chk_E2->Checked, 2, SYS_GAL, form->rb_E_FE2->Checked, form->chk_TYPE_E1B->Checked, false, false, &ini);
+	setsdrini(form->chk_E4->Checked, 4, SYS_GAL, form->rb_E_FE2->Checked, form->chk_TYPE_E1B->Checked, false, false, &ini);
+	setsdrini(form->chk_E21->Checked, 21, SYS_GAL, form->rb_E_FE2->Checked, form->chk_TYPE_E1B->Checked, false, false, &ini);
+	setsdrini(form->chk_E9->Checked, 9, SYS_GAL, form->rb_E_FE2->Checked, form->chk_TYPE_E1B->Checked, false, false, &ini);
+	setsdrini(form->chk_E7->Checked, 7, SYS_GAL, form->rb_E_FE2->Checked, form->chk_TYPE_E1B->Checked, false, false, &ini);
 
     /* channel setting */ /* BeiDou */
-    setsdrini(form->chk_C01->Checked, 1,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&sdrini);
-    setsdrini(form->chk_C02->Checked, 2,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&sdrini);
-    setsdrini(form->chk_C03->Checked, 3,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&sdrini);
-    setsdrini(form->chk_C04->Checked, 4,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&sdrini);
-    setsdrini(form->chk_C05->Checked, 5,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&sdrini);
-    setsdrini(form->chk_C06->Checked, 6,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&sdrini);
-    setsdrini(form->chk_C07->Checked, 7,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&sdrini);
-    setsdrini(form->chk_C08->Checked, 8,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&sdrini);
-    setsdrini(form->chk_C09->Checked, 9,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&sdrini);
-    setsdrini(form->chk_C10->Checked,10,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&sdrini);
-    setsdrini(form->chk_C11->Checked,11,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&sdrini);
-    setsdrini(form->chk_C12->Checked,12,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&sdrini);
-    setsdrini(form->chk_C13->Checked,13,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&sdrini);
-    setsdrini(form->chk_C14->Checked,14,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&sdrini);
+    setsdrini(form->chk_C01->Checked, 1,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&ini);
+    setsdrini(form->chk_C02->Checked, 2,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&ini);
+    setsdrini(form->chk_C03->Checked, 3,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&ini);
+    setsdrini(form->chk_C04->Checked, 4,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&ini);
+    setsdrini(form->chk_C05->Checked, 5,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&ini);
+    setsdrini(form->chk_C06->Checked, 6,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&ini);
+    setsdrini(form->chk_C07->Checked, 7,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&ini);
+    setsdrini(form->chk_C08->Checked, 8,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&ini);
+    setsdrini(form->chk_C09->Checked, 9,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&ini);
+    setsdrini(form->chk_C10->Checked,10,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&ini);
+    setsdrini(form->chk_C11->Checked,11,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&ini);
+    setsdrini(form->chk_C12->Checked,12,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&ini);
+    setsdrini(form->chk_C13->Checked,13,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&ini);
+    setsdrini(form->chk_C14->Checked,14,SYS_CMP,form->rb_C_FE2->Checked,form->chk_TYPE_B1I->Checked,false,false,&ini);
 
     /* channel setting */ /* QZS */
-    setsdrini(form->chk_Q01->Checked,193,SYS_QZS,form->rb_Q_FE2->Checked,form->chk_TYPE_L1CAQZS->Checked,false,false,&sdrini);
-    setsdrini(form->chk_Q01->Checked,183,SYS_QZS,form->rb_Q_FE2->Checked,false,form->chk_TYPE_SAIF->Checked,false,&sdrini);
-    setsdrini(form->chk_Q01->Checked,193,SYS_QZS,form->rb_Q_FE2->Checked,false,false,form->chk_TYPE_LEX->Checked,&sdrini);
+    setsdrini(form->chk_Q01->Checked,193,SYS_QZS,form->rb_Q_FE2->Checked,form->chk_TYPE_L1CAQZS->Checked,false,false,&ini);
+    setsdrini(form->chk_Q01->Checked,183,SYS_QZS,form->rb_Q_FE2->Checked,false,form->chk_TYPE_SAIF->Checked,false,&ini);
+    setsdrini(form->chk_Q01->Checked,193,SYS_QZS,form->rb_Q_FE2->Checked,false,false,form->chk_TYPE_LEX->Checked,&ini);
 
     /* channel setting */ /* SBAS */
-    setsdrini(form->chk_S120->Checked,120,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
-    setsdrini(form->chk_S121->Checked,121,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
-    setsdrini(form->chk_S122->Checked,122,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
-    setsdrini(form->chk_S123->Checked,123,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
-    setsdrini(form->chk_S124->Checked,124,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
-    setsdrini(form->chk_S125->Checked,125,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
-    setsdrini(form->chk_S126->Checked,126,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
-    setsdrini(form->chk_S127->Checked,127,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
-    setsdrini(form->chk_S128->Checked,128,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
-    setsdrini(form->chk_S129->Checked,129,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
-    setsdrini(form->chk_S130->Checked,130,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
-    setsdrini(form->chk_S131->Checked,131,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
-    setsdrini(form->chk_S132->Checked,132,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
-    setsdrini(form->chk_S133->Checked,133,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
-    setsdrini(form->chk_S134->Checked,134,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
-    setsdrini(form->chk_S135->Checked,135,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
-    setsdrini(form->chk_S136->Checked,136,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
-    setsdrini(form->chk_S137->Checked,137,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
-    setsdrini(form->chk_S138->Checked,138,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&sdrini);
+    setsdrini(form->chk_S120->Checked,120,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
+    setsdrini(form->chk_S121->Checked,121,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
+    setsdrini(form->chk_S122->Checked,122,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
+    setsdrini(form->chk_S123->Checked,123,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
+    setsdrini(form->chk_S124->Checked,124,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
+    setsdrini(form->chk_S125->Checked,125,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
+    setsdrini(form->chk_S126->Checked,126,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
+    setsdrini(form->chk_S127->Checked,127,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
+    setsdrini(form->chk_S128->Checked,128,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
+    setsdrini(form->chk_S129->Checked,129,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
+    setsdrini(form->chk_S130->Checked,130,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
+    setsdrini(form->chk_S131->Checked,131,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
+    setsdrini(form->chk_S132->Checked,132,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
+    setsdrini(form->chk_S133->Checked,133,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
+    setsdrini(form->chk_S134->Checked,134,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
+    setsdrini(form->chk_S135->Checked,135,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
+    setsdrini(form->chk_S136->Checked,136,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
+    setsdrini(form->chk_S137->Checked,137,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
+    setsdrini(form->chk_S138->Checked,138,SYS_SBS,form->rb_S_FE2->Checked,true,form->chk_TYPE_SBASL1->Checked,false,&ini);
 
     /* output setting */
-    sdrini.pltacq=(int)form->chk_plotacq->Checked;
-    sdrini.plttrk=(int)form->chk_plottrk->Checked;
+    ini.pltacq=(int)form->chk_plotacq->Checked;
+    ini.plttrk=(int)form->chk_plottrk->Checked;
 
     /* output setting */
     switch(form->cmb_outint->SelectedIndex) 
 	{
-		case 0: sdrini.outms=1000; break;
-		case 1: sdrini.outms=200; break;
-		case 2: sdrini.outms=100; break;
+		case 0: ini.outms=1000; break;
+		case 1: ini.outms=200; break;
+		case 2: ini.outms=100; break;
 		default:
-			sdrini.outms = 1000;
+			ini.outms = 1000;
     }
-    sdrini.rinex=(int)form->chk_rinex->Checked;
-    sdrini.rtcm=(int)form->chk_rtcm->Checked;
-    sdrini.lex=(int)form->chk_lex->Checked;
-    sdrini.sbas=(int)form->chk_saif->Checked;
-    sdrini.log=(int)form->chk_log->Checked;
-	sdrini.use_restore_acq = (int)form->chk_RestoreAcq->Checked;
-	sdrini.dispay_track_cycles = (int)form->chk_DispTrackCycles->Checked;
-    sprintf(sdrini.rinexpath,"%s",form->tb_rinex_dir->Text);
-    if (form->tb_rtcm_port->Text!="") sdrini.rtcmport=Convert::ToInt32(form->tb_rtcm_port->Text);
-    if (form->tb_lex_port->Text!="") sdrini.lexport=Convert::ToInt32(form->tb_lex_port->Text);
-    if (form->tb_saif_port->Text!="") sdrini.sbasport=Convert::ToInt32(form->tb_saif_port->Text);
-
-	satCount = sdrini.nch;
+    ini.rinex=(int)form->chk_rinex->Checked;
+    ini.pvt=1; /* position for monitor */
+    ini.rtcm=(int)form->chk_rtcm->Checked;
+    ini.lex=(int)form->chk_lex->Checked;
+    ini.sbas=(int)form->chk_saif->Checked;
+    ini.log=(int)form->chk_log->Checked;
+	ini.use_restore_acq = (int)form->chk_RestoreAcq->Checked;
+	ini.dispay_track_cycles = (int)form->chk_DispTrackCycles->Checked;
+    sprintf(ini.rinexpath,"%s",form->tb_rinex_dir->Text);
+    if (form->tb_rtcm_port->Text!="") ini.rtcmport=Convert::ToInt32(form->tb_rtcm_port->Text);
+    if (form->tb_lex_port->Text!="") ini.lexport=Convert::ToInt32(form->tb_lex_port->Text);
+    if (form->tb_saif_port->Text!="") ini.sbasport=Convert::ToInt32(form->tb_saif_port->Text);
+
+	satCount = ini.nch;
 
     /* sdr initialization */
-    initsdrgui(form,&sdrini);
+    initsdrgui(form,&ini);
 
     /* create sdr thread*/
-    hmainthread=(HANDLE)_beginthread(startsdr,0,NULL);
+    hmainthread=(HANDLE)_beginthread(startsdr,0,&sdrrcvdef);
 }
 /* set sdr initialize struct function */
 void setsdrini(bool bsat, int prn, int sys, int ftype, bool L1, bool sbas, bool lex, sdrini_t *ini)
@@ -374,26 +392,26 @@ System::Void SDR::stop(System::Object^ obj)
 System::Void SDR::startspectrum(System::Object^ obj)
 {
     maindlg^form=(maindlg^)obj;
-    sdrspec_t sdrspec={0};
+    sdrspec_t spec={0};
 
     if (form->rb_spec1->Checked) {
-        sdrspec.dtype=(int)form->rb_f1IQ->Checked+1;
-        sdrspec.ftype=1;
+        spec.dtype=(int)form->rb_f1IQ->Checked+1;
+        spec.ftype=1;
 
 		System::String ^text = form->tb_f1sf->Text;
 
 		text = text->Replace(',', '.');
-        sdrspec.f_sf=Convert::ToDouble(text, CultureInfo::InvariantCulture)*1e6;
-        sdrspec.nsamp=(int)(sdrspec.f_sf/1000);
+        spec.f_sf=Convert::ToDouble(text, CultureInfo::InvariantCulture)*1e6;
+        spec.nsamp=(int)(spec.f_sf/1000);
     }
     if (form->rb_spec2->Checked) {
-        sdrspec.dtype=(int)form->rb_f2IQ->Checked+1;
-        sdrspec.ftype=2;
-        sdrspec.f_sf=Convert::ToDouble(form->tb_f2sf->Text)*1e6;
-        sdrspec.nsamp=(int)(sdrspec.f_sf/1000);
+        spec.dtype=(int)form->rb_f2IQ->Checked+1;
+        spec.ftype=2;
+        spec.f_sf=Convert::ToDouble(form->tb_f2sf->Text)*1e6;
+        spec.nsamp=(int)(spec.f_sf/1000);
     }
     sdrstat.specflag=OFF;	
-    initsdrspecgui(&sdrspec);
+    initsdrspecgui(&spec);
 }
 /* sdr spectrum stop */
 System::Void SDR::stopspectrum(System::Object^ obj)
@@ -3,6 +3,7 @@ public ref class SDR
 {
 public: int get_sat_count(System::Void);
 public: int get_sat_info(int index, char *info);
+public: int get_pos_info(char *info);
 public: void start(Object^ obj);
 public: void stop(Object^ obj);
 public: void startspectrum(Object^ obj);
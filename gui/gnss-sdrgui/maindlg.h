@@ -3871,6 +3871,9 @@ private:
 		char tmp_string[128];
 		System::String^ tmpStr = gcnew String("");
 
+		if (sdr->get_pos_info(tmp_string) > 0)
+			tmpStr += gcnew String(tmp_string);
+
 		for (int i = 0; i < sat_count; i++)
 		{
 			sdr->get_sat_info(i, tmp_string);
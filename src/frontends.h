@@ -15,5 +15,7 @@
 #define FEND_FRTLSDR  9                /* front end type: RTL-SDR binary file */
 #define FEND_FBLADERF 10                /* front end type: BladeRF binary file */
 #define FEND_FILE     11               /* front end type: IF file */
+//NETWORK
+#define FEND_NET      12               /* front end type: network IF stream */
 
 #endif //FRONTENDS_H
\ No newline at end of file
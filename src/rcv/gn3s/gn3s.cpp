@@ -7,11 +7,16 @@
 #include "sdr.h"
 #include "fx2.h"
 
-/* global variables ----------------------------------------------------------*/
 using namespace std;
-Fx2_dev fx2_d;
 
-uint32_t fgn3s_read_buf_size = 0;
+#define FX2DEV (*(Fx2_dev *)sdrstat.dev) /* device of current receiver */
+
+/* free device of current receiver -------------------------------------------*/
+static void freefx2(void)
+{
+    delete (Fx2_dev *)sdrstat.dev;
+    sdrstat.dev=NULL;
+}
 
 /* GN3S initialization ---------------------------------------------------------
 * search front end and initialization
@@ -24,50 +29,54 @@ extern int gn3s_init(void)
     unsigned char uc_flags[5];
 
     /* Look for a device */
-    fx2_d = Fx2_dev(1); /* PID 0x0b39 */
-    if (fx2_d.usb_fx2_find() != 0) {
+    sdrstat.dev=new Fx2_dev(1); /* PID 0x0b39 */
+    if (FX2DEV.usb_fx2_find() != 0) {
         version = 2;
         if (sdrini.fend!=FEND_GN3SV2) {
             SDRPRINTF("error: wrong frontend type, GN3SV2 is found\n"); 
+            freefx2();
             return -1;
         }
     } else {
-        fx2_d = Fx2_dev(2); /* PID 0x0b3a */
-        if (fx2_d.usb_fx2_find() != 0) {
+        FX2DEV = Fx2_dev(2); /* PID 0x0b3a */
+        if (FX2DEV.usb_fx2_find() != 0) {
             version = 3;
             if (sdrini.fend!=FEND_GN3SV3) {
                 SDRPRINTF("error: wrong frontend type, GN3SV3 is found\n"); 
+                freefx2();
                 return -1;
             }
         } else {
-            fx2_d = Fx2_dev(3); /* PID 0x0b3f */
-            if(fx2_d.usb_fx2_find()!=0) {
+            FX2DEV = Fx2_dev(3); /* PID 0x0b3f */
+            if(FX2DEV.usb_fx2_find()!=0) {
                 version = 3;
                 if (sdrini.fend!=FEND_GN3SV3) {
                     SDRPRINTF("error: wrong frontend type, GN3SV3 is found\n");
+                    freefx2();
                     return -1;
                 }
             } else {
                 SDRPRINTF("error: no GN3S frontend found\n"); 
+                freefx2();
                 return -1;
             }
         }
     }
-    fx2_d.usb_fx2_init(0);
+    FX2DEV.usb_fx2_init(0);
     /* version 2 */
     if (version==2) {
-        fx2_d.usrp_xfer(VRQ_XFER, 1);
+        FX2DEV.usrp_xfer(VRQ_XFER, 1);
     }
     /* version 3 */
     if (version==3) {
-        fx2_d.usrp_xfer (VRQ_AGC,0); /* AGC OFF */
-        fx2_d.usrp_xfer (VRQ_CMODE,132 );
-        fx2_d.usrp_xfer (VRQ_XFER, 0 );
-        fx2_d.usrp_xfer (VRQ_XFER, 1);
-        fx2_d.usrp_xfer2(VRQ_FLAGS, 0, uc_flags, 5);
-        fx2_d.usrp_xfer (VRQ_XFER, 0 );
-        fx2_d.usrp_xfer(VRQ_CMODE,GN3S_MODE);
-        fx2_d.usrp_xfer(VRQ_XFER, 1);
+        FX2DEV.usrp_xfer (VRQ_AGC,0); /* AGC OFF */
+        FX2DEV.usrp_xfer (VRQ_CMODE,132 );
+        FX2DEV.usrp_xfer (VRQ_XFER, 0 );
+        FX2DEV.usrp_xfer (VRQ_XFER, 1);
+        FX2DEV.usrp_xfer2(VRQ_FLAGS, 0, uc_flags, 5);
+        FX2DEV.usrp_xfer (VRQ_XFER, 0 );
+        FX2DEV.usrp_xfer(VRQ_CMODE,GN3S_MODE);
+        FX2DEV.usrp_xfer(VRQ_XFER, 1);
     }
     return 0;
 }
@@ -78,8 +87,9 @@ extern int gn3s_init(void)
 *-----------------------------------------------------------------------------*/
 extern void gn3s_quit(void) 
 {
-    fx2_d.close();
-    fx2_d.~Fx2_dev();
+    if (sdrstat.dev==NULL) return;
+    FX2DEV.close();
+    freefx2();
 }
 /* data expansion to binary (GN3S v2) ------------------------------------------
 * get current data buffer from memory buffer
@@ -90,49 +100,24 @@ extern void gn3s_quit(void)
 *-----------------------------------------------------------------------------*/
 extern void gn3s_exp_v2(unsigned char *buf, int n, char *expbuf)
 {
-    int i;
-    char LUT_1bit[2]={1,-1};
     char shift=0, endshift=0;
 
+    if (n<2) return;
+
     /* data shift (refer gn3s-full.cc) */
     /* http://ccar.colorado.edu/gnss/files/GN3Sv2.7z */
     if ((buf[  0]&0x02)!=2) shift=1;
     if ((buf[n-1]&0x02)!=0) endshift=1;
 
-    for (i=0;i<n;i++) {
-        if (shift) {
-            if ((i==(n-1))&&!endshift)     expbuf[i]=0;
-            else if ((i==(n-1))&&endshift) expbuf[i-1]=0;
-            else expbuf[i]=LUT_1bit[buf[i+1]&0x01];
-        } else {
-            if ((i==(n-1))&&endshift) expbuf[i]=0;
-            else expbuf[i]=LUT_1bit[buf[i]&0x01];
-        }
-    }
-}
-/* get current data buffer (GN3S v2) -------------------------------------------
-* get current data buffer from memory buffer
-* args   : uint64_t buffloc I   buffer location
-*          int    n         I   number of grab data
-*          int    dtype     I   data type (DTYPEI or DTYPEIQ)
-*          char   *expbuff  O   extracted data buffer
-* return : none
-*-----------------------------------------------------------------------------*/
-extern void gn3s_getbuff_v2(uint64_t buffloc, int n, int dtype, char *expbuf)
-{
-    uint64_t membuffloc=2*buffloc%(MEMBUFFLEN*fgn3s_read_buf_size);
-    int nout;
-    n=2*n;
-    nout=(int)((membuffloc+n)-(MEMBUFFLEN*fgn3s_read_buf_size));
+    /* 1-bit data: 0:+1 1:-1 */
+    conv1bit(buf+shift,n-1,expbuf);
 
-    mlock(hbuffmtx);
-    if (nout>0) {
-        gn3s_exp_v2(&sdrstat.buff[membuffloc],n-nout,expbuf);
-        gn3s_exp_v2(&sdrstat.buff[0],nout,&expbuf[n-nout]);
+    if (shift) {
+        expbuf[n-1]=0;
+        if (endshift) expbuf[n-2]=0;
     } else {
-        gn3s_exp_v2(&sdrstat.buff[membuffloc],n,expbuf);
+        expbuf[n-1]=endshift?0:(char)(1-2*(buf[n-1]&0x01));
     }
-    unmlock(hbuffmtx);
 }
 /* data expansion to binary (GN3S v3) ------------------------------------------
 * get current data buffer from memory buffer
@@ -145,7 +130,6 @@ extern void gn3s_getbuff_v2(uint64_t buffloc, int n, int dtype, char *expbuf)
 extern void gn3s_exp_v3(unsigned char *buf, int n, int i_mode, char *expbuf)
 {
     int i=0;
-    int i_idx=0;
     int i_dtype=0;
     char LUT_2bit[4]={1,-1,3,-3};
     char LUT_I_4bit[16]={1,-1,0,0,3,-3,0,0,0,0,0,0,0,0,0,0};
@@ -153,6 +137,7 @@ extern void gn3s_exp_v3(unsigned char *buf, int n, int i_mode, char *expbuf)
     char MASK_2bit=0x03;
     char MASK_4bit_I=0x05;
     char MASK_4bit_Q=0x0A;
+    char lut[16],luti[16],lutq[16]; /* index: lower 4 bits */
 
     /* determine  mode */
     if (((i_mode% 100)==32)|| ((i_mode% 100)==38)) {
@@ -162,69 +147,61 @@ extern void gn3s_exp_v3(unsigned char *buf, int n, int i_mode, char *expbuf)
         i_dtype =4;
     }
 
-    for (i=0;i<n;i++) {
-        switch (i_dtype) {
-        case 2:
-            expbuf[i_idx]=LUT_2bit[buf[i] & MASK_2bit];
-            i_idx++;
-            break;
-        case 4:
-            expbuf[i_idx]=LUT_I_4bit[buf[i] & MASK_4bit_I];
-            i_idx++;
-            expbuf[i_idx]=LUT_Q_4bit[buf[i] & MASK_4bit_Q];
-            i_idx++;
-            break;
-        }
+    for (i=0;i<16;i++) {
+        lut [i]=LUT_2bit  [i & MASK_2bit];
+        luti[i]=LUT_I_4bit[i & MASK_4bit_I];
+        lutq[i]=LUT_Q_4bit[i & MASK_4bit_Q];
     }
-}
-/* get current data buffer (GN3S v3) -------------------------------------------
-* get current data buffer from memory buffer
-* args   : uint64_t buffloc I   buffer location
-*          int    n         I   number of grab data
-*          int    dtype     I   data type (DTYPEI or DTYPEIQ)
-*          char   *expbuff  O   extracted data buffer
-* return : none
-*-----------------------------------------------------------------------------*/
-extern void gn3s_getbuff_v3(uint64_t buffloc, int n, int dtype, char *expbuf)
-{
-    uint64_t membuffloc=buffloc%(MEMBUFFLEN*fgn3s_read_buf_size);
-    int nout=(int)((membuffloc+n)-(MEMBUFFLEN*fgn3s_read_buf_size));
-
-    mlock(hbuffmtx);
-    if (nout>0) {
-        gn3s_exp_v3(&sdrstat.buff[membuffloc],n-nout,GN3S_MODE,expbuf);
-        gn3s_exp_v3(&sdrstat.buff[0],nout,GN3S_MODE,&expbuf[dtype*(n-nout)]);
-    } else {
-        gn3s_exp_v3(&sdrstat.buff[membuffloc],n,GN3S_MODE,expbuf);
+    switch (i_dtype) {
+    case 2:
+        convlut(buf,n,lut,expbuf);
+        break;
+    case 4:
+        convlutiq(buf,n,luti,lutq,expbuf);
+        break;
     }
-    unmlock(hbuffmtx);
 }
 /* push data to memory buffer --------------------------------------------------
 * push data to memory buffer from GN3S front end
 * args   : none
-* return : none
+* return : int                  status 0:okay
+* note : buffer overrun of front end is counted and the data are pushed
 *-----------------------------------------------------------------------------*/
 extern int gn3s_pushtomembuf(void) 
 {
     bool b_overrun=false;
     int nbuff;
+    char *p;
 
     /* check buffer overrun */
-    fx2_d.check_rx_overrun(&b_overrun);
-    if (b_overrun) return -1;
+    FX2DEV.check_rx_overrun(&b_overrun);
+    if (b_overrun) {
+        sdrstat.noverrun++;
+        SDRPRINTF("GN3S buffer overrun (%.0f)\n",(double)sdrstat.noverrun);
+    }
+
+    /* read raw data to staging buffer */
+    nbuff=FX2DEV.read_IF(sdrstat.buff2);
 
+    /* expand raw data to memory buffer (int8) */
     mlock(hbuffmtx);
-    nbuff=fx2_d.read_IF(
-		&sdrstat.buff[(sdrstat.buffcnt%MEMBUFFLEN)*fgn3s_read_buf_size]);
+    p=(char *)&sdrstat.buff[(sdrstat.buffcnt&sdrstat.nblkmask)*
+        sdrini.dtype[0]*sdrstat.fendbuffsize];
+    if (sdrini.fend==FEND_GN3SV2) {
+        gn3s_exp_v2(sdrstat.buff2,GN3S_BUFFSIZE,p);
+    } else {
+        gn3s_exp_v3(sdrstat.buff2,GN3S_BUFFSIZE,GN3S_MODE,p);
+    }
     unmlock(hbuffmtx);
 
-    if (nbuff!= fgn3s_read_buf_size) {
+    if (nbuff!= sdrstat.fendbuffsize) {
         SDRPRINTF("GN3S read IF error...\n");
     }
 
     mlock(hreadmtx);
     sdrstat.buffcnt++;
     unmlock(hreadmtx);
+    teepush(); /* tee recording */
 
 
     return 0;
@@ -240,47 +217,18 @@ extern void fgn3s_pushtomembuf(void)
 
     mlock(hbuffmtx);
 
-    nread=fread(&sdrstat.buff[(sdrstat.buffcnt%MEMBUFFLEN)*fgn3s_read_buf_size],
-        1, fgn3s_read_buf_size,sdrini.fp1);
+    nread=fread(&sdrstat.buff[(sdrstat.buffcnt&sdrstat.nblkmask)*
+        sdrini.dtype[0]*sdrstat.fendbuffsize],1,
+        sdrini.dtype[0]*sdrstat.fendbuffsize,sdrini.fp1);
 
     unmlock(hbuffmtx);
 
-    if (nread< fgn3s_read_buf_size) {
-        sdrstat.stopflag=ON;
-        SDRPRINTF("end of file!\n");
+    if (nread<(size_t)(sdrini.dtype[0]*sdrstat.fendbuffsize)) {
+        rcveof();
     }
 
     mlock(hreadmtx);
     sdrstat.buffcnt++;
     unmlock(hreadmtx);
 }
-/* get current data buffer from IF file ----------------------------------------
-* post-processing function: get current data buffer from memory buffer
-* args   : uint64_t buffloc I   buffer location
-*          int    n         I   number of grab data 
-*          int    dtype     I   data type (DTYPEI or DTYPEIQ)
-*          char   *expbuff  O   extracted data buffer
-* return : none
-*-----------------------------------------------------------------------------*/
-extern void fgn3s_getbuff(uint64_t buffloc, int n, int dtype, char *expbuf)
-{
-    uint64_t membuffloc=dtype*buffloc%(MEMBUFFLEN*dtype*fgn3s_read_buf_size);
-    int nout;
-
-    n=dtype*n;
-    nout=(int)((membuffloc+n)-(MEMBUFFLEN*dtype*fgn3s_read_buf_size));
 
-    mlock(hbuffmtx);
-    if (nout>0) {
-        memcpy(expbuf,&sdrstat.buff[membuffloc],n-nout);
-        memcpy(&expbuf[(n-nout)],&sdrstat.buff[0],nout);
-    } else {
-        memcpy(expbuf,&sdrstat.buff[membuffloc],n);
-    }
-    unmlock(hbuffmtx);
-}
-
-extern void fgn3s_set_rx_buf(uint32_t buf_size)
-{
-	fgn3s_read_buf_size = buf_size;
-}
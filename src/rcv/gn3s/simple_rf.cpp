@@ -6,16 +6,23 @@
 #include "sdr.h"
 #include "fx2.h"
 
-/* global variables ----------------------------------------------------------*/
 using namespace std;
-Fx2_dev fx2_d2;
-
-uint32_t simple_rf_read_buf_size = 0;
 const int FirmwareConfigAddr = 0x1003;
 
-UINT64 simple_rf_test_rx_cnt = 0;
-int simple_rf_test_marker_err_cnt = 0;
-UINT64  simple_rf_marker_counter = 0;
+/* simple front end device of receiver */
+typedef struct {
+	Fx2_dev fx2;                  /* FX2 device */
+	UINT64 rx_cnt;                /* received bytes */
+	int marker_err_cnt;           /* marker errors */
+	UINT64 marker_counter;        /* received markers */
+	UINT64 prev_marker;           /* received bytes at last marker */
+	uint8_t state_cnt;            /* marker state */
+	uint8_t expected_byte;        /* expected byte of marker */
+	uint8_t prev_packet_id;       /* id of last marker */
+	uint32_t prev_diff_bytes;     /* lost bytes at last check */
+} simplerf_t;
+
+#define SIMPLERF ((simplerf_t *)sdrstat.dev) /* device of current receiver */
 
 //--------------------------------------------------------------------------
 
@@ -24,7 +31,7 @@ static void pre_reset_callback(usb_dev_handle *device)
 {
 	uint8_t firmware_config[6] = {18, 67, 224, 12, 16, 0};
 	
-	int result = fx2_d2.ezusb_write2(
+	int result = SIMPLERF->fx2.ezusb_write2(
 		device, "Write config", 0xA0, FirmwareConfigAddr, firmware_config, ARRAYSIZE(firmware_config));
 	if (result < 0) 
 	{
@@ -42,7 +49,6 @@ extern int simple_rf_init(void)
 {
     unsigned char uc_flags[5];
 	char firmware_path[500] = {0};
-	simple_rf_marker_counter = 0;
 
 #ifdef WIN32
 	char drive[_MAX_DRIVE];
@@ -59,22 +65,28 @@ extern int simple_rf_init(void)
 #endif
 
     /* Look for a device */
-    fx2_d2 = Fx2_dev(4); /* VID_04B4&PID_8613 */
-    if (fx2_d2.usb_fx2_find() == 0) 
+	sdrstat.dev = new simplerf_t();
+	SIMPLERF->fx2 = Fx2_dev(4); /* VID_04B4&PID_8613 */
+	SIMPLERF->expected_byte = 0xAA;
+    if (SIMPLERF->fx2.usb_fx2_find() == 0) 
 	{
 		SDRPRINTF("error: no Simple RF frontend found\n");
+		delete SIMPLERF;
+		sdrstat.dev = NULL;
 		return -1;
     } 
 
 	//Load fx2pipe firmware to the FX2
-	int prepare_res = fx2_d2.usb_fx2_prepare(firmware_path, pre_reset_callback);
+	int prepare_res = SIMPLERF->fx2.usb_fx2_prepare(firmware_path, pre_reset_callback);
 	if (prepare_res < 0)
 	{
 		SDRPRINTF("error: Can't load firmware to the frontend\n");
+		delete SIMPLERF;
+		sdrstat.dev = NULL;
 		return -1;
 	}
 
-	fx2_d2.usb_fx2_init(1);
+	SIMPLERF->fx2.usb_fx2_init(1);
     return 0;
 }
 
@@ -87,8 +99,10 @@ extern int simple_rf_init(void)
 *-----------------------------------------------------------------------------*/
 extern void simple_rf_quit(void) 
 {
-    fx2_d2.close();
-    fx2_d2.~Fx2_dev();
+    if (sdrstat.dev == NULL) return;
+    SIMPLERF->fx2.close();
+    delete SIMPLERF;
+    sdrstat.dev = NULL;
 }
 
 
@@ -104,64 +118,15 @@ extern void simple_rf_exp(unsigned char *buf, int n, char *expbuf)
 {
 	memcpy(expbuf, buf, n);
 }
-/* get current data buffer (Simple frontend) -------------------------------------------
-* get current data buffer from local memory buffer
-* args   : uint64_t buffloc I   buffer location
-*          int    n         I   number of grab data
-*          int    dtype     I   data type (DTYPEI or DTYPEIQ)
-*          char   *expbuff  O   extracted data buffer - destination
-* return : none
-*-----------------------------------------------------------------------------*/
-extern void simple_rf_getbuf(uint64_t buffloc, int n, int dtype, char *expbuf)
-{
-    uint64_t membuffloc = buffloc % (MEMBUFFLEN * simple_rf_read_buf_size);
-    int nout = (int)((membuffloc + n) - (MEMBUFFLEN * simple_rf_read_buf_size));
-
-    mlock(hbuffmtx);
-	if (nout > 0)
-	{
-		memcpy(expbuf, &sdrstat.buff[membuffloc], n - nout);
-		memcpy(&expbuf[n - nout], &sdrstat.buff[0], nout);
-	}
-	else
-	{
-		memcpy(expbuf, &sdrstat.buff[membuffloc], n);
-	}
-    unmlock(hbuffmtx);
-}
-
 //Make four 2bit samples from one 
 void simple_rf_convert_8bit(uint8_t *src_buf, uint8_t *dst_buf)
 {
-	int i = 0;
-	int i_idx = 0;
-	int sample = 0;
 	int src_length = SIMPLE_RF_BUFFSIZE / 4;
 
-	char LUT_2bit[4]={+1, +3, -1, -3};
+	char LUT_2bit[4]={+1, +3, -1, -3}; //index: mag(bit 3) | sign(bit 7) << 1
 	//char LUT_2bit[4] = { 0x1, 0x3, 0xFF, 0xFD };
 
-	uint8_t res_byte;
-	uint8_t byteValUp;
-	uint8_t byteValLow;
-	uint8_t src_byte;
-
-	for (i = 0; i < src_length; i++)
-	{
-		src_byte = src_buf[i];
-		for (sample = 0; sample < 4; sample++)
-		{
-			res_byte = 0;
-			if ((src_byte & 8) != 0)
-				res_byte |= 1; //mag
-			if ((src_byte & 128) != 0)
-				res_byte |= 2; //sign
-
-			dst_buf[i_idx] = LUT_2bit[res_byte];
-			src_byte = src_byte << 1;
-			i_idx++;
-		}
-	}
+	conv2bitx4(src_buf, src_length, LUT_2bit, (char *)dst_buf);
 }
 
 
@@ -171,11 +136,8 @@ void simple_rf_convert_8bit(uint8_t *src_buf, uint8_t *dst_buf)
 // This is needed to check data loss in USB stream
 uint32_t simple_rf_check_markers(uint8_t *data, int length)
 {
-	static uint8_t state_cnt = 0;
-	static uint8_t expected_byte = 0xAA;
+	simplerf_t *rf = SIMPLERF;
 	const uint8_t expected_table[4] = { 0xAA, 0xBB, 0xCC, 0xDD }; //Marker is 5 bytes, repeated every 10000 bytes. Fifth byte is marker ID
-	static UINT64 simple_rf_prev_marker = 0;
-	static uint8_t prev_packet_id = 0;
 
 	//Error bytes counter
 	uint32_t total_diff = 0;
@@ -184,13 +146,13 @@ uint32_t simple_rf_check_markers(uint8_t *data, int length)
 	for (int i = 0; i < length; i++)
 	{
 		curr_byte = data[i];
-		simple_rf_test_rx_cnt++;
+		rf->rx_cnt++;
 
-		if (curr_byte == expected_byte)
+		if (curr_byte == rf->expected_byte)
 		{
-			state_cnt++;
-			expected_byte = expected_table[state_cnt];
-			if (state_cnt >= 4)
+			rf->state_cnt++;
+			rf->expected_byte = expected_table[rf->state_cnt];
+			if (rf->state_cnt >= 4)
 			{
 				uint8_t packet_id = 0;
 				if ((i + 1) >= length)
@@ -198,23 +160,23 @@ uint32_t simple_rf_check_markers(uint8_t *data, int length)
 				else
 					packet_id = data[i + 1];
 
-				state_cnt = 0;
-				expected_byte = 0xAA;
-				simple_rf_marker_counter++;
-				UINT64 length_diff = simple_rf_test_rx_cnt - simple_rf_prev_marker;
-				simple_rf_prev_marker = simple_rf_test_rx_cnt;
+				rf->state_cnt = 0;
+				rf->expected_byte = 0xAA;
+				rf->marker_counter++;
+				UINT64 length_diff = rf->rx_cnt - rf->prev_marker;
+				rf->prev_marker = rf->rx_cnt;
 
-				if ((length_diff != 10000) && (simple_rf_marker_counter > 5))
+				if ((length_diff != 10000) && (rf->marker_counter > 5))
 				{
 					//error, data loss
-					simple_rf_test_marker_err_cnt++;
+					rf->marker_err_cnt++;
 					char textBuf[100];
-					sprintf(textBuf, "ERROR: %llu | %d | %d", length_diff, prev_packet_id, packet_id);
+					sprintf(textBuf, "ERROR: %llu | %d | %d", length_diff, rf->prev_packet_id, packet_id);
 					String^ clistr = gcnew String(textBuf);
 					System::Diagnostics::Debug::WriteLine(clistr);
 					//System::Diagnostics::Debug::WriteLine("MARKER ERROR\n");
 
-					uint8_t diff_packet = packet_id - prev_packet_id;
+					uint8_t diff_packet = packet_id - rf->prev_packet_id;
 					if (diff_packet != 1)
 					{
 						System::Diagnostics::Debug::WriteLine(">>>BIG ERR");
@@ -222,7 +184,7 @@ uint32_t simple_rf_check_markers(uint8_t *data, int length)
 
 					if ((length_diff < 6000) || (length_diff > 13000))
 					{
-						UINT64 countM = simple_rf_test_rx_cnt / (1024 * 1024); //value in MB
+						UINT64 countM = rf->rx_cnt / (1024 * 1024); //value in MB
 						sprintf(textBuf, "COUNT: %llu M\n", countM);
 						clistr = gcnew String(textBuf);
 						System::Diagnostics::Debug::WriteLine(clistr);
@@ -233,20 +195,20 @@ uint32_t simple_rf_check_markers(uint8_t *data, int length)
 
 					//MessageBeep(MB_ICONEXCLAMATION);
 				}
-				prev_packet_id = packet_id;
+				rf->prev_packet_id = packet_id;
 			}
 		}
 		else
 		{
 			if (curr_byte == 0xAA)
 			{
-				state_cnt = 1;
-				expected_byte = 0xBB;
+				rf->state_cnt = 1;
+				rf->expected_byte = 0xBB;
 			}
 			else
 			{
-				state_cnt = 0;
-				expected_byte = 0xAA;
+				rf->state_cnt = 0;
+				rf->expected_byte = 0xAA;
 			}
 		}
 	}
@@ -259,12 +221,12 @@ uint32_t simple_rf_check_markers(uint8_t *data, int length)
 /* push data to memory buffer --------------------------------------------------
 * copy data to internal local buffer from front end buffer
 * args   : none
-* return : none
+* return : int                  status 0:okay
+* note : short read of front end is counted as buffer overrun
 *-----------------------------------------------------------------------------*/
 extern int simple_rf_pushtomembuf(void)
 {
-	bool b_overrun = false;
-	static uint32_t prev_diff_bytes = 0;
+	simplerf_t *rf = SIMPLERF;
 
 	//One USB byte is 4 ADC samples
 	uint8_t tmp_usb_buf[SIMPLE_RF_BUFFSIZE / 4 ];
@@ -273,34 +235,37 @@ extern int simple_rf_pushtomembuf(void)
 
 
 	int bytes_to_read = SIMPLE_RF_BUFFSIZE / 4;
-	if (prev_diff_bytes > 0)
+	if (rf->prev_diff_bytes > 0)
 	{
-		bytes_to_read -= prev_diff_bytes;
-		read_ptr += prev_diff_bytes;
+		bytes_to_read -= rf->prev_diff_bytes;
+		read_ptr += rf->prev_diff_bytes;
 	}
-	int read_bytes = fx2_d2.read_IF_simple(read_ptr, bytes_to_read);
+	int read_bytes = rf->fx2.read_IF_simple(read_ptr, bytes_to_read);
 
 	
 	uint32_t diff_bytes = simple_rf_check_markers(tmp_usb_buf, SIMPLE_RF_BUFFSIZE / 4);
-	prev_diff_bytes = diff_bytes;
+	rf->prev_diff_bytes = diff_bytes;
 
 	if (read_bytes == bytes_to_read)
 	{
 		simple_rf_convert_8bit(tmp_usb_buf, extracted_buf);
 		mlock(hbuffmtx);
-		uint8_t *dst_p = &sdrstat.buff[(sdrstat.buffcnt % MEMBUFFLEN) * simple_rf_read_buf_size];
+		uint8_t *dst_p = &sdrstat.buff[(sdrstat.buffcnt & sdrstat.nblkmask) * sdrstat.fendbuffsize];
 		memcpy(dst_p, extracted_buf, SIMPLE_RF_BUFFSIZE);
 		unmlock(hbuffmtx);
 	}
     
     if (read_bytes != bytes_to_read)
 	{
-        SDRPRINTF("Simple frontend read IF error...\n");
+        sdrstat.noverrun++;
+        SDRPRINTF("Simple frontend read IF error (%.0f)\n",
+            (double)sdrstat.noverrun);
     }
 
     mlock(hreadmtx);
     sdrstat.buffcnt++;
     unmlock(hreadmtx);
+    teepush(); /* tee recording */
 
     return 0;
 }
@@ -315,12 +280,12 @@ extern void simple_rf_file_pushtomembuf(void)
 
     mlock(hbuffmtx);
 
-    nread=fread(&sdrstat.buff[(sdrstat.buffcnt%MEMBUFFLEN)*simple_rf_read_buf_size],
-        1, simple_rf_read_buf_size,sdrini.fp1);
+    nread=fread(&sdrstat.buff[(sdrstat.buffcnt&sdrstat.nblkmask)*sdrstat.fendbuffsize],
+        1, sdrstat.fendbuffsize,sdrini.fp1);
 
     unmlock(hbuffmtx);
 
-    if (nread < simple_rf_read_buf_size) 
+    if (nread < sdrstat.fendbuffsize) 
 	{
         sdrstat.stopflag=ON;
         SDRPRINTF("end of file!\n");
@@ -340,11 +305,11 @@ extern void simple_rf_file_pushtomembuf(void)
 *-----------------------------------------------------------------------------*/
 extern void simple_rf_getbuf_file(uint64_t buffloc, int n, int dtype, char *expbuf)
 {
-    uint64_t membuffloc=dtype*buffloc%(MEMBUFFLEN*dtype*simple_rf_read_buf_size);
+    uint64_t membuffloc=dtype*buffloc%(sdrstat.nblk*dtype*sdrstat.fendbuffsize);
     int nout;
 
     n=dtype * n;
-    nout=(int)((membuffloc+n)-(MEMBUFFLEN*dtype*simple_rf_read_buf_size));
+    nout=(int)((membuffloc+n)-(sdrstat.nblk*dtype*sdrstat.fendbuffsize));
 
     mlock(hbuffmtx);
     if (nout>0) {
@@ -355,9 +320,3 @@ extern void simple_rf_getbuf_file(uint64_t buffloc, int n, int dtype, char *expb
     }
     unmlock(hbuffmtx);
 }
-
-//Expected, that we get "buf_size" samples per one transfer
-extern void simple_rf_set_rx_buf(uint32_t buf_size)
-{
-	simple_rf_read_buf_size = buf_size;
-}
@@ -12,8 +12,6 @@ extern void simple_rf_quit(void);
 
 extern int simple_rf_pushtomembuf(void);
 extern void simple_rf_getbuf_file(uint64_t buffloc, int n, int dtype, char *expbuf);
-extern void simple_rf_getbuf(uint64_t buffloc, int n, int dtype, char *expbuf);
 
-extern void simple_rf_set_rx_buf(uint32_t buf_size);
 /* global functions */
 
@@ -40,8 +40,7 @@ extern int rtlsdr_init(void);
 extern void rtlsdr_quit(void);
 extern int rtlsdr_initconf(void);
 extern int rtlsdr_start(void);
-extern void rtlsdr_exp(uint8_t *buf, int n, char *expbuf);
-extern void rtlsdr_getbuff(uint64_t buffloc, int n, char *expbuf);
+extern void rtlsdr_exp(const uint8_t *buf, int n, char *expbuf);
 extern void frtlsdr_pushtomembuf(void);
 extern void rtlsdr_set_rx_buf(uint32_t buf_size);
 /*----------------------------------------------------------------------------*/
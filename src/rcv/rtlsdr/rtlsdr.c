@@ -5,7 +5,7 @@
 *-----------------------------------------------------------------------------*/
 #include "../../../src/sdr.h"
 
-static rtlsdr_dev_t *dev=NULL;
+#define RTLDEV ((rtlsdr_dev_t *)sdrstat.dev) /* device of current receiver */
 
 static uint32_t rtlsdr_read_buf_size = 0;
 
@@ -14,17 +14,27 @@ static uint32_t rtlsdr_read_buf_size = 0;
 *-----------------------------------------------------------------------------*/
 void stream_callback_rtlsdr(unsigned char *buf, uint32_t len, void *ctx)
 {
-    /* copy stream data to global buffer */
+    static SDRTLS int rtinit=0; /* per callback thread */
+
+    sdrbindrcv((sdrrcv_t *)ctx); /* receiver context of device */
+
+    /* real-time priority and cpu affinity of callback thread */
+    if (!rtinit) {
+        sdrrtthread(RT_GRAB);
+        rtinit=1;
+    }
+    /* expand stream data to memory buffer (int8 I/Q) */
     mlock(hbuffmtx);
-    memcpy(&sdrstat.buff[(sdrstat.buffcnt%MEMBUFFLEN)*2*RTLSDR_DATABUFF_SIZE],
-        buf,2*RTLSDR_DATABUFF_SIZE);
+    rtlsdr_exp(buf,2*RTLSDR_DATABUFF_SIZE,(char *)&sdrstat.buff[
+        (sdrstat.buffcnt&sdrstat.nblkmask)*2*RTLSDR_DATABUFF_SIZE]);
     unmlock(hbuffmtx);
 
     mlock(hreadmtx);
     sdrstat.buffcnt++;
     unmlock(hreadmtx);
+    teepush(); /* tee recording */
 
-    if (sdrstat.stopflag) rtlsdr_cancel_async(dev);
+    if (sdrstat.stopflag) rtlsdr_cancel_async(RTLDEV);
 }
 /* rtlsdr initialization -------------------------------------------------------
 * search front end and initialization
@@ -33,11 +43,19 @@ void stream_callback_rtlsdr(unsigned char *buf, uint32_t len, void *ctx)
 *-----------------------------------------------------------------------------*/
 extern int rtlsdr_init(void) 
 {
+    rtlsdr_dev_t *rtldev=NULL;
     int ret,dev_index=0;;
+    char devstr[64]="0";
 
     /* open rtlsdr */
-    dev_index=verbose_device_search("0");
-    ret=rtlsdr_open(&dev, (uint32_t)dev_index);
+    if (sdrini.fenddev[0]) strcpy(devstr,sdrini.fenddev);
+    dev_index=verbose_device_search(devstr);
+    if (dev_index<0) {
+        SDRPRINTF("error: rtlsdr device not found: %s\n",sdrini.fenddev);
+        return -1;
+    }
+    ret=rtlsdr_open(&rtldev, (uint32_t)dev_index);
+    sdrstat.dev=rtldev;
     if (ret<0) {
         SDRPRINTF("error: failed to open rtlsdr device #%d.\n",dev_index);
         return -1;
@@ -59,8 +77,9 @@ extern int rtlsdr_init(void)
 *-----------------------------------------------------------------------------*/
 extern void rtlsdr_quit(void) 
 {
-    rtlsdr_cancel_async(dev);
-    rtlsdr_close(dev);
+    rtlsdr_cancel_async(RTLDEV);
+    rtlsdr_close(RTLDEV);
+    sdrstat.dev=NULL;
 }
 /* rtlsdr configuration function -----------------------------------------------
 * load configuration file and setting
@@ -72,28 +91,28 @@ extern int rtlsdr_initconf(void)
     int ret;
     
     /* Set the sample rate */
-    ret=verbose_set_sample_rate(dev,RTLSDR_SAMPLE_RATE);
+    ret=verbose_set_sample_rate(RTLDEV,RTLSDR_SAMPLE_RATE);
     if (ret<0) {
         SDRPRINTF("error: failed to set samplerate\n");
         return -1;
     }
 
     /* Set the frequency */
-    ret=verbose_set_frequency(dev,RTLSDR_FREQUENCY);
+    ret=verbose_set_frequency(RTLDEV,RTLSDR_FREQUENCY);
     if (ret<0) {
         SDRPRINTF("error: failed to set frequency\n");
         return -1;
     }
 
     /* Enable automatic gain */
-    ret=verbose_auto_gain(dev);
+    ret=verbose_auto_gain(RTLDEV);
     if (ret<0) {
         SDRPRINTF("error: failed to set automatic gain\n");
         return -1;
     }
 
     /* set ppm offset */
-    ret=verbose_ppm_set(dev,sdrini.rtlsdrppmerr);
+    ret=verbose_ppm_set(RTLDEV,sdrini.rtlsdrppmerr);
     if (ret<0) {
         SDRPRINTF("error: failed to set ppm\n");
         return -1;
@@ -111,15 +130,15 @@ extern int rtlsdr_start(void)
     int ret;
     
     /* reset endpoint before we start reading from it (mandatory) */
-    ret=verbose_reset_buffer(dev);
+    ret=verbose_reset_buffer(RTLDEV);
     if (ret<0) {
         SDRPRINTF("error: failed to reset buffers\n");
         return -1;
     }
 
     /* start stream and stay there until we kill the stream */
-    ret=rtlsdr_read_async(dev,stream_callback_rtlsdr,
-        NULL,RTLSDR_ASYNC_BUF_NUMBER,2*rtlsdr_read_buf_size);
+    ret=rtlsdr_read_async(RTLDEV,stream_callback_rtlsdr,
+        sdrcur,RTLSDR_ASYNC_BUF_NUMBER,2*rtlsdr_read_buf_size);
 
     if (ret<0&&!sdrstat.stopflag) {
         SDRPRINTF("error: failed to read in async mode\n");
@@ -129,42 +148,15 @@ extern int rtlsdr_start(void)
     return 0;
 }
 /* data expansion --------------------------------------------------------------
-* get current data buffer from memory buffer
-* args   : int16_t *buf     I   bladeRF raw buffer
-*          int    n         I   number of grab data
-*          char   *expbuf   O   extracted data buffer
-* return : none
-*-----------------------------------------------------------------------------*/
-extern void rtlsdr_exp(uint8_t *buf, int n, char *expbuf)
-{
-    int i;
-
-    for (i=0;i<n;i++) {
-        expbuf[i]=(char)((buf[i]-127.5)); /* unsigned char to char */
-    }
-}
-/* get current data buffer -----------------------------------------------------
-* get current data buffer from memory buffer
-* args   : uint64_t buffloc I   buffer location
+* expand RTL-SDR raw data (offset binary) to int8 data at ingest
+* args   : uint8_t *buf     I   RTL-SDR raw buffer
 *          int    n         I   number of grab data
-*          char   *expbuf   O   extracted data buffer
+*          char   *expbuf   O   extracted data buffer (buf can be used)
 * return : none
 *-----------------------------------------------------------------------------*/
-extern void rtlsdr_getbuff(uint64_t buffloc, int n, char *expbuf)
+extern void rtlsdr_exp(const uint8_t *buf, int n, char *expbuf)
 {
-    uint64_t membuffloc=2*buffloc%(MEMBUFFLEN*2* rtlsdr_read_buf_size);
-    int nout;
-    n=2*n;
-    nout=(int)((membuffloc+n)-(MEMBUFFLEN*2* rtlsdr_read_buf_size));
-
-    mlock(hbuffmtx);
-    if (nout>0) {
-        rtlsdr_exp(&sdrstat.buff[membuffloc],n-nout,expbuf);
-        rtlsdr_exp(&sdrstat.buff[0],nout,&expbuf[n-nout]);
-    } else {
-        rtlsdr_exp(&sdrstat.buff[membuffloc],n,expbuf);
-    }
-    unmlock(hbuffmtx);
+    convu8(buf,n,expbuf); /* unsigned char to char */
 }
 /* push data to memory buffer --------------------------------------------------
 * push data to memory buffer from binary IF file
@@ -174,18 +166,18 @@ extern void rtlsdr_getbuff(uint64_t buffloc, int n, char *expbuf)
 extern void frtlsdr_pushtomembuf(void) 
 {
     size_t nread;
+    uint8_t *p;
 
     mlock(hbuffmtx);
 
-    nread=fread(
-        &sdrstat.buff[(sdrstat.buffcnt%MEMBUFFLEN)*2* rtlsdr_read_buf_size],
-        1,2* rtlsdr_read_buf_size,sdrini.fp1);
+    p=&sdrstat.buff[(sdrstat.buffcnt&sdrstat.nblkmask)*2* rtlsdr_read_buf_size];
+    nread=fread(p,1,2* rtlsdr_read_buf_size,sdrini.fp1);
+    rtlsdr_exp(p,(int)nread,(char *)p); /* expand in place */
 
     unmlock(hbuffmtx);
 
     if (nread<2* rtlsdr_read_buf_size) {
-        sdrstat.stopflag=ON;
-        SDRPRINTF("end of file!\n");
+        rcveof();
     }
 
     mlock(hreadmtx);
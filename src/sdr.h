@@ -35,6 +35,7 @@
 
 #include <windows.h>
 #include <process.h>
+#include <intrin.h>
 #include <shlwapi.h>
 #include <shlobj.h>
 #include <locale.h>
@@ -126,13 +127,44 @@ extern "C" {
 #define DTYPEIQ       2                /* sampling type: real+imag */
 
 
-//#define MEMBUFFLEN    5000             /* number of temporary buffer */
-#define MEMBUFFLEN    1000             /* number of temporary buffer */
+#define RINGMS        4000             /* default depth of memory buffer (ms) */
+#define RINGMINBLK    16               /* min number of temporary buffer (2^n) */
+#define MEMHDR        4096             /* header of allocated memory buffer */
 
 #define FILE_BUFFSIZE 65536            /* buffer size for post processing */
+#define REPLAYWIN     500              /* default replay window (ms) */
+#define MAXSDRRCV     8                /* max number of receivers in process */
+#define MAPKEEP       100              /* mapped data kept behind channels (ms) */
+#define MAPAHEAD      4                /* min readahead of mapped file (blocks) */
+#define RDDEPTH       16               /* default blocks in flight of reader */
+#define RDALIGN       4096             /* buffer/offset alignment of direct i/o */
+#define MAXFENDREG    16               /* max registered front end drivers */
+#define NET_BUFFSIZE  16384            /* buffer size for network stream */
+#define NETHDRLEN     16               /* frame header length (bytes) */
+#define NETPKTLEN     1408             /* frame payload of replay (bytes) */
+#define NETMAXPKT     65000            /* max frame payload (bytes) */
+#define NETBATCH      32               /* max frames received at once (UDP) */
+#define NETSOCKBUF    8                /* default socket receive buffer (MB) */
+#define NETTIMEOUT    5000             /* timeout of network stream (ms) */
+#define NETP_RTLTCP   0                /* network protocol: rtl_tcp */
+#define NETP_TCP      1                /* network protocol: framed TCP */
+#define NETP_UDP      2                /* network protocol: framed UDP */
+#define PACKID        "GNSSPACK"       /* packed IF file identifier */
+#define PACKVER       1                /* packed IF file format version */
+#define PACKHDRLEN    128              /* packed IF file header length (bytes) */
+#define TEEQUEUE      64               /* default queue length of tee (blocks) */
+#define TEEPOLL       2                /* polling interval of tee writer (ms) */
+#define PVTNX         5                /* number of states of positioning */
+#define OBSQLEN       256              /* default queue of obs output (epochs) */
+#define OBSQBATCH     64               /* max epochs of obs output batch */
+#define OBSQPOLL      5                /* polling interval of obs writer (ms) */
+#define OBSBINID      "GSOB"           /* binary obs record identifier */
+#define OBSBINHDR     16               /* header of binary obs record (bytes) */
+#define OBSBINSAT     24               /* binary obs data of satellite (bytes) */
 
 /* acquisition setting */
 #define NFFTTHREAD    4                /* number of thread for executing FFT */
+#define MAXFFTPLAN    32               /* max number of cached fft plans */
 //#define ACQINTG_L1CA  10               /* number of non-coherent integration */
 #define ACQINTG_L1CA  4               /* number of non-coherent integration */
 #define ACQINTG_G1    10               /* number of non-coherent integration */
@@ -171,6 +203,11 @@ extern "C" {
 #define NAVADDFLEN_SBAS 12             /* additional bits of frame (bits) */
 #define NAVPRELEN_SBAS  16             /* preamble bits length (bits) */
 #define NAVEPHCNT_SBAS  3              /* number of eph. contained frame */
+#define VITTB           64             /* viterbi traceback depth (bits) */
+#define VITBITS         1024           /* viterbi decoded bits ring (bits) */
+#define NAVFRMWORD      ((NAVFLEN_SBAS+NAVADDFLEN_SBAS+31)/32) /* max frame */
+#define NAVQLEN         8              /* navigation decode queue (frames) */
+#define NAVQPOLL        1              /* poll interval of nav decoder (ms) */
 /* GLONASS G1 */
 #define NAVRATE_G1      10             /* length (multiples of ranging code) */
 #define NAVFLEN_G1      200            /* navigation frame data (bits) */
@@ -200,6 +237,8 @@ extern "C" {
 #define PTIMING       68.802           /* pseudo range generation timing (ms) */
 #define OBSINTERPN    80               /* # of obs. stock for interpolation */
 #define SNSMOOTHMS    100              /* SNR smoothing interval (ms) */
+#define SYNCLAG       200              /* max wait for lagging channels (ms) */
+#define SYNCIDLE      100              /* wait of sync thread w/o epoch (ms) */
 
 /* code generation parameter */
 #define MAXGPSSATNO   210              /* max satellite number */
@@ -277,6 +316,17 @@ extern "C" {
 #define LENSBASMSG    32               /* SBAS message length 150/8 (byte) */
 #define LENSBASNOV    80               /* message length in NovAtel format */
 
+/* real-time setting */
+#define RT_MAXCPU     64               /* max cpu number of affinity mask */
+#define RT_FIFO       0                /* scheduling policy: SCHED_FIFO */
+#define RT_RR         1                /* scheduling policy: SCHED_RR */
+#define RT_GRAB       0                /* thread type: data grabber */
+#define RT_CH         1                /* thread type: sdr channel */
+#define RT_SYNC       2                /* thread type: synchronization */
+#define RT_OUT        3                /* thread type: output (tcp/ip) */
+#define RT_PLOT       4                /* thread type: plotting/spectrum */
+#define RT_NTYPE      5                /* number of thread types */
+
 //ephemeris sens deriod in s
 #define EPH_SEND_PERIOD_S	40
 
@@ -293,8 +343,13 @@ extern "C" {
 #define waitevent(f,m) WaitForSingleObject(f,INFINITE)
 #define delevent(f)   CloseHandle(f)
 #define waitthread(f) WaitForSingleObject(f,INFINITE)
-#define cratethread(f,func,arg) (f=(thread_t)_beginthread(func,0,arg))
+#define cratethread(f,func,arg) (f=sdrcratethread(func,arg))
 #define THRETVAL      
+#define SDRTLS        __declspec(thread)
+#define sdrbarrier()  MemoryBarrier()
+#define popcnt64(x)   ((int)(__popcnt((unsigned int)(x))+\
+                       __popcnt((unsigned int)((x)>>32))))
+typedef void (*thrfunc_t)(void *);
 #else
 #define mlock_t       pthread_mutex_t
 #define initmlock(f)  pthread_mutex_init(&f,NULL)
@@ -307,8 +362,12 @@ extern "C" {
 #define waitevent(f,m) pthread_cond_wait(&f,&m)
 #define delevent(f)   pthread_cond_destroy(&f)
 #define waitthread(f) pthread_join(f,NULL)
-#define cratethread(f,func,arg) pthread_create(&f,NULL,func,arg)
+#define cratethread(f,func,arg) (f=sdrcratethread(func,arg))
 #define THRETVAL      NULL
+#define SDRTLS        __thread
+#define sdrbarrier()  __sync_synchronize()
+#define popcnt64(x)   __builtin_popcountll(x)
+typedef void *(*thrfunc_t)(void *);
 #endif
 
 /* type definition -----------------------------------------------------------*/
@@ -317,6 +376,7 @@ typedef fftwf_complex cpx_t; /* complex type for fft */
 /* sdr initialization struct */
 typedef struct {
     int fend;            /* front end type */
+    char inifile[1024];  /* ini file path ("":./gnss-sdrcli.ini) */
     double f_cf[2];      /* center frequency (Hz) */
     double f_sf[2];      /* sampling frequency (Hz) */
     double f_if[2];      /* intermediate frequency (Hz) */
@@ -346,6 +406,12 @@ typedef struct {
     int sbas;            /* SBAS/QZSS L1SAIF output flag */
     int log;             /* tracking log output flag */
     char rinexpath[1024];/* rinex output path */
+    int pvt;             /* single point positioning flag */
+    char pvtfile[1024];  /* solution file ("": off) */
+    double elmask;       /* elevation mask of positioning (deg) */
+    double pvtlat;       /* latency budget of positioning (ms) (0:off) */
+    char obsbin[1024];   /* binary observation file ("": off) */
+    int obsqueue;        /* queue length of observation output (epochs) */
     int rtcmport;        /* rtcm TCP/IP port */
     int lexport;         /* LEX TCP/IP port */
     int sbasport;        /* SBAS/L1-SAIF TCP/IP port */
@@ -356,19 +422,295 @@ typedef struct {
     double trkpllb[2];   /* pll noise bandwidth (Hz) */
     double trkfllb[2];   /* fll noise bandwidth (Hz) */
     int rtlsdrppmerr;    /* clock collection for RTL-SDR */
+    char fenddev[64];    /* RTL-SDR/bladeRF device identifier ("":first) */
+    char nethost[256];   /* host of network stream ("":any for UDP) */
+    int netport;         /* port of network stream */
+    int netproto;        /* protocol of network stream (NETP_???) */
+    int netsockbuf;      /* socket receive buffer of network stream (MB) */
 	int use_restore_acq; /* Restore acqusition */
 	int dispay_track_cycles; /* Display tracking cycles at Monitor page */
+    int rtprio;          /* real-time priority of grabber (0:normal) */
+    int rtchprio;        /* real-time priority of channel threads (0:normal) */
+    int rtpolicy;        /* real-time scheduling policy (RT_FIFO/RT_RR) */
+    int rtmlock;         /* memory lock and pre-fault flag */
+    uint64_t rtcpu[RT_NTYPE]; /* cpu affinity mask of thread types */
+    int replay;          /* flow controlled file replay flag */
+    int replaywin;       /* replay window between reader and channels (ms) */
+    int filemap;         /* memory-mapped IF file input (0:off 1:on) */
+    int filereader;      /* asynchronous IF file reader (0:off 1:on) */
+    int ringms;          /* depth of memory buffer (ms) */
+    int hugepage;        /* huge pages for memory buffer (0:off 1:on) */
+    int readdepth;       /* blocks in flight of file reader */
+    int directio;        /* direct i/o of file reader (0:off 1:on) */
+    char teefile[1024];  /* tee recording file ("": off) */
+    int teebits;         /* bits of tee recording (0:raw int8, 1,2,4,8:packed) */
+    int teequeue;        /* queue length of tee recording (blocks) */
+    double trigsec;      /* length of triggered capture (s) (0:off) */
+    char trigfile[1024]; /* file path prefix of triggered capture */
+    int offline;         /* deterministic offline processing flag */
+    int nworker;         /* number of offline worker threads */
+    uint64_t acqstart[MAXSAT]; /* acquisition start sample (offline mode) */
+    int nchunk;          /* number of chunks of batch mode (0,1:no batch) */
+    int nproc;           /* number of parallel processes of batch mode */
+    double overlap;      /* warm-up overlap of chunks (s) */
+    int ichunk;          /* chunk number of batch process (1-: 0:no batch) */
+    uint64_t fileoff;    /* start offset of IF file (sample) */
+    uint64_t filelen;    /* length of IF file to process (sample, 0:all) */
+    double skew2;        /* sample of FILE2 at start of FILE1 (sample) */
 } sdrini_t;
 
+/* dc-offset estimator struct */
+typedef struct {
+    double dc[2];        /* estimated dc offset {I,Q} */
+    int init;            /* initialized flag */
+} sdrdcoff_t;
+
+/* memory-mapped IF file struct */
+typedef struct {
+    const uint8_t *p;    /* IF data at start offset (NULL: not mapped) */
+    uint64_t size;       /* size of IF data from start offset (bytes) */
+    void *base;          /* base address of mapping */
+    uint64_t len;        /* length of mapping (bytes) */
+    uint64_t skip;       /* start offset in mapping (bytes) */
+    uint64_t ahead;      /* end of prefetched data (bytes from p) */
+    uint64_t drop;       /* end of released data (bytes from p) */
+#ifdef WIN32
+    HANDLE hfile;        /* file handle */
+    HANDLE hmap;         /* file mapping handle */
+#else
+    int fd;              /* file descriptor */
+#endif
+} sdrmap_t;
+
+/* packed IF file header struct */
+typedef struct {
+    int ver;             /* format version */
+    int hdrlen;          /* header length (bytes) */
+    double f_sf;         /* sampling frequency (Hz) */
+    double f_if;         /* intermediate frequency (Hz) */
+    double f_cf;         /* center frequency (Hz) */
+    int dtype;           /* sampling type (DTYPEI or DTYPEIQ, I/Q interleaved) */
+    int bits;            /* bits per data (1,2,4,8) */
+    int blklen;          /* samples per block */
+    uint64_t nsamp;      /* number of samples */
+    uint64_t nblk;       /* number of blocks */
+    uint64_t idxoff;     /* offset of block index (bytes, 0: no index) */
+    char lut[16];        /* decoding table of packed data */
+    char fend[32];       /* front end type */
+} sdrpackhdr_t;
+
+/* packed IF file struct */
+typedef struct {
+    sdrpackhdr_t hdr;    /* header */
+    FILE *fp;            /* file pointer */
+    uint64_t *idx;       /* block index {sample,offset} (2*nblk) */
+    uint64_t nidx;       /* number of block index */
+    uint8_t *buf;        /* packed data buffer */
+    char *tmp;           /* unpacked data buffer of unaligned data */
+    int nbuf;            /* size of buffers (data) */
+    uint64_t pos;        /* position (read: data (I and Q), write: bytes) */
+    int skip;            /* data offset in carried byte (0: byte aligned) */
+    uint8_t carry;       /* carried byte of unaligned data */
+    uint8_t enc[256];    /* encoding table (index: int8 data+128) */
+} sdrpack_t;
+
+/* asynchronous IF file reader struct */
+typedef struct {
+    thread_t hread;      /* reader thread handle */
+    mlock_t mtx;         /* mutex of block counters */
+    event_t filled;      /* block filled event */
+    event_t freed;       /* block consumed event */
+    int depth;           /* blocks in flight (read ahead of head) */
+    int direct;          /* direct i/o flag */
+    int run;             /* reader thread started flag */
+    int blklen[2];       /* block length (bytes) (FILE1/FILE2) */
+    uint64_t off[2];     /* start offset of IF files (bytes) */
+#ifdef WIN32
+    HANDLE hfile[2];     /* file handles */
+#else
+    int fd[2];           /* file descriptors (-1: not opened) */
+#endif
+    volatile uint64_t rdcnt; /* number of blocks read */
+    volatile uint64_t cscnt; /* number of blocks consumed */
+    volatile int eof;    /* end of file reached at last read block */
+    volatile int quit;   /* quit flag */
+} sdrreader_t;
+
+/* tee recording struct */
+typedef struct {
+    thread_t hwrite;     /* writer thread handle */
+    int run;             /* writer thread started flag */
+    volatile int quit;   /* quit flag */
+    uint64_t *q;         /* queue of filled blocks (block number) */
+    int qlen;            /* queue length (power of 2) */
+    int blklen;          /* block length (bytes) */
+    volatile uint64_t wp; /* write pointer of queue (ingest) */
+    volatile uint64_t rp; /* read pointer of queue (writer) */
+    volatile uint64_t trig; /* triggered head block+1 (0: no trigger) */
+    thread_t hcap;       /* triggered capture thread handle */
+    int caprun;          /* capture thread started flag */
+    volatile int capdone; /* capture thread finished flag */
+    uint64_t ndrop;      /* number of dropped blocks (queue full) */
+    uint64_t nlate;      /* number of blocks overwritten before write */
+    uint64_t nwrite;     /* number of written blocks */
+    uint64_t nerr;       /* number of write errors */
+    int ntrig;           /* number of triggered captures */
+    sdrpack_t out;       /* output file (hdr.bits=0: raw int8) */
+} sdrtee_t;
+
+/* network stream front end struct */
+typedef struct {
+#ifdef WIN32
+    SOCKET soc;          /* socket */
+#else
+    int soc;             /* socket */
+#endif
+    int proto;           /* protocol (NETP_???) */
+    int blklen;          /* block length (bytes) */
+    uint64_t ringlen;    /* memory buffer length (bytes) */
+    uint64_t org;        /* sequence of first data (bytes) */
+    uint64_t wpos;       /* stream position of written data (bytes) */
+    int sync;            /* sequence synchronized flag */
+    int plen;            /* payload length of UDP frames (bytes, 0: unknown) */
+    int eos;             /* end of stream flag */
+    uint8_t *hdr;        /* frame headers of batch (NETBATCH*NETHDRLEN) */
+    char *tmp;           /* payloads of out-of-sequence batch */
+    uint64_t npkt;       /* number of received frames */
+    uint64_t nlost;      /* number of lost frames */
+    uint64_t nlate;      /* number of late or duplicated frames */
+    uint64_t nfill;      /* zero-filled data (bytes) */
+} sdrnet_t;
+
+/* IF data stream struct (FILE2 with own sample clock) */
+typedef struct {
+    int ftype;           /* front end type of stream (FTYPE2) */
+    int dtype;           /* data type (DTYPEI or DTYPEIQ) */
+    double ratio;        /* sampling frequency ratio (stream/FTYPE1) */
+    double frac;         /* fraction of sample at common time origin */
+    int64_t pos;         /* next sample of IF file to read (<0: zero-filled) */
+    int blklen;          /* samples per block */
+    int nblk;            /* blocks of ring (0: memory-mapped file) */
+    uint8_t *buff;       /* ring of stream (sdrstat.buff2) */
+    FILE *fp;            /* IF file */
+    sdrpack_t *pack;     /* packed IF file (NULL: raw int8) */
+    mlock_t mtx;         /* mutex of ring and block counter */
+    thread_t hread;      /* reader thread handle */
+    int sync;            /* synchronous ingest by grabber (offline mode) */
+    int run;             /* reader thread started flag */
+    volatile int quit;   /* quit flag */
+    volatile int eof;    /* end of file reached */
+    volatile uint64_t cnt; /* number of blocks pushed to ring */
+} sdrstrm_t;
+
+/* orbit cache struct of single point positioning */
+typedef struct {
+    uint32_t ephnew;     /* ephemeris counter of channel at load */
+    int sys;             /* navigation system */
+    int valid;           /* valid orbit flag */
+    eph_t eph;           /* broadcast ephemeris */
+    gtime_t toe;         /* time of ephemeris (gpst) */
+    double n;            /* corrected mean motion (rad/s) */
+    double sqe;          /* sqrt(1-e^2) */
+    double omgk;         /* rate of longitude of ascending node (rad/s) */
+    double omg0;         /* longitude of ascending node at toe (rad) */
+    double fr;           /* relativistic clock coefficient (s) */
+} sdrpvtsat_t;
+
+/* position solution struct */
+typedef struct {
+    gtime_t time;        /* time of solution (gpst) */
+    double rr[3];        /* receiver position (ecef) (m) */
+    double pos[3];       /* receiver position {lat,lon,h} (rad,m) */
+    double dtr[PVTNX-3]; /* receiver clock bias {gps,gal} (m) */
+    int ns;              /* number of valid satellites */
+    double gdop;         /* geometric dilution of precision */
+    double latency;      /* latency of solution from signal epoch (s) */
+} sdrsol_t;
+
+/* single point positioning struct */
+typedef struct {
+    sdrpvtsat_t sat[MAXSAT]; /* orbit cache of channels */
+    double x[PVTNX];     /* states of last solution {x,y,z,dtr_gps,dtr_gal} */
+    sdrsol_t sol[2];     /* solution (double buffered) */
+    volatile uint32_t solver; /* version of solution (sol[solver&1]) */
+    FILE *fp;            /* solution file (NULL: not used) */
+    unsigned int tout;   /* tick of last console output (ms) */
+    uint64_t nsol;       /* number of solutions */
+    uint64_t nfail;      /* number of failed epochs */
+    uint64_t nover;      /* number of solutions over latency budget */
+    double latsum,latmax; /* sum and max of latency (s) */
+    double tcsum,tcmax;  /* sum and max of computation time (us) */
+} sdrpvt_t;
+
+/* observation output queue struct */
+typedef struct {
+    int qlen;            /* queue length (epochs) */
+    int nmax;            /* max observation data per epoch */
+    obsd_t *obs;         /* observation data of queue (qlen x nmax) */
+    int *n;              /* number of observation data of queue epochs */
+    unsigned long *tick; /* push time of queue epochs (us) */
+    volatile uint64_t wp; /* write pointer of queue (sync thread) */
+    volatile uint64_t rp; /* read pointer of queue (writer thread) */
+    uint8_t *buff;       /* batch buffer of binary records */
+    FILE *fp;            /* binary observation file (NULL: off) */
+    char *rnxfile;       /* rinex observation file (NULL: off) */
+    rnxopt_t *opt;       /* rinex option */
+    thread_t hwrite;     /* writer thread handle */
+    int run;             /* writer thread started flag */
+    volatile int quit;   /* quit flag */
+    uint64_t nepoch;     /* number of written epochs */
+    uint64_t nbatch;     /* number of batches */
+    uint64_t ndrop;      /* number of dropped epochs (queue full) */
+    uint64_t nerr;       /* number of write errors */
+    double latmax;       /* max latency from push to write (us) */
+} sdrobsq_t;
+
+/* front end data format struct */
+typedef struct {
+    int nbuf;            /* number of memory buffers (FTYPE1 or FTYPE1/2) */
+    int dtype[2];        /* data type of memory buffers (DTYPEI/DTYPEIQ) */
+    int blklen[2];       /* samples per block */
+    int nblk[2];         /* blocks of memory buffer (0: lent from file) */
+    int zerocopy;        /* spans are lent without copy (except wrap) */
+} sdrfmt_t;
+
+/* front end driver struct */
+typedef struct {
+    const char *name;    /* type name (TYPE in front end ini file) */
+    int type;            /* front end type (FEND_???) */
+    int file;            /* file input flag */
+    int (*init)(sdrini_t *ini);  /* open and allocate memory buffer */
+    int (*start)(sdrini_t *ini); /* push data to memory buffer (grabber) */
+    void (*stop)(sdrini_t *ini); /* close (NULL: none) */
+    const char *(*span)(sdrini_t *ini, uint64_t buffloc, int n, int ftype,
+                        int dtype, char *expbuf); /* borrow span of data */
+    void (*format)(sdrini_t *ini, sdrfmt_t *fmt); /* data format (NULL: ring) */
+    void (*stats)(sdrini_t *ini); /* print statistics (NULL: none) */
+} sdrfend_t;
+
 /* sdr current state struct */
 typedef struct {
     int stopflag;        /* stop flag */
     int specflag;        /* spectrum flag */
     int buffsize;        /* data buffer size */
     int fendbuffsize;    /* front end data buffer size */
+    int nblk;            /* number of blocks in memory buffer (power of 2) */
+    int nblkmask;        /* block index mask of memory buffer (nblk-1) */
     unsigned char *buff; /* IF data buffer, raw data from the frontend get here */
     unsigned char *buff2;/* IF data buffer (for file input) */
     uint64_t buffcnt;    /* current buffer location, incremented when one "packet" is received from radio or read from file */
+    uint64_t noverrun;   /* number of front end buffer overruns */
+    void *dev;           /* front end device handle */
+    sdrmap_t map[2];     /* memory-mapped IF files (FILE1/FILE2) */
+    sdrdcoff_t dcoff;    /* dc-offset estimator of front end */
+    sdrreader_t *rd;     /* asynchronous IF file reader (NULL: not used) */
+    sdrpack_t pack[2];   /* packed IF files (FILE1/FILE2, bits=0: raw) */
+    sdrtee_t *tee;       /* tee recording (NULL: not used) */
+    sdrnet_t *net;       /* network stream front end (NULL: not used) */
+    sdrstrm_t *strm;     /* stream of FILE2 (NULL: not used) */
+    sdrpvt_t *pvt;       /* single point positioning (NULL: not used) */
+    sdrobsq_t *obsq;     /* observation output queue (NULL: not used) */
+    const sdrfend_t *fend; /* front end driver */
 } sdrstat_t;
 
 /* sdr observation struct */
@@ -398,6 +740,8 @@ typedef struct {
     double peakr;        /* first/second peak ratio */
 	double peakr_max;    /* first/second peak ratio - internal value*/
 	double peakr_max_fin; /* first/second peak ratio - final value*/
+    int flagrun;         /* acquisition running flag */
+    uint64_t acqloc;     /* acquisition buffer location (offline mode) */
 } sdracq_t;
 
 /* sdr tracking parameter struct */
@@ -412,6 +756,30 @@ typedef struct {
     double fllw;         /* FLL coefficient */
 } sdrtrkprm_t;
 
+/* sdr observation history struct (ring buffers, structure of arrays) */
+typedef struct {
+    volatile uint32_t seq; /* seqlock sequence (odd:being updated) */
+    int head;            /* ring index of newest data */
+    int epoch;           /* output epoch of newest tow (OUTMS) */
+    double tow[OBSINTERPN]; /* time of week (s) */
+    uint64_t codei[OBSINTERPN]; /* code phase (sample) */
+    uint64_t cntout[OBSINTERPN]; /* loop counter */
+    double remcout[OBSINTERPN]; /* remained code phase (chip)*/
+    double L[OBSINTERPN];/* carrier phase (cycle) */
+    double D[OBSINTERPN];/* doppler frequency (Hz) */
+} sdrobsh_t;
+
+/* sdr tracking snapshot struct (published by tracking thread) */
+typedef struct {
+    double tow;          /* time of week of newest observation (s) */
+    uint64_t codei;      /* code phase of newest observation (sample) */
+    uint64_t cntout;     /* loop counter of newest observation */
+    double L;            /* carrier phase (cycle) */
+    double D;            /* doppler frequency (Hz) */
+    double S;            /* signal to noise ratio (dB-Hz) */
+    double Isum;         /* correlation for SNR computation (I-phase) */
+} sdrtrksnap_t;
+
 /* sdr tracking struct */
 typedef struct {
     double codefreq;     /* code frequency (Hz), variable. Initialized with "crate" value*/
@@ -426,14 +794,12 @@ typedef struct {
     double carrPhaseErr;      /* carrier tracking error */
     double freqErr;      /* frequencyr error in FLL */
     uint64_t buffloc;    /* current buffer location */
-    double tow[OBSINTERPN]; /* time of week (s) */
-    uint64_t codei[OBSINTERPN]; /* code phase (sample) */
+    sdrobsh_t obsh;      /* observation history (ring) */
+    int snri;            /* ring index of newest SNR */
     uint64_t codeisum[OBSINTERPN]; /* code phase for SNR computation (sample) */
-    uint64_t cntout[OBSINTERPN]; /* loop counter */
-    double remcout[OBSINTERPN]; /* remained code phase (chip)*/
-    double L[OBSINTERPN];/* carrier phase (cycle) */
-    double D[OBSINTERPN];/* doppler frequency (Hz) */
-    double S[OBSINTERPN];/* signal to noise ratio (dB-Hz) */
+    double S[OBSINTERPN];/* signal to noise ratio (dB-Hz) (ring) */
+    sdrtrksnap_t snap[2]; /* snapshot (double buffered) */
+    volatile uint32_t snapver; /* version of snapshot (snap[snapver&1]) */
     double *II;          /* correlation (in-phase) results array */
     double *QQ;          /* correlation (quadrature-phase) results array*/
     double *oldI;        /* previous correlation (I-phase) */
@@ -487,6 +853,15 @@ typedef struct {
 	time_t timestamp_subfrm5;
 } sdreph_t;
 
+/* sdr sliding window viterbi decoder struct (K=7,R=1/2) */
+typedef struct {
+    uint32_t metric[64]; /* path metrics */
+    uint64_t dec[VITTB]; /* decisions ring (bit i: decision of state i) */
+    uint32_t bits[VITBITS/32]; /* decoded bits ring (bit packed, 1:+1 0:-1) */
+    uint64_t n;          /* number of decoded steps (symbol pairs) */
+    uint64_t sym;        /* frame symbol index of next pair end */
+} sdrvit_t;
+
 /* sdr LEX struct */
 typedef struct {
     unsigned char msg[LENLEXMSG]; /* LEX message (250bytes/s) */
@@ -509,15 +884,22 @@ typedef struct {
     int flen;            /* frame length (bits) */
     int addflen;         /* additional frame bits (bits). Static*/
     int prebits[32];     /* preamble bits. Static */
+    uint64_t prepack;    /* packed preamble bits (bit i:prebits[i]>0) */
     int prelen;          /* preamble bits length (bits) */
     int bit;             /* current navigation bit */
     int biti;            /* current navigation bit index */
     int cnt;             /* navigation bit counter for synchronization */
     double bitIP;        /* current navigation bit (IP data) */
-    int *fbits;          /* frame bits */
-    int *fbitsdec;       /* decoded frame bits */
+    uint32_t *fring;     /* frame bit ring (bit packed, 1:+1 0:-1) */
+    int fmask;           /* frame bit ring mask (ring length (bits)-1) */
+    uint64_t fhead;      /* frame bit ring head (number of pushed bits) */
+    uint64_t fview;      /* ring head of linearized frame bits */
+    int *fbitsdec;       /* decoded frame bits (linearized view) */
     int update;          /* decode interval (ms) */
     int *bitsync;        /* frame bits synchronization count */
+    uint32_t nhreg;      /* last bit signs for NH20 sync (bit0:latest) */
+    uint32_t nhcode;     /* NH20 code signs (bit0:last chip) */
+    int nhcnt;           /* number of bit signs in nhreg */
     int synci;           /* frame bits synchronization index */
     uint64_t firstsf;    /* first subframe location (sample) */
     uint64_t firstsfcnt; /* first subframe count */
@@ -525,6 +907,12 @@ typedef struct {
     int polarity;        /* bit polarity */
     int flagpol;         /* bit polarity flag (only used in L1-SAIF) */
     void *fec;           /* FEC (fec.h)  */
+    sdrvit_t *vit;       /* sliding window decoders (SBAS, symbol phase) */
+    struct sdrnavq_tag *q; /* navigation decode queue */
+    int gen;             /* generation of frame synchronization */
+    volatile uint32_t ephver; /* version of sdreph (odd:being updated) */
+    volatile uint32_t ephnew; /* number of completed ephemeris */
+    uint32_t ephout;     /* number of output ephemeris */
     short *ocode;        /* overlay code (secondary code) */
     int ocodei;          /* current overray code index */
     int swsync;          /* switch of frame synchronization (last nav bit) */
@@ -539,9 +927,39 @@ typedef struct {
     sdrsbas_t sbas;      /* SBAS message struct */
 } sdrnav_t;
 
+/* sdr navigation frame snapshot struct */
+typedef struct {
+    uint32_t bits[NAVFRMWORD]; /* frame bits (bit packed, 1:+1, bit0:oldest) */
+    uint64_t cnt;        /* channel counter at end of frame */
+    int polarity;        /* bit polarity */
+    int first;           /* first frame after frame synchronization */
+    int gen;             /* generation of frame synchronization */
+} sdrnavfrm_t;
+
+/* sdr navigation decode result struct */
+typedef struct {
+    uint64_t cnt;        /* channel counter at end of frame */
+    int first;           /* first frame after frame synchronization */
+    int gen;             /* generation of frame synchronization */
+    int reset;           /* frame synchronization is lost */
+    int prn;             /* decoded PRN (GLONASS) */
+    double tow;          /* decoded tow (s) (0:not decoded) */
+} sdrnavres_t;
+
+/* sdr navigation decode queue struct */
+typedef struct sdrnavq_tag {
+    sdrnavfrm_t frm[NAVQLEN]; /* frame queue (tracking->decoder) */
+    volatile uint64_t wp,rp; /* write/read pointer of frame queue */
+    sdrnavres_t res[NAVQLEN]; /* result queue (decoder->tracking) */
+    volatile uint64_t rwp,rrp; /* write/read pointer of result queue */
+    uint64_t ndrop;      /* number of dropped frames (queue full) */
+    sdrnav_t dec;        /* navigation struct of decoder */
+} sdrnavq_t;
+
 /* sdr channel struct */
 typedef struct {
     thread_t hsdr;       /* thread handle */
+    struct sdrrcv_tag *rcv; /* receiver context of channel */
     int no;              /* channel number */
     int sat;             /* satellite number */
     int sys;             /* satellite system */
@@ -594,6 +1012,51 @@ typedef struct {
     double pltms;        /* plot interval (ms) */
 } sdrplt_t;
 
+/* sdr channel processing state struct */
+typedef struct {
+    sdrplt_t pltacq;     /* plot struct for acquisition */
+    sdrplt_t plttrk;     /* plot struct for tracking */
+    uint64_t cnt;        /* tracking counter (code periods) */
+    uint64_t buffloc;    /* current buffer location (sample) */
+    uint64_t bufflocnow; /* head buffer location at tracking (sample) */
+    uint64_t loopcnt;    /* loop filter counter */
+    double *acqpower;    /* acquisition correlation power */
+    FILE *fp;            /* tracking log file pointer */
+    long long prevsec;   /* previous time of tracking cycles display (s) */
+    uint64_t prevcnt;    /* previous counter of tracking cycles display */
+} sdrproc_t;
+
+/* sdr synchronization struct */
+typedef struct {
+    sdrobsh_t *obsh;     /* copy of observation histories (MAXSAT) */
+    int nsat;            /* number of copied observation histories */
+    int isat[MAXSAT];    /* channel index of copied histories */
+    int week[MAXSAT];    /* gps week of copied histories */
+    double S[MAXSAT];    /* SNR of copied histories (dB-Hz) */
+    double reftow;       /* reference tow of last output (s) */
+    int epoch;           /* next output epoch (tow) (ms) (0:not set) */
+    int npass;           /* channels passed epoch at first pass (0:none) */
+    unsigned int tpass;  /* tick of first pass of epoch (ms) */
+    int lag[MAXSAT];     /* lagging channels excluded from epoch wait */
+    int hint[MAXSAT];    /* ring index of last interpolation bracket */
+} sdrsync_t;
+
+/* sdr offline worker struct */
+typedef struct {
+    thread_t hwork;      /* worker thread handle */
+    int no;              /* worker number (0:main thread) */
+    int nch;             /* number of assigned channels */
+    int ich[MAXSAT];     /* assigned channel index */
+    sdrproc_t *proc;     /* channel processing state structs (all channels) */
+    uint64_t lim;        /* processing limit of buffer location (sample) */
+    mlock_t mtx;         /* mutex of start/done flag */
+    event_t start;       /* start event */
+    event_t done;        /* done event */
+    volatile int round;  /* requested round number */
+    volatile int ndone;  /* finished round number */
+    volatile int quit;   /* quit flag */
+} sdrworker_t;
+
 /* sdr socket struct */
 typedef struct {
     thread_t hsoc;       /* thread handle */
@@ -629,24 +1092,49 @@ typedef struct {
     sdrplt_t pspec;      /* plot struct for spectrum analysis */
 } sdrspec_t;
 
+/* sdr receiver context struct */
+typedef struct sdrrcv_tag {
+    int no;              /* receiver number (0:default receiver) */
+    sdrini_t ini;        /* sdr initialization struct */
+    sdrstat_t stat;      /* sdr state struct */
+    sdrch_t ch[MAXSAT];  /* sdr channel structs */
+    sdrspec_t spec;      /* sdr spectrum analyzer struct */
+    sdrout_t out;        /* sdr output struct */
+    thread_t hsync;      /* synchronization thread handle */
+    thread_t hspec;      /* spectrum analyzer thread handle */
+    thread_t hdec;       /* navigation decoder thread handle */
+    mlock_t buffmtx;     /* buffer access mutex */
+    mlock_t readmtx;     /* buffloc access mutex */
+    mlock_t obsmtx;      /* observation epoch event mutex */
+    mlock_t lexmtx;      /* QZSS LEX mutex */
+    event_t lexeve;      /* QZSS LEX event */
+    event_t obseve;      /* observation epoch event */
+} sdrrcv_t;
+
 /* global variables ----------------------------------------------------------*/
 extern thread_t hmainthread;  /* main thread handle */
-extern thread_t hsyncthread;  /* synchronization thread handle */
-extern thread_t hspecthread;  /* spectrum analyzer thread handle */
 extern thread_t hkeythread;   /* keyboard thread handle */
-extern mlock_t hbuffmtx;      /* buffer access mutex */
-extern mlock_t hreadmtx;      /* buffloc access mutex */
-extern mlock_t hfftmtx;       /* fft function mutex */
-extern mlock_t hpltmtx;       /* plot function mutex */
-extern mlock_t hobsmtx;       /* observation data access mutex */
-extern mlock_t hlexmtx;       /* QZSS LEX mutex */
-extern event_t hlexeve;       /* QZSS LEX event */
-
-extern sdrini_t sdrini;       /* sdr initialization struct */
-extern sdrstat_t sdrstat;     /* sdr state struct */
-extern sdrch_t sdrch[MAXSAT]; /* sdr channel structs */
-extern sdrspec_t sdrspec;     /* sdr spectrum analyzer structs */
-extern sdrout_t sdrout;       /* sdr output structs */
+extern mlock_t hfftmtx;       /* fft function mutex (all receivers) */
+extern mlock_t hpltmtx;       /* plot function mutex (all receivers) */
+
+extern sdrrcv_t sdrrcvdef;      /* default receiver context */
+extern SDRTLS sdrrcv_t *sdrcur; /* receiver context bound to current thread */
+
+/* receiver state (receiver context bound to current thread) */
+#define sdrini      (sdrcur->ini)     /* sdr initialization struct */
+#define sdrstat     (sdrcur->stat)    /* sdr state struct */
+#define sdrch       (sdrcur->ch)      /* sdr channel structs */
+#define sdrspec     (sdrcur->spec)    /* sdr spectrum analyzer struct */
+#define sdrout      (sdrcur->out)     /* sdr output struct */
+#define hsyncthread (sdrcur->hsync)   /* synchronization thread handle */
+#define hspecthread (sdrcur->hspec)   /* spectrum analyzer thread handle */
+#define hdecthread  (sdrcur->hdec)    /* navigation decoder thread handle */
+#define hbuffmtx    (sdrcur->buffmtx) /* buffer access mutex */
+#define hreadmtx    (sdrcur->readmtx) /* buffloc access mutex */
+#define hobsmtx     (sdrcur->obsmtx)  /* observation epoch event mutex */
+#define hlexmtx     (sdrcur->lexmtx)  /* QZSS LEX mutex */
+#define hlexeve     (sdrcur->lexeve)  /* QZSS LEX event */
+#define hobseve     (sdrcur->obseve)  /* observation epoch event */
 
 /* sdrmain.c -----------------------------------------------------------------*/
 #ifdef GUI
@@ -654,9 +1142,12 @@ extern GCHandle hform;
 extern void initsdrgui(maindlg^ form, sdrini_t* sdrinigui);
 extern void startsdr(void *arg);
 #else
-extern void startsdr(void);
+extern void startsdr(sdrrcv_t *rcv);
 #endif
 extern void quitsdr(sdrini_t *ini, int stop);
+extern int initsdrproc(sdrch_t *sdr, sdrproc_t *proc);
+extern int sdrproc(sdrch_t *sdr, sdrproc_t *proc);
+extern void quitsdrproc(sdrch_t *sdr, sdrproc_t *proc);
 #ifdef WIN32
 extern void sdrthread(void *arg);
 #else
@@ -664,12 +1155,62 @@ extern void *sdrthread(void *arg);
 #endif
 
 /* sdrsync.c -----------------------------------------------------------------*/
+extern int initsync(sdrsync_t *sync);
+extern int syncobs(sdrsync_t *sync);
+extern void quitsync(sdrsync_t *sync);
 #ifdef WIN32
 extern void syncthread(void * arg);
 #else
 extern void *syncthread(void * arg);
 #endif
 
+/* sdrconv.c -----------------------------------------------------------------*/
+extern void convu8(const uint8_t *in, int n, char *out);
+extern void convsc16(const uint16_t *in, int n, sdrdcoff_t *dc, char *out);
+extern void convlut(const uint8_t *in, int n, const char *lut, char *out);
+extern void convlutiq(const uint8_t *in, int n, const char *luti,
+                      const char *lutq, char *out);
+extern void conv1bit(const uint8_t *in, int n, char *out);
+extern void conv2bitx4(const uint8_t *in, int n, const char *lut, char *out);
+extern void convunpack(const uint8_t *in, int n, int bits, const char *lut,
+                       char *out);
+extern void convpack(const char *in, int n, int bits, const uint8_t *enc,
+                     uint8_t *out);
+extern int sdrconvbench(void);
+
+/* sdrdec.c ------------------------------------------------------------------*/
+extern int navqinit(sdrnav_t *nav);
+extern void navqfree(sdrnav_t *nav);
+extern void navdecode(sdrch_t *sdr, const sdrnavfrm_t *frm);
+extern void navgeteph(const sdrnav_t *nav, sdreph_t *eph);
+#ifdef WIN32
+extern void decthread(void *arg);
+#else
+extern void *decthread(void *arg);
+#endif
+
+/* sdrfec.c ------------------------------------------------------------------*/
+extern void vitinit(sdrvit_t *vit);
+extern void vitupdate(sdrvit_t *vit, int s0, int s1);
+extern uint64_t vitbits(const sdrvit_t *vit, uint64_t step, int len);
+extern int sdrfecbench(void);
+
+/* sdrctx.c ------------------------------------------------------------------*/
+extern sdrrcv_t *sdrnewrcv(void);
+extern void sdrfreercv(sdrrcv_t *rcv);
+extern void sdrbindrcv(sdrrcv_t *rcv);
+extern void sdrstopall(void);
+extern void sdrinitshared(void);
+extern thread_t sdrcratethread(thrfunc_t func, void *arg);
+extern int sdrwaitevent(event_t *ev, mlock_t *mtx, int ms);
+
+/* sdroffline.c --------------------------------------------------------------*/
+extern int sdroffline(void);
+
+/* sdrbatch.c ----------------------------------------------------------------*/
+extern int sdrbatch(const char *exe);
+extern int sdrbatchchunk(int k);
+
 /* sdracq.c ------------------------------------------------------------------*/
 extern uint64_t sdraccuisition(sdrch_t *sdr, double *power);
 extern int checkacquisition(double *P, sdrch_t *sdr);
@@ -683,6 +1224,12 @@ extern void pll(sdrch_t *sdr, sdrtrkprm_t *prm, double dt);
 extern void dll(sdrch_t *sdr, sdrtrkprm_t *prm, double dt);
 extern void setobsdata(sdrch_t *sdr, uint64_t buffloc, uint64_t cnt, 
                        sdrtrk_t *trk, int flag);
+extern int obsidx(const sdrobsh_t *obsh, int k);
+extern int obsfindtow(const sdrobsh_t *obsh, double tow);
+extern void obsinterp(const sdrobsh_t *obsh, int ftype, double base, double t,
+                      int *hint, double *L, double *D);
+extern void obsgethist(const sdrtrk_t *trk, sdrobsh_t *obsh);
+extern void trkgetsnap(const sdrtrk_t *trk, sdrtrksnap_t *snap);
 
 /* sdrinit.c -----------------------------------------------------------------*/
 extern int readinifile(sdrini_t *ini);
@@ -711,6 +1258,7 @@ extern void *sdrmalloc(size_t size);
 extern void sdrfree(void *p);
 extern cpx_t *cpxmalloc(int n);
 extern void cpxfree(cpx_t *cpx);
+extern fftwf_plan getfftplan(int n, int sign);
 extern void cpxfft(fftwf_plan plan, cpx_t *cpx, int n);
 extern void cpxifft(fftwf_plan plan, cpx_t *cpx, int n);
 extern void cpxcpx(const short *II, const short *QQ, double scale, int n,
@@ -728,6 +1276,7 @@ extern void dot_22(const short *a1, const short *a2, const short *b1,
 extern void dot_23(const short *a1, const short *a2, const short *b1, 
                    const short *b2, const short *b3, int n, double *d1, 
                    double *d2);
+extern void initmixcarr(void);
 extern double mixcarr(const char *data, int dtype, double ti, int n, 
                       double freq, double phi0, short *II, short *QQ);
 extern void mulvcs(const char *data1, const short *data2, int n, short *out);
@@ -751,7 +1300,19 @@ extern void correlator(const char *data, int dtype, double ti, int n,
                        int* s, int ns, double *II, double *QQ, double *remc, 
                        double *remp, short* codein, int coden);
 
+/* sdrrt.c -------------------------------------------------------------------*/
+extern int parsecpulist(const char *str, uint64_t *mask);
+extern int setthreadaffinity(uint64_t mask);
+extern uint64_t getthreadaffinity(void);
+extern int setthreadprio(int policy, int prio);
+extern uint64_t rtcpumask(int type);
+extern int sdrrtthread(int type);
+extern int sdrrtmemlock(void *p, size_t size);
+extern void *sdrmemalloc(size_t size, int huge);
+extern void sdrmemfree(void *p);
+
 /* sdrcode.c -----------------------------------------------------------------*/
+extern void initcodetbl(void);
 extern short *gencode(int prn, int ctype, int *len, double *crate);
 
 /* sdrplot.c -----------------------------------------------------------------*/
@@ -797,7 +1358,7 @@ extern int decode_e1b(sdrnav_t *nav);
 extern int decode_g1(sdrnav_t *nav);
 extern int decode_b1i(sdrnav_t *nav);
 extern int decode_l1sbas(sdrnav_t *nav);
-extern int paritycheck_l1ca(int *bits);
+extern int paritycheck_l1ca(uint32_t w);
 
 /* sdrout.c ------------------------------------------------------------------*/
 extern void createrinexopt(rnxopt_t *opt);
@@ -806,6 +1367,8 @@ extern int createrinexobs(char *file, rnxopt_t *opt);
 extern int writerinexobs(char *file, rnxopt_t *opt, obsd_t *obsd, int ns);
 extern int createrinexnav(char *file, rnxopt_t *opt);
 extern int writerinexnav(char *file, rnxopt_t *opt, sdreph_t *sdreph);
+extern int socketstartup(void);
+extern void socketcleanup(void);
 extern void tcpsvrstart(sdrsoc_t *soc);
 extern void tcpsvrclose(sdrsoc_t *soc);
 extern void sendrtcmnav(sdreph_t *eph, sdrsoc_t *soc);
@@ -816,14 +1379,78 @@ extern FILE* createlog(char *filename, sdrtrk_t *trk);
 extern void closelog(FILE *fp);
 
 /* sdrrcv.c ------------------------------------------------------------------*/
+extern int rcvregister(const sdrfend_t *fend);
+extern const sdrfend_t *rcvfend(const char *name, int type);
+extern void rcvformat(sdrini_t *ini, sdrfmt_t *fmt);
 extern int rcvinit(sdrini_t *ini);
 extern int rcvquit(sdrini_t *ini);
 extern int rcvgrabdata(sdrini_t *ini);
 extern int rcvgetbuff(sdrini_t *ini, uint64_t buffloc, int n, int ftype, 
                       int dtype, char *expbuf);
+extern const char *rcvgetspan(sdrini_t *ini, uint64_t buffloc, int n,
+                              int ftype, int dtype, char *expbuf);
+extern uint64_t rcvheadloc(void);
+extern uint64_t rcvstrmhead(int ftype);
+extern uint64_t rcvringlen(int ftype);
+extern double rcvcomloc(int ftype, double loc);
+extern double rcvstrmloc(int ftype, double com);
+extern void rcvflowctrl(sdrini_t *ini);
+extern void rcvwaitbuff(int ftype, uint64_t buffloc);
+extern void rcveof(void);
 extern void file_pushtomembuf(void);
-extern void file_getbuff(uint64_t buffloc, int n, int ftype, int dtype, 
-                         char *expbuf);
+extern void file_pushtomap(void);
+extern void membuff_getbuff(uint64_t buffloc, int n, int ftype, int dtype,
+                            char *expbuf);
+
+/* sdrread.c -----------------------------------------------------------------*/
+extern int readerinit(sdrini_t *ini);
+extern void readerquit(void);
+extern void file_pushfromreader(void);
+
+/* sdrstrm.c -----------------------------------------------------------------*/
+extern int strminit(sdrini_t *ini);
+extern int strmstart(sdrini_t *ini);
+extern void strmquit(void);
+extern void strmpush(void);
+
+/* sdrpack.c -----------------------------------------------------------------*/
+extern int packreadhdr(const char *file, sdrpackhdr_t *hdr);
+extern int packopen(FILE *fp, sdrpack_t *pk);
+extern int packseek(sdrpack_t *pk, uint64_t samp);
+extern int packread(sdrpack_t *pk, char *out, int n);
+extern void packclose(sdrpack_t *pk);
+extern int packcreate(const char *file, const sdrpackhdr_t *hdr, sdrpack_t *pk);
+extern int packwrite(sdrpack_t *pk, const char *in, int n);
+extern int packfinish(sdrpack_t *pk);
+extern int sdrpackconv(sdrini_t *ini, int ftype, int bits, const char *outfile,
+                       const char *fend);
+
+/* sdrtee.c ------------------------------------------------------------------*/
+extern int teeinit(sdrini_t *ini);
+extern void teequit(void);
+extern void teepush(void);
+extern void teetrigger(void);
+
+/* sdrpvt.c ------------------------------------------------------------------*/
+extern int pvtinit(sdrini_t *ini);
+extern void pvtquit(void);
+extern int pvtsolve(const obsd_t *obs, int n, const int *ich, double comloc);
+extern int pvtgetsol(sdrsol_t *sol);
+
+/* sdrobsq.c -----------------------------------------------------------------*/
+extern int obsqinit(sdrini_t *ini);
+extern void obsqquit(void);
+extern void obsqpush(const obsd_t *obs, int n);
+extern int sdrobsbench(void);
+
+/* sdrnet.c ------------------------------------------------------------------*/
+extern int netprotocol(const char *str);
+extern int netinit(sdrini_t *ini);
+extern void netquit(void);
+extern void netstats(void);
+extern int net_pushtomembuf(void);
+extern int sdrnetserve(sdrini_t *ini, const char *proto, int port,
+                       const char *host, double speed);
 
 /* sdrspec.c -----------------------------------------------------------------*/
 extern void initsdrspecgui(sdrspec_t* sdrspecgui);
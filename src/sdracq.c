@@ -15,14 +15,23 @@ extern uint64_t sdraccuisition(sdrch_t *sdr, double *power)
 {
     int i;
     char *data;
-    uint64_t buffloc;
+    const char *span;
+    uint64_t buffloc,head;
 
     /* memory allocation */
     data=(char*)sdrmalloc(sizeof(char)*2*sdr->nsamp*sdr->dtype);
 
     /* current buffer location */
+    head=rcvstrmhead(sdr->ftype);
     mlock(hreadmtx);
-    buffloc=(sdrstat.fendbuffsize*sdrstat.buffcnt)-(sdr->acq.intg+1)*sdr->nsamp;
+    if (sdrini.offline) {
+        buffloc=sdr->acq.acqloc; /* configured location (offline mode) */
+    }
+    else {
+        buffloc=head-(sdr->acq.intg+1)*sdr->nsamp;
+    }
+    sdr->trk.buffloc=buffloc; /* hold file reader (replay mode) */
+    sdr->acq.flagrun=ON;
     unmlock(hreadmtx);
 
 	sdr->acq.peakr_max = 0.0;
@@ -31,11 +40,12 @@ extern uint64_t sdraccuisition(sdrch_t *sdr, double *power)
     for (i=0; i < sdr->acq.intg; i++) 
 	{
         /* get current 1ms data */
-        rcvgetbuff(&sdrini,buffloc,2*sdr->nsamp,sdr->ftype,sdr->dtype,data);
+        span=rcvgetspan(&sdrini,buffloc,2*sdr->nsamp,sdr->ftype,sdr->dtype,
+            data);
         buffloc+=sdr->nsamp;
 
         /* fft correlation */
-        pcorrelator(data,sdr->dtype,sdr->ti,sdr->nsamp,sdr->acq.freq,
+        pcorrelator(span,sdr->dtype,sdr->ti,sdr->nsamp,sdr->acq.freq,
             sdr->acq.nfreq,sdr->crate,sdr->acq.nfft,sdr->xcode,power);
 
         /* check acquisition result */
@@ -53,6 +63,8 @@ extern uint64_t sdraccuisition(sdrch_t *sdr, double *power)
         sdr->satstr,sdr->acq.cn0,sdr->acq.peakr,sdr->acq.acqcodei,
         sdr->acq.acqfreq - sdr->f_if - sdr->foffset);
 
+    sdr->acq.flagrun=OFF;
+
     /* set acquisition result */
     if (sdr->flagacq) {
         /* set buffer location at top of code */
@@ -60,6 +72,14 @@ extern uint64_t sdraccuisition(sdrch_t *sdr, double *power)
         sdr->trk.carrfreq=sdr->acq.acqfreq;
         sdr->trk.codefreq=sdr->crate;
     }
+    else if (sdrini.offline) {
+        /* next acquisition location (offline mode) */
+        sdr->acq.acqloc+=(uint64_t)(ACQSLEEP*sdr->f_sf/1000);
+    }
+    else if (sdrini.replay) {
+        /* acquisition interval is counted in IF data in replay mode */
+        rcvwaitbuff(sdr->ftype,buffloc+(uint64_t)(ACQSLEEP*sdr->f_sf/1000));
+    }
     else {
         sleepms(ACQSLEEP);
     }
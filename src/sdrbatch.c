@@ -0,0 +1,356 @@
+/*------------------------------------------------------------------------------
+* sdrbatch.c : SDR parallel chunked batch processing functions
+*
+* Copyright (C) 2014 Taro Suzuki <gnsssdrlib@gmail.com>
+*-----------------------------------------------------------------------------*/
+#ifndef WIN32
+#define _FILE_OFFSET_BITS 64
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+#include "sdr.h"
+
+#define MAXCHUNK    256                 /* max number of chunks */
+#define SLIPTHRES   0.25                /* phase reconciliation threshold (cyc) */
+
+/* file size -------------------------------------------------------------------
+* args   : char   *file     I   file path
+* return : uint64_t             file size (bytes) (0: error)
+*-----------------------------------------------------------------------------*/
+static uint64_t filesize(const char *file)
+{
+    FILE *fp;
+    uint64_t size=0;
+
+    if (!(fp=fopen(file,"rb"))) return 0;
+#ifdef WIN32
+    if (!_fseeki64(fp,0,SEEK_END)) size=(uint64_t)_ftelli64(fp);
+#else
+    if (!fseeko(fp,0,SEEK_END)) size=(uint64_t)ftello(fp);
+#endif
+    fclose(fp);
+    return size;
+}
+/* chunk range -----------------------------------------------------------------
+* compute range of IF data processed by chunk. chunk k starts overlap seconds
+* before nominal start for warm-up (acquisition and navigation decoding)
+* args   : int    k         I   chunk index (0-)
+*          uint64_t *off    O   start offset (sample)
+*          uint64_t *len    O   length (sample)
+* return : int                  status 0:okay -1:failure
+*-----------------------------------------------------------------------------*/
+static int chunkrange(int k, uint64_t *off, uint64_t *len)
+{
+    uint64_t total,n,clen,ovl,start,end;
+
+    total=filesize(sdrini.file1)/sdrini.dtype[0];
+    if (sdrini.useif2) {
+        n=filesize(sdrini.file2)/sdrini.dtype[1];
+        if (n<total) total=n;
+    }
+    if (total==0) {
+        SDRPRINTF("error: batch IF file is empty: %s\n",sdrini.file1);
+        return -1;
+    }
+    clen=(total+sdrini.nchunk-1)/sdrini.nchunk;
+    ovl=(uint64_t)(sdrini.overlap*sdrini.f_sf[0]);
+    start=clen*k;
+    end=start+clen<total?start+clen:total;
+    *off=start>ovl?start-ovl:0;
+    *len=end>*off?end-*off:0;
+    return 0;
+}
+/* rinex file names ------------------------------------------------------------
+* args   : char   *name     I   file name without extension
+*          char   *obsfile  O   rinex observation file name
+*          char   *navfile  O   rinex navigation file name
+*          int    size      I   size of file name buffers
+* return : int                  status 0:okay -1:path too long
+*-----------------------------------------------------------------------------*/
+static int rnxfile(const char *name, char *obsfile, char *navfile, int size)
+{
+    int n1,n2;
+
+    n1=snprintf(obsfile,size,"%s/%s.obs",sdrini.rinexpath,name);
+    n2=snprintf(navfile,size,"%s/%s.nav",sdrini.rinexpath,name);
+    if (n1<0||n1>=size||n2<0||n2>=size) {
+        SDRPRINTF("error: rinex path too long: %s\n",sdrini.rinexpath);
+        return -1;
+    }
+    return 0;
+}
+/* rinex file names of chunk ---------------------------------------------------
+* args   : int    k         I   chunk index (0-)
+*          char   *obsfile  O   rinex observation file name
+*          char   *navfile  O   rinex navigation file name
+*          int    size      I   size of file name buffers
+* return : int                  status 0:okay -1:path too long
+*-----------------------------------------------------------------------------*/
+static int chunkfile(int k, char *obsfile, char *navfile, int size)
+{
+    char name[32];
+
+    sprintf(name,"sdr_chunk%03d",k+1);
+    return rnxfile(name,obsfile,navfile,size);
+}
+/* set up chunk process --------------------------------------------------------
+* set sdrini struct of chunk process. chunk is processed in offline mode and
+* outputs rinex files
+* args   : int    k         I   chunk index (0-)
+* return : int                  status 0:okay -1:failure
+*-----------------------------------------------------------------------------*/
+extern int sdrbatchchunk(int k)
+{
+    int i;
+
+    if (k<0||k>=sdrini.nchunk) {
+        SDRPRINTF("error: wrong chunk index: %d\n",k);
+        return -1;
+    }
+    if (chunkrange(k,&sdrini.fileoff,&sdrini.filelen)<0) return -1;
+
+    sdrini.ichunk=k+1;
+    sdrini.offline=ON;
+    sdrini.rinex=ON;
+    sdrini.rtcm=sdrini.sbas=sdrini.log=OFF;
+    sdrini.pltacq=sdrini.plttrk=sdrini.pltspec=OFF;
+    if (k>0) {
+        for (i=0;i<sdrini.nch;i++) sdrini.acqstart[i]=0;
+    }
+    SDRPRINTF("chunk %d/%d: offset=%.0f length=%.0f (sample)\n",k+1,
+        sdrini.nchunk,(double)sdrini.fileoff,(double)sdrini.filelen);
+    return 0;
+}
+/* run chunk processes ---------------------------------------------------------
+* run chunk processes in parallel (max nproc processes at once)
+* args   : char   *exe      I   executable path (for windows)
+* return : int                  number of failed chunks (-1: error)
+*-----------------------------------------------------------------------------*/
+static int runchunks(const char *exe)
+{
+    int k,n=0,nfail=0,nproc;
+#ifdef WIN32
+    HANDLE hp[MAXIMUM_WAIT_OBJECTS];
+    char path[MAX_PATH],arg[16];
+    DWORD code,i;
+
+    nproc=sdrini.nproc<MAXIMUM_WAIT_OBJECTS?sdrini.nproc:MAXIMUM_WAIT_OBJECTS;
+    if (!GetModuleFileName(NULL,path,MAX_PATH)) strcpy(path,exe);
+
+    for (k=0;k<sdrini.nchunk||n>0;) {
+        if (k<sdrini.nchunk&&n<nproc) {
+            sprintf(arg,"%d",k++);
+            if ((hp[n]=(HANDLE)_spawnl(_P_NOWAIT,path,path,"-chunk",arg,
+                NULL))==(HANDLE)-1) {
+                SDRPRINTF("error: chunk %s process can't be created\n",arg);
+                nfail++;
+                continue;
+            }
+            n++;
+            continue;
+        }
+        i=WaitForMultipleObjects(n,hp,FALSE,INFINITE)-WAIT_OBJECT_0;
+        if (i>=(DWORD)n) return -1;
+        if (!GetExitCodeProcess(hp[i],&code)||code!=0) nfail++;
+        CloseHandle(hp[i]);
+        hp[i]=hp[--n];
+    }
+#else
+    pid_t pid;
+    int stat;
+
+    nproc=sdrini.nproc;
+    fflush(stdout);
+
+    for (k=0;k<sdrini.nchunk||n>0;) {
+        if (k<sdrini.nchunk&&n<nproc) {
+            if ((pid=fork())<0) {
+                SDRPRINTF("error: chunk %d process can't be created\n",k+1);
+                nfail++; k++;
+                continue;
+            }
+            if (pid==0) { /* chunk process */
+                if (sdrbatchchunk(k)<0) _exit(1);
+                startsdr(sdrcur);
+                fflush(stdout);
+                _exit(0);
+            }
+            k++; n++;
+            continue;
+        }
+        if (wait(&stat)<0) return -1;
+        if (!WIFEXITED(stat)||WEXITSTATUS(stat)!=0) nfail++;
+        n--;
+    }
+#endif
+    return nfail;
+}
+/* stitch rinex observation data -----------------------------------------------
+* stitch rinex observation data of chunks into one continuous rinex file.
+* epochs of chunk are used after the last epoch of previous chunks. carrier
+* phase of each satellite is shifted by integer cycles which is estimated at
+* the latest overlapped epoch. if no overlapped epoch or the difference is not
+* integer, loss of lock indicator is set at the first epoch
+* args   : char   *file     I   output rinex observation file name
+*          rnxopt_t *opt    I   rinex option struct
+* return : int                  status 0:okay -1:failure
+*-----------------------------------------------------------------------------*/
+static int stitchobs(const char *file, rnxopt_t *opt)
+{
+    FILE *fp;
+    obs_t obs[2]={{0}},*prev=&obs[0],*cur=&obs[1],*tmp;
+    nav_t nav={0};
+    gtime_t tend={0};
+    double off[MAXSAT],d;
+    int k,i,j,n,nep=0,sat,slip[MAXSAT];
+    char obsfile[1024],navfile[1024];
+
+    if (!(fp=fopen(file,"w"))) {
+        SDRPRINTF("error: rinex obs can't be created %s\n",file);
+        return -1;
+    }
+    outrnxobsh(fp,opt,&nav);
+
+    for (k=0;k<sdrini.nchunk;k++) {
+        if (chunkfile(k,obsfile,navfile,sizeof(obsfile))<0) {
+            freeobs(prev); fclose(fp);
+            return -1;
+        }
+        if (readrnx(obsfile,1,"",cur,NULL,NULL)<=0||sortobs(cur)<=0) {
+            SDRPRINTF("warning: no observation data in chunk %d\n",k+1);
+            freeobs(cur);
+            continue;
+        }
+        for (i=0;i<MAXSAT;i++) {
+            off[i]=0.0; slip[i]=prev->n>0; /* new arc without overlap */
+        }
+        /* phase offset at overlapped epochs (prev and cur are sorted) */
+        for (i=j=0;i<cur->n&&timediff(cur->data[i].time,tend)<=DTTOL;i++) {
+            while (j<prev->n&&(timediff(prev->data[j].time,
+                cur->data[i].time)<-DTTOL||(fabs(timediff(prev->data[j].time,
+                cur->data[i].time))<=DTTOL&&prev->data[j].sat<
+                cur->data[i].sat))) j++;
+            if (j>=prev->n) break;
+            if (fabs(timediff(prev->data[j].time,cur->data[i].time))>DTTOL||
+                prev->data[j].sat!=cur->data[i].sat) continue;
+            if (prev->data[j].L[0]==0.0||cur->data[i].L[0]==0.0) continue;
+
+            sat=cur->data[i].sat-1;
+            d=prev->data[j].L[0]-cur->data[i].L[0];
+            off[sat]=floor(d+0.5);
+            slip[sat]=fabs(d-off[sat])>SLIPTHRES;
+        }
+        for (i=0;i<cur->n&&timediff(cur->data[i].time,tend)<=DTTOL;i++) ;
+
+        if (prev->n>0&&i<cur->n&&timediff(cur->data[i].time,tend)>
+            sdrini.outms*2E-3) {
+            SDRPRINTF("warning: gap before chunk %d (%.1f s): increase "
+                "OVERLAP\n",k+1,timediff(cur->data[i].time,tend));
+        }
+        /* output epochs after the last epoch */
+        for (;i<cur->n;i=j) {
+            for (j=i+1;j<cur->n&&fabs(timediff(cur->data[j].time,
+                cur->data[i].time))<=DTTOL;j++) ;
+            for (n=i;n<j;n++) {
+                sat=cur->data[n].sat-1;
+                if (cur->data[n].L[0]!=0.0) cur->data[n].L[0]+=off[sat];
+                if (slip[sat]) {
+                    cur->data[n].LLI[0]|=1;
+                    slip[sat]=0;
+                }
+            }
+            outrnxobsb(fp,opt,cur->data+i,j-i,0);
+            tend=cur->data[i].time;
+            nep++;
+        }
+        tmp=prev; prev=cur; cur=tmp;
+        freeobs(cur);
+    }
+    freeobs(prev);
+    fclose(fp);
+
+    SDRPRINTF("stitched observation data: %d epochs %s\n",nep,file);
+    return 0;
+}
+/* stitch rinex navigation data ------------------------------------------------
+* merge rinex navigation data of chunks and delete duplicated ephemerides
+* args   : char   *file     I   output rinex navigation file name
+*          rnxopt_t *opt    I   rinex option struct
+* return : int                  status 0:okay -1:failure
+*-----------------------------------------------------------------------------*/
+static int stitchnav(const char *file, rnxopt_t *opt)
+{
+    FILE *fp;
+    nav_t *nav;
+    int k,i;
+    char obsfile[1024],navfile[1024];
+
+    if (!(nav=(nav_t *)calloc(1,sizeof(nav_t)))) return -1;
+
+    for (k=0;k<sdrini.nchunk;k++) {
+        if (chunkfile(k,obsfile,navfile,sizeof(obsfile))<0) {
+            freenav(nav,0xFF); free(nav);
+            return -1;
+        }
+        readrnx(navfile,1,"",NULL,nav,NULL);
+    }
+    uniqnav(nav);
+
+    if (!(fp=fopen(file,"w"))) {
+        SDRPRINTF("error: rinex nav can't be created %s\n",file);
+        freenav(nav,0xFF); free(nav);
+        return -1;
+    }
+    outrnxnavh(fp,opt,nav);
+    for (i=0;i<nav->n;i++) outrnxnavb(fp,opt,nav->eph+i);
+    for (i=0;i<nav->ng;i++) outrnxgnavb(fp,opt,nav->geph+i);
+    fclose(fp);
+
+    SDRPRINTF("stitched navigation data: %d ephemerides %s\n",nav->n+nav->ng,
+        file);
+    freenav(nav,0xFF); free(nav);
+    return 0;
+}
+/* sdr batch processing --------------------------------------------------------
+* split IF data file into overlapped chunks, process chunks by independent
+* receiver processes and stitch outputs into rinex obs/nav files
+* args   : char   *exe      I   executable path
+* return : int                  status 0:okay -1:failure
+* note : each chunk runs in its own process in deterministic offline mode, so
+*        throughput scales with number of cpu cores (NPROC)
+*-----------------------------------------------------------------------------*/
+extern int sdrbatch(const char *exe)
+{
+    rnxopt_t opt={{0}};
+    char obsfile[1024],navfile[1024];
+    int nfail;
+
+    SDRPRINTF("GNSS-SDRLIB batch processing start: nchunk=%d nproc=%d\n",
+        sdrini.nchunk,sdrini.nproc);
+
+    if (sdrini.nchunk>MAXCHUNK) {
+        SDRPRINTF("error: too many chunks: %d\n",sdrini.nchunk);
+        return -1;
+    }
+    sdrini.rinex=ON;
+    if (chk_initvalue(&sdrini)<0) {
+        SDRPRINTF("error: chk_initvalue\n");
+        return -1;
+    }
+    if ((nfail=runchunks(exe))<0) {
+        SDRPRINTF("error: batch process\n");
+        return -1;
+    }
+    if (nfail>0) {
+        SDRPRINTF("warning: %d chunks failed\n",nfail);
+    }
+    /* stitch chunk outputs */
+    createrinexopt(&opt);
+    if (rnxfile("sdr_batch",obsfile,navfile,sizeof(obsfile))<0||
+        stitchobs(obsfile,&opt)<0||stitchnav(navfile,&opt)<0) {
+        return -1;
+    }
+    SDRPRINTF("GNSS-SDRLIB batch processing is finished!\n");
+    return 0;
+}
@@ -131,54 +131,88 @@ extern void cpxfree(cpx_t *cpx)
 {
     fftwf_free(cpx);
 }
+/* get cached FFT plan ---------------------------------------------------------
+* get fft plan from plan cache shared by all receivers. the plan is created at
+* first call for each number of points and direction
+* args   : int    n         I   number of fft points
+*          int    sign      I   FFTW_FORWARD or FFTW_BACKWARD
+* return : fftwf_plan           fft plan (NULL: cache is full)
+* note : cached plans are executed with fftwf_execute_dft() by arrays allocated
+*        by cpxmalloc() (same alignment)
+*-----------------------------------------------------------------------------*/
+extern fftwf_plan getfftplan(int n, int sign)
+{
+    static struct {int n,sign; fftwf_plan plan;} cache[MAXFFTPLAN];
+    static int ncache=0;
+    fftwf_plan plan=NULL;
+    cpx_t *tmp;
+    int i;
+
+    mlock(hfftmtx);
+    for (i=0;i<ncache;i++) {
+        if (cache[i].n==n&&cache[i].sign==sign) {
+            plan=cache[i].plan;
+            break;
+        }
+    }
+    if (plan==NULL&&ncache<MAXFFTPLAN&&(tmp=cpxmalloc(n))) {
+        fftwf_plan_with_nthreads(NFFTTHREAD); /* fft execute in multi threads */
+        plan=fftwf_plan_dft_1d(n,tmp,tmp,sign,FFTW_ESTIMATE);
+        cpxfree(tmp);
+        if (plan!=NULL) {
+            cache[ncache].n=n;
+            cache[ncache].sign=sign;
+            cache[ncache++].plan=plan;
+        }
+    }
+    unmlock(hfftmtx);
+    return plan;
+}
 /* complex FFT -----------------------------------------------------------------
 * cpx=fft(cpx)
-* args   : fftwf_plan plan  I   fftw plan (NULL: create new plan)
+* args   : fftwf_plan plan  I   fftw plan (NULL: cached plan)
 *          cpx_t  *cpx      I/O input/output complex data
 *          int    n         I   number of input/output data
 * return : none
 *-----------------------------------------------------------------------------*/
 extern void cpxfft(fftwf_plan plan, cpx_t *cpx, int n)
 {
-#ifdef FFTMTX
-        mlock(hfftmtx);
-#endif
-    if (plan==NULL) {
-        fftwf_plan_with_nthreads(NFFTTHREAD); /* fft execute in multi threads */
-        plan=fftwf_plan_dft_1d(n,cpx,cpx,FFTW_FORWARD,FFTW_ESTIMATE);
-        fftwf_execute_dft(plan,cpx,cpx); /* fft */
-        fftwf_destroy_plan(plan);
-    } else {
-        fftwf_execute_dft(plan,cpx,cpx); /* fft */
+    if (plan==NULL) plan=getfftplan(n,FFTW_FORWARD);
+
+    if (plan!=NULL) {
+        fftwf_execute_dft(plan,cpx,cpx); /* fft (thread-safe) */
+        return;
     }
-#ifdef FFTMTX
-        unmlock(hfftmtx);
-#endif
+    /* planner is not thread-safe */
+    mlock(hfftmtx);
+    fftwf_plan_with_nthreads(NFFTTHREAD); /* fft execute in multi threads */
+    plan=fftwf_plan_dft_1d(n,cpx,cpx,FFTW_FORWARD,FFTW_ESTIMATE);
+    fftwf_execute_dft(plan,cpx,cpx); /* fft */
+    fftwf_destroy_plan(plan);
+    unmlock(hfftmtx);
 }
 /* complex IFFT ----------------------------------------------------------------
 * cpx=ifft(cpx)
-* args   : fftwf_plan plan  I   fftw plan (NULL: create new plan)
+* args   : fftwf_plan plan  I   fftw plan (NULL: cached plan)
 *          cpx_t  *cpx      I/O input/output complex data
 *          int    n         I   number of input/output data
 * return : none
 *-----------------------------------------------------------------------------*/
 extern void cpxifft(fftwf_plan plan, cpx_t *cpx, int n)
 {
-#ifdef FFTMTX
-        mlock(hfftmtx);
-#endif
-    if (plan==NULL) {
-        fftwf_plan_with_nthreads(NFFTTHREAD); /* fft execute in multi threads */
-        plan=fftwf_plan_dft_1d(n,cpx,cpx,FFTW_BACKWARD,FFTW_ESTIMATE);
-        fftwf_execute_dft(plan,cpx,cpx); /* fft */
-        fftwf_destroy_plan(plan);
-    } else {
-        fftwf_execute_dft(plan,cpx,cpx); /* fft */
-    }
-#ifdef FFTMTX
-        unmlock(hfftmtx);
-#endif
+    if (plan==NULL) plan=getfftplan(n,FFTW_BACKWARD);
 
+    if (plan!=NULL) {
+        fftwf_execute_dft(plan,cpx,cpx); /* ifft (thread-safe) */
+        return;
+    }
+    /* planner is not thread-safe */
+    mlock(hfftmtx);
+    fftwf_plan_with_nthreads(NFFTTHREAD); /* fft execute in multi threads */
+    plan=fftwf_plan_dft_1d(n,cpx,cpx,FFTW_BACKWARD,FFTW_ESTIMATE);
+    fftwf_execute_dft(plan,cpx,cpx); /* ifft */
+    fftwf_destroy_plan(plan);
+    unmlock(hfftmtx);
 }
 /* convert short vector to complex vector --------------------------------------
 * cpx=complex(I,Q)
@@ -923,6 +957,34 @@ extern double rescode(const short *code, int len, double coff, int smax,
     return coff-smax*ci;
 #endif
 }
+/* local carrier table (read-only after initmixcarr) */
+#if !defined(SSE2_ENABLE)
+static short mixcost[CDIV]={0},mixsint[CDIV]={0};
+#else
+static char mixcost[16]={0},mixsint[16]={0};
+#endif
+
+/* initialize local carrier table ----------------------------------------------
+* args   : none
+* return : none
+* note : called once before sdr threads are created (sdrinitshared)
+*-----------------------------------------------------------------------------*/
+extern void initmixcarr(void)
+{
+    int i;
+
+#if !defined(SSE2_ENABLE)
+    for (i=0;i<CDIV;i++) {
+        mixcost[i]=(short)floor((cos(DPI/CDIV*i)/CSCALE+0.5));
+        mixsint[i]=(short)floor((sin(DPI/CDIV*i)/CSCALE+0.5));
+    }
+#else
+    for (i=0;i<16;i++) {
+        mixcost[i]=(char)floor((cos(DPI/16*i)/CSCALE+0.5));
+        mixsint[i]=(char)floor((sin(DPI/16*i)/CSCALE+0.5));
+    }
+#endif
+}
 /* mix local carrier -----------------------------------------------------------
 * mix local carrier to data
 * args   : char   *data     I   data
@@ -941,16 +1003,9 @@ extern double mixcarr(const char *data, int dtype, double ti, int n,
     double phi,ps,prem;
 
 #if !defined(SSE2_ENABLE)
-    static short cost[CDIV]={0},sint[CDIV]={0};
-    int i,index;
-
-    /* initialize local carrier table */
-    if (!cost[0]) { 
-        for (i=0;i<CDIV;i++) {
-            cost[i]=(short)floor((cos(DPI/CDIV*i)/CSCALE+0.5));
-            sint[i]=(short)floor((sin(DPI/CDIV*i)/CSCALE+0.5));
-        }
-    }
+    const short *cost=mixcost,*sint=mixsint;
+    int index;
+
     phi=phi0*CDIV/DPI;
     ps= freq *CDIV*ti; /* phase step */
 
@@ -972,7 +1027,7 @@ extern double mixcarr(const char *data, int dtype, double ti, int n,
     while(prem>DPI) prem-=DPI;
     return prem;
 #else
-    static char cost[16]={0},sint[16]={0};
+    const char *cost=mixcost,*sint=mixsint;
     short I1[16]={0},I2[16]={0},Q1[16]={0},Q2[16]={0};
     int i;
     __m128d xmm1,xmm2,xmm3,xmm4,xmm5,xmm6,xmm7,xmm8,xmm9;
@@ -981,12 +1036,6 @@ extern double mixcarr(const char *data, int dtype, double ti, int n,
     __m128i mask4=_mm_set1_epi32(15);
     __m128i mask8=_mm_set1_epi16(255);
 
-    if (!cost[0]) {
-        for (i=0;i<16;i++) {
-            cost[i]=(char)floor((cos(DPI/16*i)/CSCALE+0.5));
-            sint[i]=(char)floor((sin(DPI/16*i)/CSCALE+0.5));
-        }
-    }
     phi=phi0/DPI*16-floor(phi0/DPI)*16;
     ps=freq*16*ti;
     xmm1=_mm_set_pd(phi+ps,phi); phi+=ps*2;
@@ -1343,6 +1343,16 @@ static short *boc(short *code, int *len, double *crate, int m, int n)
     free(code);
     return boccode;
 }
+/* initialize code tables ------------------------------------------------------
+* initialize tables used by code generation (legendre sequence)
+* args   : none
+* return : none
+* note : called once before sdr threads are created (sdrinitshared)
+*-----------------------------------------------------------------------------*/
+extern void initcodetbl(void)
+{
+    if (!legendre[0]) gen_legendre_sequence();
+}
 /* generate code ---------------------------------------------------------------
 * generate code
 * args   : int    prn       I   satellite PRN
@@ -0,0 +1,481 @@
+/*------------------------------------------------------------------------------
+* sdrconv.c : SDR sample format conversion functions
+*
+* Copyright (C) 2014 Taro Suzuki <gnsssdrlib@gmail.com>
+*-----------------------------------------------------------------------------*/
+#include "sdr.h"
+
+#define DCALPHA     (1.0/16.0)  /* gain of dc-offset estimator (per block) */
+#define SC16SHIFT   4           /* 12-bit to 8-bit shift of sc16 data */
+#define DCFLUSH     4096        /* flush interval of int32 sum (simd words) */
+#define BENCHLEN    (1<<24)     /* input length of benchmark (bytes) */
+#define BENCHTIME   500000      /* min measurement time of benchmark (us) */
+
+/* saturate int to int8 ------------------------------------------------------*/
+static char sat8(int x)
+{
+    return (char)(x>127?127:(x<-128?-128:x));
+}
+/* u8 offset-binary to int8 ----------------------------------------------------
+* convert unsigned 8-bit offset-binary data (RTL-SDR) to int8 data
+* args   : uint8_t *in      I   input data
+*          int    n         I   number of data
+*          char   *out      O   output data (in can be used)
+* return : none
+* note : same as (char)(in[i]-127.5), i.e. in[i]-127-(in[i]>>7)
+*-----------------------------------------------------------------------------*/
+extern void convu8(const uint8_t *in, int n, char *out)
+{
+    int i=0;
+#if defined(AVX2_ENABLE)
+    __m256i y,m,s=_mm256_set1_epi8((char)0x80),z=_mm256_setzero_si256();
+
+    for (;i+32<=n;i+=32) {
+        y=_mm256_xor_si256(_mm256_loadu_si256((__m256i *)(in+i)),s);
+        m=_mm256_cmpgt_epi8(z,y); /* -1 for negative */
+        _mm256_storeu_si256((__m256i *)(out+i),_mm256_sub_epi8(y,m));
+    }
+#endif
+#if defined(SSE2_ENABLE)
+    __m128i x,k,t=_mm_set1_epi8((char)0x80),zero=_mm_setzero_si128();
+
+    for (;i+16<=n;i+=16) {
+        x=_mm_xor_si128(_mm_loadu_si128((__m128i *)(in+i)),t);
+        k=_mm_cmpgt_epi8(zero,x); /* -1 for negative */
+        _mm_storeu_si128((__m128i *)(out+i),_mm_sub_epi8(x,k));
+    }
+#endif
+    for (;i<n;i++) {
+        out[i]=(char)(in[i]-127-(in[i]>>7));
+    }
+}
+/* sum of sc16 I/Q data --------------------------------------------------------
+* args   : int16_t *in      I   input data (I/Q)
+*          int    n         I   number of data (I and Q)
+*          int64_t *sum     O   sum of I and Q data {I,Q}
+* return : none
+*-----------------------------------------------------------------------------*/
+static void sumsc16(const int16_t *in, int n, int64_t *sum)
+{
+    int i;
+
+    sum[0]=sum[1]=0;
+    for (i=0;i+1<n;i+=2) {
+        sum[0]+=in[i  ];
+        sum[1]+=in[i+1];
+    }
+}
+/* sc16 to int8 with dc-offset removal -----------------------------------------
+* convert 12-bit sc16 I/Q data (bladeRF SC16 Q11) to int8 data. dc offset is
+* removed by streaming estimator (1st order IIR filter of block mean)
+* args   : uint16_t *in     I   input data (I/Q, 12-bit in 16-bit word)
+*          int    n         I   number of data (I and Q)
+*          sdrdcoff_t *dc   I/O dc-offset estimator state
+*          char   *out      O   output data
+* return : none
+* note : the dc offset estimated up to previous block is used, so the data
+*        is converted in one pass. the first block initializes the estimator
+*-----------------------------------------------------------------------------*/
+extern void convsc16(const uint16_t *in, int n, sdrdcoff_t *dc, char *out)
+{
+    const int16_t *p=(const int16_t *)in;
+    int64_t sum[2]={0};
+    int i=0,dcI,dcQ;
+#if defined(AVX2_ENABLE)||defined(SSE2_ENABLE)
+    int16_t d[16];
+    int j;
+#endif
+
+    n&=~1;
+    if (n<=0) return;
+
+    if (!dc->init) {
+        sumsc16(p,n,sum);
+        dc->dc[0]=(double)sum[0]/(n/2);
+        dc->dc[1]=(double)sum[1]/(n/2);
+        dc->init=1;
+        sum[0]=sum[1]=0;
+    }
+    dcI=(int)floor(dc->dc[0]+0.5);
+    dcQ=(int)floor(dc->dc[1]+0.5);
+#if defined(AVX2_ENABLE)||defined(SSE2_ENABLE)
+    for (j=0;j<16;j++) d[j]=(int16_t)(j%2?dcQ:dcI);
+#endif
+
+#if defined(AVX2_ENABLE)
+    {
+    __m256i y1,y2,yd=_mm256_loadu_si256((__m256i *)d);
+    __m256i yi=_mm256_set1_epi32(1),yq=_mm256_set1_epi32(1<<16);
+    __m256i ysi=_mm256_setzero_si256(),ysq=_mm256_setzero_si256();
+    int32_t s[8];
+
+    for (j=0;i+32<=n;i+=32) {
+        y1=_mm256_loadu_si256((__m256i *)(p+i   ));
+        y2=_mm256_loadu_si256((__m256i *)(p+i+16));
+        ysi=_mm256_add_epi32(ysi,_mm256_madd_epi16(y1,yi));
+        ysq=_mm256_add_epi32(ysq,_mm256_madd_epi16(y1,yq));
+        ysi=_mm256_add_epi32(ysi,_mm256_madd_epi16(y2,yi));
+        ysq=_mm256_add_epi32(ysq,_mm256_madd_epi16(y2,yq));
+        y1=_mm256_srai_epi16(_mm256_sub_epi16(y1,yd),SC16SHIFT);
+        y2=_mm256_srai_epi16(_mm256_sub_epi16(y2,yd),SC16SHIFT);
+        y1=_mm256_permute4x64_epi64(_mm256_packs_epi16(y1,y2),0xD8);
+        _mm256_storeu_si256((__m256i *)(out+i),y1);
+
+        if (++j>=DCFLUSH||i+64>n) { /* flush int32 sum */
+            _mm256_storeu_si256((__m256i *)s,ysi);
+            sum[0]+=(int64_t)s[0]+s[1]+s[2]+s[3]+s[4]+s[5]+s[6]+s[7];
+            _mm256_storeu_si256((__m256i *)s,ysq);
+            sum[1]+=(int64_t)s[0]+s[1]+s[2]+s[3]+s[4]+s[5]+s[6]+s[7];
+            ysi=ysq=_mm256_setzero_si256();
+            j=0;
+        }
+    }
+    }
+#endif
+#if defined(SSE2_ENABLE)
+    {
+    __m128i x1,x2,xd=_mm_loadu_si128((__m128i *)d);
+    __m128i xi=_mm_set1_epi32(1),xq=_mm_set1_epi32(1<<16);
+    __m128i xsi=_mm_setzero_si128(),xsq=_mm_setzero_si128();
+    int32_t s[4];
+
+    for (j=0;i+16<=n;i+=16) {
+        x1=_mm_loadu_si128((__m128i *)(p+i  ));
+        x2=_mm_loadu_si128((__m128i *)(p+i+8));
+        xsi=_mm_add_epi32(xsi,_mm_madd_epi16(x1,xi));
+        xsq=_mm_add_epi32(xsq,_mm_madd_epi16(x1,xq));
+        xsi=_mm_add_epi32(xsi,_mm_madd_epi16(x2,xi));
+        xsq=_mm_add_epi32(xsq,_mm_madd_epi16(x2,xq));
+        x1=_mm_srai_epi16(_mm_sub_epi16(x1,xd),SC16SHIFT);
+        x2=_mm_srai_epi16(_mm_sub_epi16(x2,xd),SC16SHIFT);
+        _mm_storeu_si128((__m128i *)(out+i),_mm_packs_epi16(x1,x2));
+
+        if (++j>=DCFLUSH||i+32>n) { /* flush int32 sum */
+            _mm_storeu_si128((__m128i *)s,xsi);
+            sum[0]+=(int64_t)s[0]+s[1]+s[2]+s[3];
+            _mm_storeu_si128((__m128i *)s,xsq);
+            sum[1]+=(int64_t)s[0]+s[1]+s[2]+s[3];
+            xsi=xsq=_mm_setzero_si128();
+            j=0;
+        }
+    }
+    }
+#endif
+    for (;i<n;i+=2) {
+        sum[0]+=p[i  ];
+        sum[1]+=p[i+1];
+        out[i  ]=sat8((p[i  ]-dcI)>>SC16SHIFT);
+        out[i+1]=sat8((p[i+1]-dcQ)>>SC16SHIFT);
+    }
+    /* update dc-offset estimator */
+    dc->dc[0]+=DCALPHA*((double)sum[0]/(n/2)-dc->dc[0]);
+    dc->dc[1]+=DCALPHA*((double)sum[1]/(n/2)-dc->dc[1]);
+}
+/* packed 1/2/4-bit to int8 with look-up table ---------------------------------
+* convert packed data to int8 data by look-up table of lower 4 bits. one
+* output data for one input byte (GN3S v3 2-bit I mode)
+* args   : uint8_t *in      I   input data
+*          int    n         I   number of data
+*          char   *lut      I   look-up table (16 entries, index: in&0x0F)
+*          char   *out      O   output data
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void convlut(const uint8_t *in, int n, const char *lut, char *out)
+{
+    int i=0;
+#if defined(AVX2_ENABLE)
+    __m256i yl=_mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)lut));
+    __m256i ym=_mm256_set1_epi8(0x0F),y;
+
+    for (;i+32<=n;i+=32) {
+        y=_mm256_and_si256(_mm256_loadu_si256((__m256i *)(in+i)),ym);
+        _mm256_storeu_si256((__m256i *)(out+i),_mm256_shuffle_epi8(yl,y));
+    }
+#endif
+#if defined(SSE2_ENABLE)
+    __m128i xl=_mm_loadu_si128((__m128i *)lut),xm=_mm_set1_epi8(0x0F),x;
+
+    for (;i+16<=n;i+=16) {
+        x=_mm_and_si128(_mm_loadu_si128((__m128i *)(in+i)),xm);
+        _mm_storeu_si128((__m128i *)(out+i),_mm_shuffle_epi8(xl,x));
+    }
+#endif
+    for (;i<n;i++) {
+        out[i]=lut[in[i]&0x0F];
+    }
+}
+/* packed I/Q to int8 with look-up table ---------------------------------------
+* convert packed I/Q data to int8 I/Q data by look-up tables of lower 4 bits.
+* two output data (I,Q) for one input byte (GN3S v3 4-bit I/Q mode)
+* args   : uint8_t *in      I   input data
+*          int    n         I   number of data (input bytes)
+*          char   *luti     I   look-up table of I (16 entries)
+*          char   *lutq     I   look-up table of Q (16 entries)
+*          char   *out      O   output data (2*n)
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void convlutiq(const uint8_t *in, int n, const char *luti,
+                      const char *lutq, char *out)
+{
+    int i=0;
+#if defined(SSE2_ENABLE)
+    __m128i xli=_mm_loadu_si128((__m128i *)luti);
+    __m128i xlq=_mm_loadu_si128((__m128i *)lutq);
+    __m128i xm=_mm_set1_epi8(0x0F),x,xi,xq;
+
+    for (;i+16<=n;i+=16) {
+        x=_mm_and_si128(_mm_loadu_si128((__m128i *)(in+i)),xm);
+        xi=_mm_shuffle_epi8(xli,x);
+        xq=_mm_shuffle_epi8(xlq,x);
+        _mm_storeu_si128((__m128i *)(out+2*i   ),_mm_unpacklo_epi8(xi,xq));
+        _mm_storeu_si128((__m128i *)(out+2*i+16),_mm_unpackhi_epi8(xi,xq));
+    }
+#endif
+    for (;i<n;i++) {
+        out[2*i  ]=luti[in[i]&0x0F];
+        out[2*i+1]=lutq[in[i]&0x0F];
+    }
+}
+/* 1-bit to int8 ---------------------------------------------------------------
+* convert 1-bit data in lsb of each byte to int8 data (GN3S v2)
+* args   : uint8_t *in      I   input data
+*          int    n         I   number of data
+*          char   *out      O   output data (0:+1, 1:-1)
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void conv1bit(const uint8_t *in, int n, char *out)
+{
+    int i=0;
+#if defined(AVX2_ENABLE)
+    __m256i y1=_mm256_set1_epi8(1),y;
+
+    for (;i+32<=n;i+=32) {
+        y=_mm256_and_si256(_mm256_loadu_si256((__m256i *)(in+i)),y1);
+        y=_mm256_sub_epi8(y1,_mm256_add_epi8(y,y));
+        _mm256_storeu_si256((__m256i *)(out+i),y);
+    }
+#endif
+#if defined(SSE2_ENABLE)
+    __m128i x1=_mm_set1_epi8(1),x;
+
+    for (;i+16<=n;i+=16) {
+        x=_mm_and_si128(_mm_loadu_si128((__m128i *)(in+i)),x1);
+        x=_mm_sub_epi8(x1,_mm_add_epi8(x,x));
+        _mm_storeu_si128((__m128i *)(out+i),x);
+    }
+#endif
+    for (;i<n;i++) {
+        out[i]=(char)(1-2*(in[i]&1));
+    }
+}
+/* packed 2-bit x4 to int8 -----------------------------------------------------
+* convert four 2-bit data packed in one byte to int8 data (Simple RF). bit 3
+* (magnitude) and bit 7 (sign) are used for first data, and next data are
+* obtained by shifting byte left
+* args   : uint8_t *in      I   input data
+*          int    n         I   number of data (input bytes)
+*          char   *lut      I   look-up table (4 entries, index: mag|sign<<1)
+*          char   *out      O   output data (4*n)
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void conv2bitx4(const uint8_t *in, int n, const char *lut, char *out)
+{
+    int i=0,k;
+#if defined(SSE2_ENABLE)
+    __m128i xl,x,v[4],a,b,m1=_mm_set1_epi8(1),m2=_mm_set1_epi8(2);
+    char l[16]={0};
+
+    for (k=0;k<16;k++) l[k]=lut[k&3];
+    xl=_mm_loadu_si128((__m128i *)l);
+
+    for (;i+16<=n;i+=16) {
+        x=_mm_loadu_si128((__m128i *)(in+i));
+        for (k=0;k<4;k++) { /* index: (b>>(3-k))&1|(b>>(6-k))&2 */
+            a=_mm_and_si128(_mm_srli_epi16(x,3-k),m1);
+            b=_mm_and_si128(_mm_srli_epi16(x,6-k),m2);
+            v[k]=_mm_shuffle_epi8(xl,_mm_or_si128(a,b));
+        }
+        a=_mm_unpacklo_epi8(v[0],v[1]);
+        b=_mm_unpacklo_epi8(v[2],v[3]);
+        _mm_storeu_si128((__m128i *)(out+4*i   ),_mm_unpacklo_epi16(a,b));
+        _mm_storeu_si128((__m128i *)(out+4*i+16),_mm_unpackhi_epi16(a,b));
+        a=_mm_unpackhi_epi8(v[0],v[1]);
+        b=_mm_unpackhi_epi8(v[2],v[3]);
+        _mm_storeu_si128((__m128i *)(out+4*i+32),_mm_unpacklo_epi16(a,b));
+        _mm_storeu_si128((__m128i *)(out+4*i+48),_mm_unpackhi_epi16(a,b));
+    }
+#endif
+    for (;i<n;i++) {
+        for (k=0;k<4;k++) {
+            out[4*i+k]=lut[((in[i]>>(3-k))&1)|((in[i]>>(6-k))&2)];
+        }
+    }
+}
+/* unpack 1/2/4/8-bit data to int8 ---------------------------------------------
+* convert lsb-first packed data (packed IF file) to int8 data by look-up table
+* args   : uint8_t *in      I   input data
+*          int    n         I   number of output data
+*          int    bits      I   bits per data (1,2,4,8)
+*          char   *lut      I   look-up table (2^bits entries, 8-bit: unused)
+*          char   *out      O   output data
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void convunpack(const uint8_t *in, int n, int bits, const char *lut,
+                       char *out)
+{
+    int i=0,k,mask=(1<<bits)-1;
+#if defined(SSE2_ENABLE)
+    __m128i xl,x,v[4],a,b,c,m,s;
+    char l[16]={0};
+#endif
+    if (bits==8) {
+        memcpy(out,in,n);
+        return;
+    }
+#if defined(SSE2_ENABLE)
+    for (k=0;k<16;k++) l[k]=lut[k&mask];
+    xl=_mm_loadu_si128((__m128i *)l);
+
+    switch (bits) {
+    case 1: /* 16 bytes to 128 data: broadcast bytes and test bits */
+        a=_mm_set1_epi8(lut[0]);
+        b=_mm_xor_si128(a,_mm_set1_epi8(lut[1]));
+        m=_mm_set_epi8(-128,64,32,16,8,4,2,1,-128,64,32,16,8,4,2,1);
+        for (;i+128<=n;i+=128) {
+            x=_mm_loadu_si128((__m128i *)(in+i/8));
+            s=_mm_set_epi8(1,1,1,1,1,1,1,1,0,0,0,0,0,0,0,0);
+            for (k=0;k<8;k++) {
+                c=_mm_and_si128(_mm_shuffle_epi8(x,s),m);
+                c=_mm_and_si128(_mm_cmpeq_epi8(c,m),b);
+                _mm_storeu_si128((__m128i *)(out+i+16*k),_mm_xor_si128(a,c));
+                s=_mm_add_epi8(s,_mm_set1_epi8(2));
+            }
+        }
+        break;
+    case 2: /* 16 bytes to 64 data */
+        m=_mm_set1_epi8(3);
+        for (;i+64<=n;i+=64) {
+            x=_mm_loadu_si128((__m128i *)(in+i/4));
+            for (k=0;k<4;k++) {
+                a=_mm_and_si128(_mm_srli_epi16(x,2*k),m);
+                v[k]=_mm_shuffle_epi8(xl,a);
+            }
+            a=_mm_unpacklo_epi8(v[0],v[1]);
+            b=_mm_unpacklo_epi8(v[2],v[3]);
+            _mm_storeu_si128((__m128i *)(out+i   ),_mm_unpacklo_epi16(a,b));
+            _mm_storeu_si128((__m128i *)(out+i+16),_mm_unpackhi_epi16(a,b));
+            a=_mm_unpackhi_epi8(v[0],v[1]);
+            b=_mm_unpackhi_epi8(v[2],v[3]);
+            _mm_storeu_si128((__m128i *)(out+i+32),_mm_unpacklo_epi16(a,b));
+            _mm_storeu_si128((__m128i *)(out+i+48),_mm_unpackhi_epi16(a,b));
+        }
+        break;
+    case 4: /* 16 bytes to 32 data */
+        m=_mm_set1_epi8(0x0F);
+        for (;i+32<=n;i+=32) {
+            x=_mm_loadu_si128((__m128i *)(in+i/2));
+            a=_mm_shuffle_epi8(xl,_mm_and_si128(x,m));
+            b=_mm_shuffle_epi8(xl,_mm_and_si128(_mm_srli_epi16(x,4),m));
+            _mm_storeu_si128((__m128i *)(out+i   ),_mm_unpacklo_epi8(a,b));
+            _mm_storeu_si128((__m128i *)(out+i+16),_mm_unpackhi_epi8(a,b));
+        }
+        break;
+    }
+#endif
+    for (;i<n;i++) {
+        k=i*bits;
+        out[i]=lut[(in[k>>3]>>(k&7))&mask];
+    }
+}
+/* pack int8 data to 1/2/4/8-bit data ------------------------------------------
+* convert int8 data to lsb-first packed data by encoding table
+* args   : char   *in       I   input data
+*          int    n         I   number of input data (n*bits: multiple of 8)
+*          int    bits      I   bits per data (1,2,4,8)
+*          uint8_t *enc     I   encoding table (256 entries, index: in+128)
+*          uint8_t *out     O   output data (n*bits/8 bytes)
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void convpack(const char *in, int n, int bits, const uint8_t *enc,
+                     uint8_t *out)
+{
+    int i,k=0;
+    uint8_t b=0;
+
+    if (bits==8) {
+        memcpy(out,in,n);
+        return;
+    }
+    for (i=0;i<n;i++) {
+        b|=enc[(signed char)in[i]+128]<<k;
+        if ((k+=bits)>=8) {
+            *out++=b;
+            b=0;
+            k=0;
+        }
+    }
+}
+/* benchmark of one converter ------------------------------------------------*/
+static double benchconv(int type, const uint8_t *in, char *out)
+{
+    static const char lut[16]={1,-1,3,-3,1,-1,3,-3,1,-1,3,-3,1,-1,3,-3};
+    sdrdcoff_t dc={{0}};
+    unsigned long t0,t;
+    double nout=0.0;
+    int n=BENCHLEN;
+
+    t0=tickgetus();
+    do {
+        switch (type) {
+        case 0: convu8(in,n,out);                         nout+=n;   break;
+        case 1: convsc16((const uint16_t *)in,n/2,&dc,out); nout+=n/2; break;
+        case 2: convlut(in,n,lut,out);                    nout+=n;   break;
+        case 3: convlutiq(in,n,lut,lut,out);              nout+=2*n; break;
+        case 4: conv1bit(in,n,out);                       nout+=n;   break;
+        case 5: conv2bitx4(in,n,lut,out);                 nout+=4*n; break;
+        case 6: convunpack(in,4*n,1,lut,out);             nout+=4*n; break;
+        case 7: convunpack(in,4*n,2,lut,out);             nout+=4*n; break;
+        case 8: convunpack(in,2*n,4,lut,out);             nout+=2*n; break;
+        }
+    } while ((t=tickgetus()-t0)<BENCHTIME);
+
+    return nout/t*1E-3; /* GS/s */
+}
+/* benchmark of sample format converters ---------------------------------------
+* measure throughput of sample format converters and print results
+* args   : none
+* return : int                  status 0:okay -1:failure
+*-----------------------------------------------------------------------------*/
+extern int sdrconvbench(void)
+{
+    const char *name[]={"u8 offset-binary","sc16 12-bit + dc removal",
+        "packed 2-bit (lut)","packed 4-bit I/Q (lut)","GN3S v2 1-bit",
+        "packed 2-bit x4","packed file 1-bit","packed file 2-bit",
+        "packed file 4-bit"};
+    uint8_t *in;
+    char *out;
+    int i;
+
+    in=(uint8_t *)malloc(BENCHLEN);
+    out=(char *)malloc(4*BENCHLEN);
+    if (in==NULL||out==NULL) {
+        SDRPRINTF("error: sdrconvbench memory allocation\n");
+        free(in); free(out);
+        return -1;
+    }
+    for (i=0;i<BENCHLEN;i++) in[i]=(uint8_t)rand();
+
+#if defined(AVX2_ENABLE)
+    SDRPRINTF("sample format converters (AVX2):\n");
+#elif defined(SSE2_ENABLE)
+    SDRPRINTF("sample format converters (SSE2/SSSE3):\n");
+#else
+    SDRPRINTF("sample format converters (scalar):\n");
+#endif
+    for (i=0;i<9;i++) {
+        SDRPRINTF("  %-26s: %6.2f GS/s\n",name[i],benchconv(i,in,out));
+    }
+    free(in);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,186 @@
+/*------------------------------------------------------------------------------
+* sdrctx.c : SDR receiver context functions
+*
+* Copyright (C) 2014 Taro Suzuki <gnsssdrlib@gmail.com>
+*-----------------------------------------------------------------------------*/
+#include "sdr.h"
+
+static sdrrcv_t *rcvs[MAXSDRRCV]={0};      /* additional receivers */
+static int shared=0;                    /* shared resource initialized flag */
+
+/* thread start argument */
+typedef struct {
+    thrfunc_t func;      /* thread function */
+    void *arg;           /* argument of thread function */
+    sdrrcv_t *rcv;       /* receiver context of thread */
+} thrarg_t;
+
+/* create receiver context -----------------------------------------------------
+* allocate new receiver context and register it
+* args   : none
+* return : sdrrcv_t*            receiver context (NULL: error)
+* note : receiver context struct is large (sdr channel structs), so it is
+*        allocated in heap memory
+*-----------------------------------------------------------------------------*/
+extern sdrrcv_t *sdrnewrcv(void)
+{
+    sdrrcv_t *rcv;
+    int i;
+
+    for (i=0;i<MAXSDRRCV;i++) {
+        if (rcvs[i]==NULL) break;
+    }
+    if (i>=MAXSDRRCV) {
+        SDRPRINTF("error: too many receivers\n");
+        return NULL;
+    }
+    if (!(rcv=(sdrrcv_t *)calloc(1,sizeof(sdrrcv_t)))) {
+        SDRPRINTF("error: sdrnewrcv memory allocation\n");
+        return NULL;
+    }
+    rcv->no=i+1;
+    rcvs[i]=rcv;
+    return rcv;
+}
+/* free receiver context -------------------------------------------------------
+* args   : sdrrcv_t *rcv    I   receiver context
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void sdrfreercv(sdrrcv_t *rcv)
+{
+    int i;
+
+    for (i=0;i<MAXSDRRCV;i++) {
+        if (rcvs[i]==rcv) rcvs[i]=NULL;
+    }
+    free(rcv);
+}
+/* bind receiver context -------------------------------------------------------
+* bind receiver context to current thread. sdrini, sdrstat, sdrch, sdrout,
+* sdrspec and receiver mutexes refer to the bound receiver context
+* args   : sdrrcv_t *rcv    I   receiver context
+* return : none
+* note : no receiver context is bound by default. binding NULL is a
+*        programming error and aborts the process
+*-----------------------------------------------------------------------------*/
+extern void sdrbindrcv(sdrrcv_t *rcv)
+{
+    if (rcv==NULL) {
+        SDRPRINTF("error: sdrbindrcv no receiver context\n");
+        abort();
+    }
+    sdrcur=rcv;
+}
+/* stop all receivers ----------------------------------------------------------
+* args   : none
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void sdrstopall(void)
+{
+    int i;
+
+    sdrstat.stopflag=ON;
+    for (i=0;i<MAXSDRRCV;i++) {
+        if (rcvs[i]!=NULL) rcvs[i]->stat.stopflag=ON;
+    }
+}
+/* initialize shared resources -------------------------------------------------
+* initialize mutexes and tables shared by all receivers
+* args   : none
+* return : none
+* note : call before receiver threads are created
+*-----------------------------------------------------------------------------*/
+extern void sdrinitshared(void)
+{
+    if (shared) return;
+
+    initmlock(hfftmtx);
+    initmlock(hpltmtx);
+
+    /* read-only tables */
+    initmixcarr();
+    initcodetbl();
+    shared=1;
+}
+/* thread start function -------------------------------------------------------
+* bind receiver context of parent thread and call thread function
+*-----------------------------------------------------------------------------*/
+#ifdef WIN32
+static void thrstart(void *arg)
+#else
+static void *thrstart(void *arg)
+#endif
+{
+    thrarg_t a=*(thrarg_t *)arg;
+
+    free(arg);
+    sdrbindrcv(a.rcv);
+#ifdef WIN32
+    a.func(a.arg);
+#else
+    return a.func(a.arg);
+#endif
+}
+/* create thread ---------------------------------------------------------------
+* create thread which inherits receiver context of current thread
+* args   : thrfunc_t func   I   thread function
+*          void   *arg      I   argument of thread function
+* return : thread_t             thread handle
+* note : current thread must be bound to a receiver context (sdrbindrcv)
+*-----------------------------------------------------------------------------*/
+extern thread_t sdrcratethread(thrfunc_t func, void *arg)
+{
+    thrarg_t *a;
+    thread_t h;
+
+    if (sdrcur==NULL) {
+        SDRPRINTF("error: sdrcratethread from unbound thread\n");
+        abort();
+    }
+    if (!(a=(thrarg_t *)malloc(sizeof(thrarg_t)))) {
+        SDRPRINTF("error: sdrcratethread memory allocation\n");
+        exit(-1);
+    }
+    a->func=func;
+    a->arg=arg;
+    a->rcv=sdrcur;
+#ifdef WIN32
+    h=(thread_t)_beginthread(thrstart,0,a);
+#else
+    if (pthread_create(&h,NULL,thrstart,a)) {
+        SDRPRINTF("error: failed to create thread\n");
+        free(a);
+        memset(&h,0,sizeof(h));
+    }
+#endif
+    return h;
+}
+/* wait event with timeout -----------------------------------------------------
+* wait event with timeout. the mutex is released while waiting
+* args   : event_t *ev      I   event
+*          mlock_t *mtx     I   mutex (locked by caller)
+*          int    ms        I   timeout (ms)
+* return : int                  1:event 0:timeout
+*-----------------------------------------------------------------------------*/
+extern int sdrwaitevent(event_t *ev, mlock_t *mtx, int ms)
+{
+#ifdef WIN32
+    DWORD ret;
+
+    unmlock(*mtx);
+    ret=WaitForSingleObject(*ev,ms);
+    mlock(*mtx);
+    return ret==WAIT_OBJECT_0;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME,&ts);
+    ts.tv_sec+=ms/1000;
+    ts.tv_nsec+=(ms%1000)*1000000L;
+    if (ts.tv_nsec>=1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec-=1000000000L;
+    }
+    return pthread_cond_timedwait(ev,mtx,&ts)==0;
+#endif
+}
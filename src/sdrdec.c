@@ -0,0 +1,180 @@
+/*------------------------------------------------------------------------------
+* sdrdec.c : SDR navigation message decoder thread functions
+*
+* Copyright (C) 2014 Taro Suzuki <gnsssdrlib@gmail.com>
+*-----------------------------------------------------------------------------*/
+#include "sdr.h"
+
+/* initialize navigation decode queue ------------------------------------------
+* allocate decode queue and navigation struct of decoder. the decoder struct
+* has own frame bit ring and ephemeris. FEC decoding is done by tracking
+* before frame bits are queued, so the decoder has no FEC decoder (vit=NULL)
+* args   : sdrnav_t *nav    I/O navigation struct
+* return : int                  status 0:okay -1:failure
+* note : call after navigation struct is initialized
+*-----------------------------------------------------------------------------*/
+extern int navqinit(sdrnav_t *nav)
+{
+    sdrnavq_t *q;
+
+    if (!(q=(sdrnavq_t *)calloc(1,sizeof(sdrnavq_t)))) {
+        SDRPRINTF("error: navqinit memory allocation\n");
+        return -1;
+    }
+    q->dec=*nav;
+    q->dec.fpnav=NULL;
+    q->dec.bitsync=NULL;
+    q->dec.vit=NULL;
+    q->dec.q=NULL;
+    q->dec.ocode=NULL;
+
+    if (!(q->dec.fring=(uint32_t *)calloc((nav->fmask+1)/32,4))||
+        !(q->dec.fbitsdec=(int *)calloc(nav->flen+nav->addflen,sizeof(int)))) {
+        SDRPRINTF("error: navqinit memory allocation\n");
+        free(q->dec.fring);
+        free(q);
+        return -1;
+    }
+    nav->q=q;
+    return 0;
+}
+/* free navigation decode queue ------------------------------------------------
+* args   : sdrnav_t *nav    I/O navigation struct
+* return : none
+* note : call after decoder thread is stopped
+*-----------------------------------------------------------------------------*/
+extern void navqfree(sdrnav_t *nav)
+{
+    if (nav->q==NULL) return;
+
+    free(nav->q->dec.fring);
+    free(nav->q->dec.fbitsdec);
+    free(nav->q);
+    nav->q=NULL;
+}
+/* publish ephemeris -----------------------------------------------------------
+* copy ephemeris of decoder to navigation struct of channel (seqlock writer)
+* args   : sdrnav_t *nav    I/O navigation struct
+*          sdreph_t *eph    I   ephemeris of decoder
+* return : none
+*-----------------------------------------------------------------------------*/
+static void publish(sdrnav_t *nav, const sdreph_t *eph)
+{
+    nav->ephver++;
+    sdrbarrier();
+    memcpy(&nav->sdreph,eph,sizeof(sdreph_t));
+    sdrbarrier();
+    nav->ephver++;
+}
+/* get ephemeris ---------------------------------------------------------------
+* get consistent copy of ephemeris published by decoder (seqlock reader)
+* args   : sdrnav_t *nav    I   navigation struct
+*          sdreph_t *eph    O   ephemeris
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void navgeteph(const sdrnav_t *nav, sdreph_t *eph)
+{
+    uint32_t ver;
+
+    do {
+        while ((ver=nav->ephver)&1) ;
+        sdrbarrier();
+        memcpy(eph,&nav->sdreph,sizeof(sdreph_t));
+        sdrbarrier();
+    } while (nav->ephver!=ver);
+}
+/* push decode result ----------------------------------------------------------
+* args   : sdrnavq_t *q     I/O navigation decode queue
+*          sdrnavres_t *res I   decode result
+* return : none
+* note : single producer (decoder) and single consumer (tracking)
+*-----------------------------------------------------------------------------*/
+static void pushres(sdrnavq_t *q, const sdrnavres_t *res)
+{
+    q->res[q->rwp%NAVQLEN]=*res;
+    sdrbarrier();
+    q->rwp++;
+}
+/* decode navigation frame -----------------------------------------------------
+* FEC decoding and navigation message decoding of frame snapshot. decoded
+* ephemeris is published to channel and result is pushed to result queue
+* args   : sdrch_t *sdr     I/O sdr channel struct
+*          sdrnavfrm_t *frm I   frame snapshot
+* return : none
+* note : called by decoder thread, or by tracking in offline mode
+*-----------------------------------------------------------------------------*/
+extern void navdecode(sdrch_t *sdr, const sdrnavfrm_t *frm)
+{
+    sdrnavq_t *q=sdr->nav.q;
+    sdrnav_t *dec=&q->dec;
+    sdrnavres_t res;
+    int sfn,n=dec->flen+dec->addflen;
+
+    /* frame snapshot to ring of decoder */
+    memcpy(dec->fring,frm->bits,sizeof(uint32_t)*((n+31)/32));
+    dec->fhead=n;
+    dec->fview=0;
+    dec->polarity=frm->polarity;
+    dec->flagsyncf=ON;
+    dec->flagtow=ON;
+
+    predecodefec(dec); /* FEC decoding */
+    sfn=decodenav(dec); /* navigation message decoding */
+
+    SDRPRINTF("%s ID=%d tow:%.1f week=%d int_loop_cnt=%d\n",
+        sdr->satstr,sfn,dec->sdreph.tow_gpst,dec->sdreph.week_gpst,
+        (int)frm->cnt);
+
+    if (frm->first&&dec->sdreph.tow_gpst!=0) {
+        dec->sdreph.eph.sat=sdr->sat; /* satellite number */
+    }
+    /* ephemeris is completed */
+    if (dec->sdreph.update&&dec->sdreph.cnt>=dec->sdreph.cntth) {
+        dec->sdreph.cnt=0;
+        dec->sdreph.update=OFF;
+        publish(&sdr->nav,&dec->sdreph);
+        sdr->nav.ephnew++;
+    }
+    else publish(&sdr->nav,&dec->sdreph);
+
+    res.cnt=frm->cnt;
+    res.first=frm->first;
+    res.gen=frm->gen;
+    res.reset=!dec->flagtow;
+    res.prn=dec->sdreph.prn;
+    res.tow=dec->sdreph.tow_gpst;
+    pushres(q,&res);
+}
+/* navigation decoder thread ---------------------------------------------------
+* decode navigation frames queued by tracking of all channels, so tracking
+* threads are not stalled by FEC and message decoding
+* args   : void   *arg      I   not used
+* return : none
+*-----------------------------------------------------------------------------*/
+#ifdef WIN32
+extern void decthread(void *arg)
+#else
+extern void *decthread(void *arg)
+#endif
+{
+    sdrnavq_t *q;
+    int i,n;
+
+    sdrrtthread(RT_OUT);
+
+    while (!sdrstat.stopflag) {
+        for (i=n=0;i<MAXSAT;i++) {
+            if ((q=sdrch[i].nav.q)==NULL) continue;
+
+            while (q->rp<q->wp&&q->rwp-q->rrp<NAVQLEN) {
+                sdrbarrier();
+                navdecode(&sdrch[i],&q->frm[q->rp%NAVQLEN]);
+                sdrbarrier();
+                q->rp++;
+                n++;
+            }
+        }
+        if (n==0) sleepms(NAVQPOLL);
+    }
+    return THRETVAL;
+}
@@ -0,0 +1,197 @@
+/*------------------------------------------------------------------------------
+* sdrfec.c : SDR forward error correction functions
+*
+* Copyright (C) 2014 Taro Suzuki <gnsssdrlib@gmail.com>
+*-----------------------------------------------------------------------------*/
+#include "sdr.h"
+
+#define BENCHPAIR   ((NAVFLEN_SBAS+NAVADDFLEN_SBAS)/2) /* pairs of benchmark */
+#define BENCHTIME   500000      /* min measurement time of benchmark (us) */
+
+/* encoder output of K=7 R=1/2 code (V27POLYA,V27POLYB) ------------------------
+* index: shift register (bit0:newest input), bit0:symbol A, bit1:symbol B
+*-----------------------------------------------------------------------------*/
+static const uint8_t vitout[128]={
+    0,3,1,2,3,0,2,1,3,0,2,1,0,3,1,2,
+    0,3,1,2,3,0,2,1,3,0,2,1,0,3,1,2,
+    2,1,3,0,1,2,0,3,1,2,0,3,2,1,3,0,
+    2,1,3,0,1,2,0,3,1,2,0,3,2,1,3,0,
+    3,0,2,1,0,3,1,2,0,3,1,2,3,0,2,1,
+    3,0,2,1,0,3,1,2,0,3,1,2,3,0,2,1,
+    1,2,0,3,2,1,3,0,2,1,3,0,1,2,0,3,
+    1,2,0,3,2,1,3,0,2,1,3,0,1,2,0,3
+};
+/* initialize sliding window viterbi decoder -----------------------------------
+* args   : sdrvit_t *vit    O   viterbi decoder struct
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void vitinit(sdrvit_t *vit)
+{
+    memset(vit->metric,0,sizeof(vit->metric)); /* start state is unknown */
+    vit->n=0;
+}
+/* update sliding window viterbi decoder ---------------------------------------
+* add-compare-select of one symbol pair and traceback of VITTB steps. the bit
+* of step n-VITTB-1 is decided and stored to decoded bits ring
+* args   : sdrvit_t *vit    I/O viterbi decoder struct
+*          int    s0,s1     I   hard decision symbols (0:+1 1:-1)
+* return : none
+* note : state is last 6 input bits (bit0:newest), same as libfec viterbi27
+*-----------------------------------------------------------------------------*/
+extern void vitupdate(sdrvit_t *vit, int s0, int s1)
+{
+    static const uint32_t dist[4]={0,1,1,2};
+    uint32_t m[64],m0,m1,min=0xFFFFFFFF;
+    uint64_t d=0,t;
+    int s,k,sym=s0|(s1<<1),best=0;
+
+    /* add-compare-select */
+    for (s=0;s<64;s++) {
+        m0=vit->metric[s>>1     ]+dist[vitout[s   ]^sym];
+        m1=vit->metric[(s>>1)|32]+dist[vitout[s|64]^sym];
+        if (m1<m0) {
+            m0=m1;
+            d|=1ULL<<s;
+        }
+        m[s]=m0;
+        if (m0<min) {
+            min=m0;
+            best=s;
+        }
+    }
+    for (s=0;s<64;s++) vit->metric[s]=m[s]-min; /* normalize */
+    vit->dec[vit->n%VITTB]=d;
+    vit->n++;
+
+    if (vit->n<=VITTB) return;
+
+    /* traceback from best state */
+    for (k=0,t=vit->n-1;k<VITTB;k++,t--) {
+        best=(best>>1)|((int)((vit->dec[t%VITTB]>>best)&1)<<5);
+    }
+    t=(vit->n-VITTB-1)%VITBITS;
+    if (best&1) vit->bits[t>>5]&=~(1u<<(t&31)); /* decoded bit 1:-1 */
+    else        vit->bits[t>>5]|=1u<<(t&31);
+}
+/* decoded bits of sliding window viterbi decoder ------------------------------
+* args   : sdrvit_t *vit    I   viterbi decoder struct
+*          uint64_t step    I   first step (n-VITBITS<=step, step+len<=n-VITTB)
+*          int    len       I   number of bits (<=64)
+* return : uint64_t             packed bits (bit i:bit of step+i is +1)
+*-----------------------------------------------------------------------------*/
+extern uint64_t vitbits(const sdrvit_t *vit, uint64_t step, int len)
+{
+    uint64_t w=0;
+    uint32_t i=(uint32_t)(step%VITBITS);
+    int n,m;
+
+    for (n=0;n<len;n+=m,i=(i+m)%VITBITS) {
+        m=32-(i&31);
+        w|=(uint64_t)(vit->bits[i>>5]>>(i&31))<<n;
+    }
+    return len<64?w&((1ULL<<len)-1):w;
+}
+/* encode bits for benchmark -------------------------------------------------*/
+static void benchenc(const uint8_t *data, int n, uint8_t *sym)
+{
+    int i,r=0;
+
+    for (i=0;i<n;i++) {
+        r=((r<<1)|data[i])&127;
+        sym[2*i  ]=vitout[r]&1?255:0;
+        sym[2*i+1]=vitout[r]&2?255:0;
+        if (rand()%50==0) sym[2*i+rand()%2]^=255; /* symbol error */
+    }
+}
+/* benchmark of block decoder ------------------------------------------------*/
+static double benchblock(int port, void *vp, uint8_t *sym, uint8_t *dec)
+{
+    unsigned long t0,t;
+    double n=0.0;
+
+    t0=tickgetus();
+    do {
+        if (port) {
+            init_viterbi27_port(vp,0);
+            update_viterbi27_blk_port(vp,sym,BENCHPAIR);
+            chainback_viterbi27_port(vp,dec,NAVFLEN_SBAS/2,0);
+        }
+        else {
+            init_viterbi27(vp,0);
+            update_viterbi27_blk(vp,sym,BENCHPAIR);
+            chainback_viterbi27(vp,dec,NAVFLEN_SBAS/2,0);
+        }
+        n+=1.0;
+    } while ((t=tickgetus()-t0)<BENCHTIME);
+
+    return t/n; /* us/bit */
+}
+/* benchmark of sliding window decoder ---------------------------------------*/
+static double benchslide(sdrvit_t *vit, const uint8_t *sym,
+                         const uint8_t *data, int *nerr)
+{
+    unsigned long t0,t;
+    double n=0.0;
+    int i;
+
+    vitinit(vit);
+    t0=tickgetus();
+    do {
+        for (i=0;i<BENCHPAIR;i++) vitupdate(vit,sym[2*i]&1,sym[2*i+1]&1);
+        n+=BENCHPAIR;
+    } while ((t=tickgetus()-t0)<BENCHTIME);
+
+    /* check decoded bits of last block */
+    for (*nerr=0,i=0;i<BENCHPAIR-VITTB;i++) {
+        if (((vitbits(vit,vit->n-BENCHPAIR+i,1)&1)==0)!=data[i]) (*nerr)++;
+    }
+    return t/n; /* us/bit */
+}
+/* benchmark of FEC decoders ---------------------------------------------------
+* measure decoding cost of SBAS frame per navigation bit before frame lock:
+* block decoders of libfec (full frame per bit) and sliding window decoder
+* (one symbol pair per bit)
+* args   : none
+* return : int                  status 0:okay -1:failure
+*-----------------------------------------------------------------------------*/
+extern int sdrfecbench(void)
+{
+    const char *mode[]={"unknown","port","mmx","sse","sse2","altivec"};
+    char name[64];
+    int poly[2]={V27POLYA,V27POLYB},i,nerr;
+    uint8_t data[BENCHPAIR],sym[2*BENCHPAIR],dec[BENCHPAIR/8+1];
+    void *vport,*vsimd;
+    sdrvit_t vit;
+    double t1,t2,t3;
+
+    vport=create_viterbi27_port(NAVFLEN_SBAS/2);
+    vsimd=create_viterbi27(NAVFLEN_SBAS/2);
+    if (vport==NULL||vsimd==NULL) {
+        SDRPRINTF("error: create_viterbi27 failed\n");
+        if (vport) delete_viterbi27_port(vport);
+        if (vsimd) delete_viterbi27(vsimd);
+        return -1;
+    }
+    set_viterbi27_polynomial_port(poly);
+    set_viterbi27_polynomial(poly);
+
+    for (i=0;i<BENCHPAIR;i++) data[i]=(uint8_t)(rand()&1);
+    for (i=BENCHPAIR-6;i<BENCHPAIR;i++) data[i]=0; /* tail */
+    benchenc(data,BENCHPAIR,sym);
+
+    t1=benchblock(1,vport,sym,dec);
+    t2=benchblock(0,vsimd,sym,dec);
+    t3=benchslide(&vit,sym,data,&nerr);
+
+    SDRPRINTF("SBAS viterbi decoder (cost per nav bit per channel):\n");
+    SDRPRINTF("  %-26s: %9.3f us\n","block decode (port)",t1);
+    sprintf(name,"block decode (libfec %s)",
+        (int)Cpu_mode<6?mode[(int)Cpu_mode]:"unknown");
+    SDRPRINTF("  %-26s: %9.3f us\n",name,t2);
+    SDRPRINTF("  %-26s: %9.3f us (%.0fx, %d bit errors)\n",
+        "sliding window",t3,t1/t3,nerr);
+
+    delete_viterbi27_port(vport);
+    delete_viterbi27(vsimd);
+    return 0;
+}
@@ -106,16 +106,39 @@ void readinistr(char *file, char *sec, char *key, char *out)
 extern int readinifile(sdrini_t *ini)
 {
     int i,ret;
-    char inifile[]="./gnss-sdrcli.ini";
-    char fendfile[256],str[256];
+    char inifile[1024]="./gnss-sdrcli.ini";
+    char fendfile[256],str[256],str2[256];
+    double acqstart[MAXSAT]={0};
+    sdrpackhdr_t hdr;
+    const sdrfend_t *fend;
+    gtime_t t1,t2;
+    char *rtcpukey[RT_NTYPE]={"CPUGRAB","CPUCH","CPUSYNC","CPUOUT","CPUPLOT"};
 
     /* check ini file */
+    if (ini->inifile[0]) strcpy(inifile,ini->inifile);
     if ((ret=GetFileAttributes(inifile))<0){
-        SDRPRINTF("error: gnss-sdrcli.ini doesn't exist\n");
+        SDRPRINTF("error: %s doesn't exist\n",inifile);
         return -1;
     }
     /* receiver setting */
     readinistr(inifile,"RCV","FENDCONF",fendfile);
+    ini->replay   =readiniint(inifile,"RCV","REPLAY");
+    ini->replaywin=readiniint(inifile,"RCV","REPLAYWIN");
+    if (ini->replaywin<=0) ini->replaywin=REPLAYWIN;
+    ini->ringms   =readiniint(inifile,"RCV","RINGMS");
+    if (ini->ringms<=0) ini->ringms=RINGMS;
+    ini->hugepage =readiniint(inifile,"RCV","HUGEPAGE");
+    ini->filemap  =readiniint(inifile,"RCV","MMAP");
+    ini->filereader=readiniint(inifile,"RCV","READER");
+    ini->readdepth=readiniint(inifile,"RCV","READDEPTH");
+    if (ini->readdepth<=0) ini->readdepth=RDDEPTH;
+    ini->directio =readiniint(inifile,"RCV","DIRECTIO");
+    readinistr(inifile,"RCV","TEE",ini->teefile);
+    ini->teebits  =readiniint(inifile,"RCV","TEEBITS");
+    ini->teequeue =readiniint(inifile,"RCV","TEEQUEUE");
+    if (ini->teequeue<=0) ini->teequeue=TEEQUEUE;
+    ini->trigsec  =readinidouble(inifile,"RCV","TRIGSEC");
+    readinistr(inifile,"RCV","TRIGFILE",ini->trigfile);
 
     /* check front-end configuration  file */
     if ((ret=GetFileAttributes(fendfile))<0){
@@ -123,19 +146,12 @@ extern int readinifile(sdrini_t *ini)
         return -1;
     }
     readinistr(fendfile,"FEND","TYPE",str);
-    if (strcmp(str,"GN3SV2")==0)     ini->fend=FEND_GN3SV2;
-    else if (strcmp(str,"GN3SV3")==0)     ini->fend=FEND_GN3SV3;
-    else if (strcmp(str,"BLADERF")==0)     ini->fend=FEND_BLADERF;
-    else if (strcmp(str,"RTLSDR")==0)     ini->fend=FEND_RTLSDR;
-    else if (strcmp(str,"FILEGN3SV2")==0) ini->fend=FEND_FGN3SV2;
-    else if (strcmp(str,"FILEGN3SV3")==0) ini->fend=FEND_FGN3SV3;
-    else if (strcmp(str,"FILEBLADERF")==0) ini->fend=FEND_FBLADERF;
-    else if (strcmp(str,"FILERTLSDR")==0) ini->fend=FEND_FRTLSDR;
-    else if (strcmp(str,"FILE")==0)       ini->fend=FEND_FILE;
-    else { SDRPRINTF("error: wrong frontend type: %s\n",str); return -1; }
-    if (ini->fend==FEND_FILE    ||
-        ini->fend==FEND_FGN3SV2 ||ini->fend==FEND_FGN3SV3||
-        ini->fend==FEND_FBLADERF||ini->fend==FEND_FRTLSDR) {
+    if (!(fend=rcvfend(str,0))) { /* front end driver registry */
+        SDRPRINTF("error: wrong frontend type: %s\n",str);
+        return -1;
+    }
+    ini->fend=fend->type;
+    if (fend->file) {
         readinistr(fendfile,"FEND","FILE1",ini->file1);
         if (strcmp(ini->file1,"")!=0) ini->useif1=ON;
     }
@@ -152,8 +168,44 @@ extern int readinifile(sdrini_t *ini)
     ini->f_if[1]=readinidouble(fendfile,"FEND","IF2");
     ini->dtype[1]=readiniint(fendfile,"FEND","DTYPE2");
 
+    /* packed IF files carry front-end settings in header */
+    for (i=0;i<2&&ini->fend==FEND_FILE;i++) {
+        if (packreadhdr(i==0?ini->file1:ini->file2,&hdr)<=0) continue;
+        ini->f_sf[i]=hdr.f_sf;
+        ini->f_if[i]=hdr.f_if;
+        ini->dtype[i]=hdr.dtype;
+        if (hdr.f_cf>0.0) ini->f_cf[i]=hdr.f_cf;
+    }
+    /* alignment of FILE2 stream (sample offset and/or start times) */
+    if (ini->useif2) {
+        ini->skew2=readinidouble(fendfile,"FEND","SKEW2");
+        readinistr(fendfile,"FEND","START1",str);
+        readinistr(fendfile,"FEND","START2",str2);
+        if (str[0]&&str2[0]) {
+            if (str2time(str,0,255,&t1)<0||str2time(str2,0,255,&t2)<0) {
+                SDRPRINTF("error: wrong start time: %s, %s\n",str,str2);
+                return -1;
+            }
+            ini->skew2+=timediff(t1,t2)*ini->f_sf[1];
+        }
+    }
+
     /* RTL-SDR only */
     ini->rtlsdrppmerr=readiniint(fendfile,"FEND","PPMERR");
+    readinistr(fendfile,"FEND","DEVICE",ini->fenddev);
+
+    /* network stream only */
+    if (ini->fend==FEND_NET) {
+        readinistr(fendfile,"FEND","HOST",ini->nethost);
+        ini->netport=readiniint(fendfile,"FEND","PORT");
+        readinistr(fendfile,"FEND","PROTO",str);
+        if ((ini->netproto=netprotocol(str))<0) {
+            SDRPRINTF("error: wrong network protocol: %s\n",str);
+            return -1;
+        }
+        ini->netsockbuf=readiniint(fendfile,"FEND","SOCKBUF");
+        if (ini->netsockbuf<=0) ini->netsockbuf=NETSOCKBUF;
+    }
 
     /* tracking parameter setting */
     ini->trkcorrn=readiniint(fendfile,"TRACK","CORRN");
@@ -192,6 +244,12 @@ extern int readinifile(sdrini_t *ini)
     ini->sbas    =readiniint(inifile,"OUTPUT","SBAS");
     ini->log     =readiniint(inifile,"OUTPUT","LOG");
     readinistr(inifile,"OUTPUT","RINEXPATH",ini->rinexpath);
+    ini->pvt     =readiniint(inifile,"OUTPUT","PVT");
+    readinistr(inifile,"OUTPUT","PVTFILE",ini->pvtfile);
+    ini->elmask  =readinidouble(inifile,"OUTPUT","ELMASK");
+    ini->pvtlat  =readinidouble(inifile,"OUTPUT","PVTLAT");
+    readinistr(inifile,"OUTPUT","OBSBIN",ini->obsbin);
+    ini->obsqueue=readiniint(inifile,"OUTPUT","OBSQUEUE");
     ini->rtcmport=readiniint(inifile,"OUTPUT","RTCMPORT");
     ini->lexport =readiniint(inifile,"OUTPUT","LEXPORT");
     ini->sbasport=readiniint(inifile,"OUTPUT","SBASPORT");
@@ -199,6 +257,40 @@ extern int readinifile(sdrini_t *ini)
     /* spectrum setting */
     ini->pltspec=readiniint(inifile,"SPECTRUM","SPEC");
 
+    /* real-time setting */
+    ini->rtprio  =readiniint(inifile,"RT","PRIO");
+    ini->rtchprio=readiniint(inifile,"RT","CHPRIO");
+    ini->rtpolicy=readiniint(inifile,"RT","POLICY");
+    ini->rtmlock =readiniint(inifile,"RT","MLOCK");
+    for (i=0;i<RT_NTYPE;i++) {
+        readinistr(inifile,"RT",rtcpukey[i],str);
+        if (parsecpulist(str,&ini->rtcpu[i])<0) {
+            SDRPRINTF("error: wrong inifile value %s=%s\n",rtcpukey[i],str);
+            return -1;
+        }
+    }
+
+    /* offline setting */
+    ini->offline=readiniint(inifile,"OFFLINE","ENABLE");
+    ini->nworker=readiniint(inifile,"OFFLINE","NWORKER");
+    if (ini->nworker<=0) ini->nworker=1;
+    if (readinidoubles(inifile,"OFFLINE","ACQSTART",acqstart,ini->nch)<0) {
+        acqstart[0]=readinidouble(inifile,"OFFLINE","ACQSTART");
+        for (i=1;i<ini->nch;i++) acqstart[i]=acqstart[0];
+    }
+    for (i=0;i<ini->nch;i++) {
+        ini->acqstart[i]=acqstart[i]>0.0?(uint64_t)acqstart[i]:0;
+    }
+    if (ini->offline) {
+        ini->pltacq=ini->plttrk=ini->pltspec=0; /* no plot in offline mode */
+    }
+
+    /* batch setting */
+    ini->nchunk =readiniint(inifile,"BATCH","NCHUNK");
+    ini->nproc  =readiniint(inifile,"BATCH","NPROC");
+    ini->overlap=readinidouble(inifile,"BATCH","OVERLAP");
+    if (ini->nproc<=0) ini->nproc=ini->nchunk;
+
     /* sdr channel setting */
     for (i=0;i<sdrini.nch;i++) {
         if (sdrini.ctype[i]==CTYPE_L1CA ||
@@ -221,7 +313,14 @@ extern int readinifile(sdrini_t *ini)
 *-----------------------------------------------------------------------------*/
 extern int chk_initvalue(sdrini_t *ini)
 {
-    int ret;
+    const sdrfend_t *fend=rcvfend(NULL,ini->fend);
+    int i,ret;
+
+    /* checking front end driver */
+    if (fend==NULL) {
+        SDRPRINTF("error: front end is not supported: %d\n",ini->fend);
+        return -1;
+    }
 
     /* checking frequency input */
     if ((ini->f_sf[0]<=0||ini->f_sf[0]>100e6) ||
@@ -249,10 +348,87 @@ extern int chk_initvalue(sdrini_t *ini)
             return -1;
     }
 
+    /* checking real-time setting */
+    if ((ini->rtprio<0||ini->rtprio>99)||(ini->rtchprio<0||ini->rtchprio>99)||
+        (ini->rtpolicy!=RT_FIFO&&ini->rtpolicy!=RT_RR)) {
+            SDRPRINTF("error: wrong real-time setting prio:%d chprio:%d "
+                "policy:%d\n",ini->rtprio,ini->rtchprio,ini->rtpolicy);
+            return -1;
+    }
+
+    /* checking memory-mapped file input */
+    if (ini->filemap&&ini->rtmlock) {
+        SDRPRINTF("error: MMAP can't be used with memory lock (MLOCK)\n");
+        return -1;
+    }
+    /* checking file reader (blocks in flight must not reach replay window) */
+    if (ini->filereader&&ini->filemap) {
+        SDRPRINTF("error: READER can't be used with MMAP\n");
+        return -1;
+    }
+    if (ini->teebits!=0&&ini->teebits!=1&&ini->teebits!=2&&
+        ini->teebits!=4&&ini->teebits!=8) {
+        SDRPRINTF("error: wrong tee recording bits: %d\n",ini->teebits);
+        return -1;
+    }
+    if (ini->readdepth<1) {
+        SDRPRINTF("error: wrong file reader depth: %d\n",ini->readdepth);
+        return -1;
+    }
+    /* checking memory buffer (total size must fit in int) */
+    if (ini->ringms*1E-3*ini->f_sf[0]*ini->dtype[0]>1E9) {
+        SDRPRINTF("error: wrong memory buffer depth: %d ms\n",ini->ringms);
+        return -1;
+    }
+
+    /* checking network stream setting */
+    if (ini->fend==FEND_NET) {
+        if (ini->netport<=0||ini->netport>65535||
+            (ini->netproto!=NETP_UDP&&!ini->nethost[0])) {
+            SDRPRINTF("error: wrong network stream host:%s port:%d\n",
+                ini->nethost,ini->netport);
+            return -1;
+        }
+        if (ini->netproto==NETP_RTLTCP&&ini->dtype[0]!=DTYPEIQ) {
+            SDRPRINTF("error: rtl_tcp stream requires DTYPE1=2\n");
+            return -1;
+        }
+    }
+
+    /* checking offline setting */
+    if (ini->offline) {
+        if (!fend->file) {
+            SDRPRINTF("error: offline mode requires file input\n");
+            return -1;
+        }
+        for (i=0;i<ini->nch;i++) {
+            if (ini->ctype[i]==CTYPE_LEXS) {
+                SDRPRINTF("error: offline mode doesn't support LEX\n");
+                return -1;
+            }
+        }
+        if (ini->nworker<1||ini->nworker>MAXSAT) {
+            SDRPRINTF("error: wrong offline setting nworker:%d\n",
+                ini->nworker);
+            return -1;
+        }
+    }
+
+    /* checking batch setting */
+    if (ini->nchunk>1) {
+        if (ini->fend!=FEND_FILE) {
+            SDRPRINTF("error: batch mode requires FILE front end\n");
+            return -1;
+        }
+        if (ini->nproc<1||ini->overlap<0.0) {
+            SDRPRINTF("error: wrong batch setting nproc:%d overlap:%.1f\n",
+                ini->nproc,ini->overlap);
+            return -1;
+        }
+    }
+
     /* checking filepath */
-    if (ini->fend==FEND_FILE   ||
-        ini->fend==FEND_FGN3SV2||ini->fend==FEND_FGN3SV2||
-        ini->fend==FEND_FRTLSDR||ini->fend==FEND_FBLADERF) {
+    if (fend->file) {
         if (ini->useif1&&((ret=GetFileAttributes(ini->file1))<0)){
             SDRPRINTF("error: file1 doesn't exist: %s\n",ini->file1);
             return -1;
@@ -279,25 +455,25 @@ extern int chk_initvalue(sdrini_t *ini)
     return 0;
 }
 /* initialize mutex and event --------------------------------------------------
-* create mutex and event handles
+* create mutex and event handles of receiver
 * args   : none
 * return : none
+* note : mutexes shared by all receivers are created by sdrinitshared()
 *-----------------------------------------------------------------------------*/
 extern void openhandles(void)
 {
     /* mutexes */
     initmlock(hbuffmtx);
     initmlock(hreadmtx);
-    initmlock(hfftmtx);
-    initmlock(hpltmtx);
     initmlock(hobsmtx);
     initmlock(hlexmtx);
 
     /* events */
     initevent(hlexeve);
+    initevent(hobseve);
 }
 /* close mutex and event -------------------------------------------------------
-* close mutex and event handles
+* close mutex and event handles of receiver
 * args   : none
 * return : none
 *-----------------------------------------------------------------------------*/
@@ -306,22 +482,20 @@ extern void closehandles(void)
     /* mutexes */
     delmlock(hbuffmtx);
     delmlock(hreadmtx);
-    delmlock(hfftmtx);
-    delmlock(hpltmtx);
     delmlock(hobsmtx);
     delmlock(hlexmtx);
 
     /* events */
     delevent(hlexeve);
+    delevent(hobseve);
 
 #ifdef WIN32
     hbuffmtx=NULL;
     hreadmtx=NULL;
-    hfftmtx=NULL;
-    hpltmtx=NULL;
     hobsmtx=NULL;
     hlexmtx=NULL;
     hlexeve=NULL;
+    hobseve=NULL;
 #endif
 }
 /* initialization plot struct --------------------------------------------------
@@ -557,13 +731,19 @@ extern int initnavstruct(int sys, int ctype, int prn, sdrnav_t *nav)
         nav->update=(int)(nav->flen/3*nav->rate);
         memcpy(nav->prebits,pre_sbs,sizeof(int)*nav->prelen);
 
-        /* create fec */
-        if((nav->fec=create_viterbi27_port(NAVFLEN_SBAS/2))==NULL) {
+        /* create fec (SIMD decoder is selected by libfec at runtime) */
+        if((nav->fec=create_viterbi27(NAVFLEN_SBAS/2))==NULL) {
             SDRPRINTF("error: create_viterbi27 failed\n");
             return -1;
         }
         /* set polynomial */
-        set_viterbi27_polynomial_port(poly);
+        set_viterbi27_polynomial(poly);
+
+        /* sliding window decoders for frame search (2 symbol phases) */
+        if (!(nav->vit=(sdrvit_t *)calloc(2,sizeof(sdrvit_t)))) {
+            SDRPRINTF("error: initnavstruct memory alocation\n");
+            return -1;
+        }
 
         /* overlay code (all 1) */
         nav->ocode=(short *)calloc(nav->rate,sizeof(short));
@@ -595,12 +775,12 @@ extern int initnavstruct(int sys, int ctype, int prn, sdrnav_t *nav)
         memcpy(nav->prebits,pre_e1b,sizeof(int)*nav->prelen);
 
         /* create fec */
-        if((nav->fec=create_viterbi27_port(120))==NULL) {
+        if((nav->fec=create_viterbi27(120))==NULL) {
             SDRPRINTF("error: create_viterbi27 failed\n");
             return -1;
         }
         /* set polynomial */
-        set_viterbi27_polynomial_port(poly);
+        set_viterbi27_polynomial(poly);
 
         /* overlay code (all 1) */
         nav->ocode=(short *)calloc(nav->rate,sizeof(short));
@@ -620,6 +800,9 @@ extern int initnavstruct(int sys, int ctype, int prn, sdrnav_t *nav)
             
             /* secondary code generation */
             nav->ocode=gencode(-1,CTYPE_NH20,NULL,NULL);
+            for (i=0;i<nav->rate;i++) {
+                if (nav->ocode[i]<0) nav->nhcode|=1u<<(nav->rate-1-i);
+            }
 
         /* GEO (D2 NAV) */
         } else {
@@ -637,13 +820,22 @@ extern int initnavstruct(int sys, int ctype, int prn, sdrnav_t *nav)
         }
     }
 
+    /* packed preamble */
+    for (i=0;i<nav->prelen;i++) {
+        if (nav->prebits[i]>0) nav->prepack|=1ULL<<i;
+    }
+    /* frame bit ring (power of 2 bits) */
+    for (nav->fmask=32;nav->fmask<nav->flen+nav->addflen;) nav->fmask*=2;
+    nav->fmask--;
+
     if (!(nav->bitsync= (int *)calloc(nav->rate,sizeof(int))) || 
-        !(nav->fbits=   (int *)calloc(nav->flen+nav->addflen,sizeof(int))) ||
+        !(nav->fring=   (uint32_t *)calloc((nav->fmask+1)/32,4)) ||
         !(nav->fbitsdec=(int *)calloc(nav->flen+nav->addflen,sizeof(int)))) {
             SDRPRINTF("error: initnavstruct memory alocation\n");
             return -1;
     }
-    return 0;
+    /* navigation decode queue */
+    return navqinit(nav);
 }
 /* initialize sdr channel struct -----------------------------------------------
 * set value to sdr channel struct
@@ -670,6 +862,7 @@ extern int initsdrch(int chno, int sys, int prn, int ctype, int dtype,
 	//SDRPRINTF("IF: %f\n", f_if);
 
     sdr->no=chno;
+    sdr->rcv=sdrcur;
     sdr->sys=sys;
     sdr->prn=prn;
     sdr->sat=satno(sys,prn);
@@ -757,9 +950,11 @@ extern void freesdrch(sdrch_t *sdr)
 {
     free(sdr->code);
     cpxfree(sdr->xcode);
-    free(sdr->nav.fbits);
+    free(sdr->nav.fring);
     free(sdr->nav.fbitsdec);
     free(sdr->nav.bitsync);
+    free(sdr->nav.vit);
+    navqfree(&sdr->nav);
     free(sdr->trk.II);
     free(sdr->trk.QQ);
     free(sdr->trk.oldI);
@@ -772,7 +967,7 @@ extern void freesdrch(sdrch_t *sdr)
     free(sdr->acq.freq);
 
     if (sdr->nav.fec!=NULL)
-        delete_viterbi27_port(sdr->nav.fec);
+        delete_viterbi27(sdr->nav.fec);
 
     if (sdr->nav.ocode!=NULL)
         free(sdr->nav.ocode);
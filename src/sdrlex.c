@@ -5,9 +5,6 @@
 *-----------------------------------------------------------------------------*/
 #include "sdr.h"
 
-static fftwf_plan  plan=NULL;
-static fftwf_plan iplan=NULL; 
-
 /* LEX correlation function ----------------------------------------------------
 * compute LEX message based on FFT 
 * args   : sdrch_t *sdr     I   sdr channel struct
@@ -50,15 +47,8 @@ uint8_t lexcorr_fft(sdrch_t *sdr, const char *data, int dtype, double ti, int n,
     /* to complex */
     cpxcpx(dataI,dataQ,(1.0/32)/m,m,datax);
 
-    /* convolution */
-    if (plan==NULL||iplan==NULL) {
-        fftwf_plan_with_nthreads(NFFTTHREAD); /* fft execute in multi threads */
-        plan=fftwf_plan_dft_1d(n,datax,datax,FFTW_FORWARD,FFTW_ESTIMATE);
-        
-        fftwf_plan_with_nthreads(NFFTTHREAD); /* fft execute in multi threads */
-        iplan=fftwf_plan_dft_1d(n,datax,datax,FFTW_BACKWARD,FFTW_ESTIMATE);
-    }
-    cpxconv(plan,iplan,datax,codex,m,m,0,P);
+    /* convolution (cached fft plans) */
+    cpxconv(NULL,NULL,datax,codex,m,m,0,P);
 
     /* maximum index */
     maxP=maxvd(P,m,-1,-1,&codei);
@@ -105,11 +95,18 @@ void *lexthread(void * arg)
     uint8_t lexpre[LENLEXPRE]={0x1A,0xCF,0xFC,0x1D}; /* preamble */
     sdrlex_t sdrlex={{0}};
     sdrout_t out={0};
+    sdreph_t eph;
+    sdrtrksnap_t snap;
     unsigned long tick=0;
     FILE *fplexlog=NULL,*fplexbin=NULL;
     short *rcode;
     cpx_t *xcode;
 
+    sdrbindrcv(sdr->rcv);
+
+    /* real-time priority and cpu affinity of channel thread */
+    sdrrtthread(RT_CH);
+
     if (sdrini.log) {
         fplexlog=fopen("LEXLOG.csv","w");
         fplexbin=fopen("LEXBIN.bin","wb");
@@ -147,8 +144,9 @@ void *lexthread(void * arg)
         unmlock(hlexmtx);
         
         /* assist from L1CA */
-        buffloc=sdrch[lexch].trk.codei[1]+sdrch[lexch].currnsamp+DSAMPLEX;
-        dfreq=-sdrch[lexch].trk.D[1]*(FREQ6/FREQ1);
+        trkgetsnap(&sdrch[lexch].trk,&snap);
+        buffloc=snap.codei+sdrch[lexch].currnsamp+DSAMPLEX;
+        dfreq=-snap.D*(FREQ6/FREQ1);
 
         /* get current data */
         rcvgetbuff(&sdrini,buffloc,sdr->nsamp,sdr->ftype,sdr->dtype,data);
@@ -188,7 +186,7 @@ void *lexthread(void * arg)
 
             if (sdrini.log) {
                 fprintf(fplexlog,"%f,%f,%d,%d\n",
-                    sdrch[lexch].trk.tow[0],cn0,time,nerr);
+                    snap.tow,cn0,time,nerr);
                 fwrite(sdrlex.msg,1,LENLEXMSG,fplexbin);
             }
 
@@ -205,10 +203,11 @@ void *lexthread(void * arg)
             sendbuf[1]=0x55; /* sync code2 (see rcvlex.c) */
 
             /* set tow (LEX message does not contain tow information...) */
-            setbitu(sendbuf,2*8,4*8,ROUND(sdrch[lexch].trk.tow[0]*1000));
+            setbitu(sendbuf,2*8,4*8,ROUND(snap.tow*1000));
             
             /*  set week ()*/
-            setbitu(sendbuf,6*8,2*8,sdrch[lexch].nav.sdreph.eph.week);
+            navgeteph(&sdrch[lexch].nav,&eph);
+            setbitu(sendbuf,6*8,2*8,eph.eph.week);
             memcpy(&sendbuf[8],sdrlex.msg,LENLEXMSG-LENLEXRSP); /* LEX message */
 
             /* send LEX message */
@@ -15,23 +15,13 @@ GCHandle hform;
 
 /* thread handle and mutex */
 thread_t hmainthread;
-thread_t hsyncthread;
-thread_t hspecthread;
 thread_t hkeythread;
-mlock_t hbuffmtx;
-mlock_t hreadmtx;
 mlock_t hfftmtx;
 mlock_t hpltmtx;
-mlock_t hobsmtx;
-mlock_t hlexmtx;
-event_t hlexeve;
 
-/* sdr structs */
-sdrini_t sdrini={0};
-sdrstat_t sdrstat={0};
-sdrch_t sdrch[MAXSAT]={{0}};
-sdrspec_t sdrspec={0};
-sdrout_t sdrout={0};
+/* sdr receiver context (default receiver and receiver of current thread) */
+sdrrcv_t sdrrcvdef;
+SDRTLS sdrrcv_t *sdrcur=NULL;
 
 /* initsdrgui ------------------------------------------------------------------
 * initialize sdr gui application  
@@ -68,51 +58,152 @@ extern void *keythread(void * arg)
         switch(getchar()) {
         case 'q':
         case 'Q':
-            sdrstat.stopflag=1;
+            sdrstopall();
+            break;
+        case 't':
+        case 'T':
+            teetrigger();
             break;
         default:
-            SDRPRINTF("press 'q' to exit...\n");
+            SDRPRINTF("press 'q' to exit, 't' to capture...\n");
             break;
         }
     } while (!sdrstat.stopflag);
 
     return THRETVAL;
 }
+/* receiver thread -------------------------------------------------------------
+* receiver thread of multiple receiver mode
+* args   : void   *arg      I   receiver context (sdrrcv_t *)
+* return : none
+* note : this thread is only created in CLI application
+*-----------------------------------------------------------------------------*/
+#ifdef WIN32
+static void rcvthread(void *arg)
+#else
+static void *rcvthread(void *arg)
+#endif
+{
+    sdrrcv_t *rcv=(sdrrcv_t *)arg;
+
+    sdrbindrcv(rcv);
+
+    if (readinifile(&sdrini)>=0) {
+        startsdr(rcv);
+    }
+    return THRETVAL;
+}
 /* main function ---------------------------------------------------------------
 * main entry point in CLI application  
-* args   : none
+* args   : int    argc      I   number of arguments
+*          char   **argv    I   arguments ("-chunk k": chunk process of batch,
+*                               "-rcv file": ini file of each receiver,
+*                               "-bench [conv|fec|obs]": benchmark of sample
+*                               conversion, FEC decoders and/or observation
+*                               output,
+*                               "-pack bits file [ftype [fend]]": convert IF
+*                               file to packed IF file,
+*                               "-netserve proto port [host [speed]]": replay
+*                               IF file to network stream)
 * return : none
 * note : This function is only used in CLI application 
 *-----------------------------------------------------------------------------*/
 int main(int argc, char **argv)
 {
+    sdrrcv_t *rcv[MAXSDRRCV];
+    thread_t hrcv[MAXSDRRCV];
+    int i,n=0;
+
+    sdrbindrcv(&sdrrcvdef);
+
+    /* benchmark mode */
+    if (argc>=2&&!strcmp(argv[1],"-bench")) {
+        if (argc<3||!strcmp(argv[2],"conv")) {
+            if (sdrconvbench()<0) return -1;
+        }
+        if (argc<3||!strcmp(argv[2],"fec")) {
+            if (sdrfecbench()<0) return -1;
+        }
+        if (argc<3||!strcmp(argv[2],"obs")) {
+            if (sdrobsbench()<0) return -1;
+        }
+        return 0;
+    }
+    /* multiple receivers in one process */
+    for (i=1;i<argc-1;i++) {
+        if (strcmp(argv[i],"-rcv")) continue;
+        if (n>=MAXSDRRCV||!(rcv[n]=sdrnewrcv())) return -1;
+        strncpy(rcv[n++]->ini.inifile,argv[++i],1023);
+    }
+    if (n>0) {
+        sdrinitshared();
+        cratethread(hkeythread,keythread,NULL);
+
+        for (i=0;i<n;i++) cratethread(hrcv[i],rcvthread,rcv[i]);
+        for (i=0;i<n;i++) {
+            waitthread(hrcv[i]);
+            sdrfreercv(rcv[i]);
+        }
+        return 0;
+    }
     /* read ini file */
     if (readinifile(&sdrini)<0) {
         return -1; 
     }
+    /* conversion to packed IF file */
+    if (argc>=4&&!strcmp(argv[1],"-pack")) {
+        return sdrpackconv(&sdrini,argc>=5?atoi(argv[4]):FTYPE1,
+            atoi(argv[2]),argv[3],argc>=6?argv[5]:"FILE");
+    }
+    /* replay of IF file to network stream */
+    if (argc>=4&&!strcmp(argv[1],"-netserve")) {
+        return sdrnetserve(&sdrini,argv[2],atoi(argv[3]),argc>=5?argv[4]:"",
+            argc>=6?atof(argv[5]):1.0);
+    }
+    /* chunk process of batch mode */
+    if (argc>=3&&!strcmp(argv[1],"-chunk")) {
+        if (sdrbatchchunk(atoi(argv[2]))<0) return -1;
+        startsdr(&sdrrcvdef);
+        return 0;
+    }
+    /* batch mode */
+    if (sdrini.nchunk>1) {
+        return sdrbatch(argv[0])<0?-1:0;
+    }
     cratethread(hkeythread,keythread,NULL);
 
-    startsdr();
+    startsdr(&sdrrcvdef);
 
     return 0;
 }
 #endif
 /* sdr start -------------------------------------------------------------------
 * start sdr function  
-* args   : void   *arg      I   not used
+* args   : void   *arg      I   receiver context (sdrrcv_t *) (GUI)
+*          sdrrcv_t *rcv    I   receiver context (CLI)
 * return : none
 * note : This function is called as thread in GUI application and is called as
-*        function in CLI application
+*        function in CLI application. the receiver context is bound to the
+*        calling thread and inherited by all threads created by startsdr
 *-----------------------------------------------------------------------------*/
 #ifdef GUI
 extern void startsdr(void *arg) /* call as thread */
 #else
-extern void startsdr(void) /* call as function */
+extern void startsdr(sdrrcv_t *rcv) /* call as function */
 #endif
 {
+    sdrfmt_t fmt;
     int i;
+#ifdef GUI
+    sdrbindrcv((sdrrcv_t *)arg);
+#else
+    sdrbindrcv(rcv);
+#endif
     SDRPRINTF("GNSS-SDRLIB start!\n");
 
+    /* mutexes and tables shared by receivers */
+    sdrinitshared();
+
 	setlocale(LC_ALL, "en-US");
 
     /* check initial value */
@@ -128,6 +219,16 @@ extern void startsdr(void) /* call as function */
         quitsdr(&sdrini,1);
         return;
     }
+    /* lock memory and pre-fault data buffer */
+    if (sdrini.rtmlock) {
+        rcvformat(&sdrini,&fmt);
+        sdrrtmemlock(sdrstat.buff,
+            (size_t)fmt.dtype[0]*fmt.blklen[0]*fmt.nblk[0]);
+        if (fmt.nbuf>1&&sdrstat.buff2!=NULL) {
+            sdrrtmemlock(sdrstat.buff2,
+                (size_t)fmt.dtype[1]*fmt.blklen[1]*fmt.nblk[1]);
+        }
+    }
     /* initialize sdr channel struct */
     for (i=0;i<sdrini.nch;i++) {
         if (initsdrch(i+1,sdrini.sys[i],sdrini.prn[i],sdrini.ctype[i],
@@ -144,8 +245,16 @@ extern void startsdr(void) /* call as function */
     /* mutexes and events */
     openhandles();
 
+    /* deterministic offline processing */
+    if (sdrini.offline) {
+        sdroffline();
+        quitsdr(&sdrini,0);
+        SDRPRINTF("GNSS-SDRLIB is finished!\n");
+        return;
+    }
+
     /* create threads */
-    //cratethread(hsyncthread,syncthread,NULL); /* synchronization thread */
+    cratethread(hsyncthread,syncthread,NULL); /* synchronization thread */
 
     /* sdr channel thread */
     for (i=0;i<sdrini.nch;i++) {
@@ -165,6 +274,8 @@ extern void startsdr(void) /* call as function */
             cratethread(sdrch[sdrini.nch].hsdr,sdrthread,&sdrch[sdrini.nch]);
         }
     }
+    /* navigation decoder thread */
+    cratethread(hdecthread,decthread,NULL);
 #ifndef GUI
     /* sdr spectrum analyzer */
     if (sdrini.pltspec) {
@@ -176,6 +287,8 @@ extern void startsdr(void) /* call as function */
     }
 #endif
 
+    /* real-time priority and cpu affinity of grabber (after thread creation) */
+    sdrrtthread(RT_GRAB);
 
     /* data grabber loop */
     while (!sdrstat.stopflag) 
@@ -190,6 +303,7 @@ extern void startsdr(void) /* call as function */
     waitthread(hsyncthread);
     for (i=0;i<sdrini.nch;i++) 
         waitthread(sdrch[i].hsdr);
+    waitthread(hdecthread);
 
     /* sdr termination */
     quitsdr(&sdrini,0);
@@ -242,6 +356,7 @@ void restart_acquisition(sdrch_t *sdr)
 	sdr->nav.flagpol = 0;
 
 	memset(sdr->nav.bitsync, 0, sdr->nav.rate * sizeof(int));
+	sdr->nav.nhcnt = 0;
 
 	clearcumsumcorr(&sdr->trk);
 
@@ -257,198 +372,244 @@ void restart_acquisition(sdrch_t *sdr)
 	sdr->nav.ocodei = 0;
 }
 
-/* sdr channel thread ----------------------------------------------------------
-* sdr channel thread for signal acquisition and tracking . Every sat have its own thread
-* args   : void   *arg      I   sdr channel struct
-* return : none
-* note : This thread handles the acquisition and tracking of one of the signals. 
-*        The thread is created at startsdr function.
+/* initialize sdr channel processing -------------------------------------------
+* open tracking log file and plot windows of sdr channel
+* args   : sdrch_t *sdr     I/O sdr channel struct
+*          sdrproc_t *proc  O   sdr channel processing state struct
+* return : int                  status 0:okay -1:failure
 *-----------------------------------------------------------------------------*/
-#ifdef WIN32
-extern void sdrthread(void *arg)
-#else
-extern void *sdrthread(void *arg)
-#endif
+extern int initsdrproc(sdrch_t *sdr, sdrproc_t *proc)
 {
-	using namespace std::chrono;
-
-    sdrch_t *sdr=(sdrch_t*)arg;
-    sdrplt_t pltacq={0},plttrk={0};
-	/* Time is ms? */ 
-	uint64_t cnt = 0;
-    uint64_t buffloc=0,bufflocnow=0,loopcnt=0;
-    double *acqpower=NULL;
-    FILE* fp=NULL;
     char fname[100];
-    
+
+    memset(proc,0,sizeof(sdrproc_t));
+
     /* create tracking log file */
     if (sdrini.log) {
         sprintf(fname,"log%s.csv",sdr->satstr);
-        if((fp=createlog(fname,&sdr->trk))==NULL) {
+        if((proc->fp=createlog(fname,&sdr->trk))==NULL) {
             SDRPRINTF("error: invailed log file: %s\n",fname);
-            return THRETVAL;
+            return -1;
         }
     }
 
     /* plot setting */
-    if (initpltstruct(&pltacq,&plttrk,sdr)<0) {
+    if (initpltstruct(&proc->pltacq,&proc->plttrk,sdr)<0) {
         sdrstat.stopflag=ON;
     }
-    //sleepms(sdr->no*500);
-    SDRPRINTF("**** %s sdr thread %d start! ****\n",sdr->satstr,sdr->no);
+    return 0;
+}
+/* sdr channel processing ------------------------------------------------------
+* one step of signal acquisition or tracking (1 code period) of sdr channel
+* args   : sdrch_t *sdr     I/O sdr channel struct
+*          sdrproc_t *proc  I/O sdr channel processing state struct
+* return : int                  1:processed 0:no data in memory buffer
+* note : in offline mode, acquisition starts at acq.acqloc and waits until the
+*        data is pushed to memory buffer
+*-----------------------------------------------------------------------------*/
+extern int sdrproc(sdrch_t *sdr, sdrproc_t *proc)
+{
+	using namespace std::chrono;
 
-	long long pvev_seconds = 0;
-	int prev_cnt = 0;
+    uint64_t head;
 
-    while (!sdrstat.stopflag) 
+    /* acquisition */
+    if (!sdr->flagacq) //if set, never reset
 	{
-        /* acquisition */
-        if (!sdr->flagacq) //if set, never reset
-		{
-            /* memory allocation */
-            if (acqpower!=NULL) free(acqpower);
-            acqpower=(double*)calloc(sizeof(double),sdr->nsamp*sdr->acq.nfreq);
+        if (sdrini.offline) {
+            head=rcvstrmhead(sdr->ftype);
 
-            /* fft correlation. One of results is moving buffer position (buffloc)*/
-            buffloc=sdraccuisition(sdr,acqpower);
+            /* data of acquisition location is already overwritten */
+            if (sdr->acq.acqloc+rcvringlen(sdr->ftype)/2<head)
+                sdr->acq.acqloc=head-(sdr->acq.intg+1)*sdr->nsamp;
 
-            /* plot aquisition result */
-            if (sdr->flagacq&&sdrini.pltacq) 
-			{
-                pltacq.z=acqpower;
-                plot(&pltacq); //plot aquisition
-            }
+            if (sdr->acq.acqloc+(sdr->acq.intg+2)*sdr->nsamp>head) return 0;
         }
-        /* tracking - 1 GNSS code (1023 chips for GPS) */
-        if (sdr->flagacq) 
-		{
-            bufflocnow=sdrtracking(sdr,buffloc,cnt); //correlator + sdrnavigation there
-            if (sdr->flagtrk) //this flag is set periodicaly, after completed corellation
-			{
-                /* correlation output accumulation */
-                cumsumcorr(&sdr->trk,sdr->nav.ocode[sdr->nav.ocodei]);
+        /* memory allocation */
+        if (proc->acqpower!=NULL) free(proc->acqpower);
+        proc->acqpower=(double*)calloc(sizeof(double),sdr->nsamp*sdr->acq.nfreq);
 
-                sdr->trk.flagloopfilter=0;
-                if (!sdr->nav.flagsync)
-				{
-					//Using Parameters1
-                    pll(sdr,&sdr->trk.prm1,sdr->ctime); /* PLL */
-                    dll(sdr,&sdr->trk.prm1,sdr->ctime); /* DLL */
-                    sdr->trk.flagloopfilter=1;
-                }
-                else if (sdr->nav.swloop) 
-				{
-					//Using Parameters2
-                    pll(sdr,&sdr->trk.prm2,(double)sdr->trk.loopms/1000);
-                    dll(sdr,&sdr->trk.prm2,(double)sdr->trk.loopms/1000);
-                    sdr->trk.flagloopfilter=2;
+        /* fft correlation. One of results is moving buffer position (buffloc)*/
+        proc->buffloc=sdraccuisition(sdr,proc->acqpower);
 
-                    mlock(hobsmtx);
-
-                    /* calculate observation data */
-					if (loopcnt % (SNSMOOTHMS / sdr->trk.loopms) == 0)
-					{
-						setobsdata(sdr, buffloc, cnt, &sdr->trk, 1);
-						//Detect tracking loss
-						double summ_value = sdr->trk.Isum_fin / 1000.0;
-						if (summ_value < TRACK_LOST_SUMM)
-						{
-							sdr->trk.track_loss_cnt++;
-							if ((sdr->trk.track_loss_cnt > 
-								(TRACK_RESTORE_TIME_MS / SNSMOOTHMS)) && (sdrini.use_restore_acq != 0))
-							{
-								restart_acquisition(sdr);
-								cnt = 0;
-							}
-						}
-						else
-						{
-							sdr->trk.track_loss_cnt = 0;
-						}
-					}
-                    else
-                        setobsdata(sdr,buffloc,cnt,&sdr->trk,0);
+        /* plot aquisition result */
+        if (sdr->flagacq&&sdrini.pltacq) 
+		{
+            proc->pltacq.z=proc->acqpower;
+            plot(&proc->pltacq); //plot aquisition
+        }
+        sdr->trk.buffloc=proc->buffloc;
+        return 1;
+    }
+    /* tracking - 1 GNSS code (1023 chips for GPS) */
+    proc->bufflocnow=sdrtracking(sdr,proc->buffloc,proc->cnt); //correlator + sdrnavigation there
+    if (sdr->flagtrk) //this flag is set periodicaly, after completed corellation
+	{
+        /* correlation output accumulation */
+        cumsumcorr(&sdr->trk,sdr->nav.ocode[sdr->nav.ocodei]);
 
-                    unmlock(hobsmtx);
+        sdr->trk.flagloopfilter=0;
+        if (!sdr->nav.flagsync)
+		{
+			//Using Parameters1
+            pll(sdr,&sdr->trk.prm1,sdr->ctime); /* PLL */
+            dll(sdr,&sdr->trk.prm1,sdr->ctime); /* DLL */
+            sdr->trk.flagloopfilter=1;
+        }
+        else if (sdr->nav.swloop) 
+		{
+			//Using Parameters2
+            pll(sdr,&sdr->trk.prm2,(double)sdr->trk.loopms/1000);
+            dll(sdr,&sdr->trk.prm2,(double)sdr->trk.loopms/1000);
+            sdr->trk.flagloopfilter=2;
 
-                    /* plot correator output */
-                    if (loopcnt%((int)(plttrk.pltms/sdr->trk.loopms))==0&&
-                        sdrini.plttrk&&loopcnt>0) 
-					{
-                        plttrk.x=sdr->trk.corrx;
-                        memcpy(plttrk.y,sdr->trk.sumI, sizeof(double)*(sdr->trk.corrn*2+1));
-						//draw ABS values with a scale!
-                        plotthread(&plttrk); //plot tracking
-                    }
-                    
-                    /* LEX thread */
-                    if (sdrini.nchL6!=0&&sdr->no==sdrini.nch+1&&loopcnt>250) 
-                        setevent(hlexeve);
-
-                    loopcnt++;
-                }
-
-                if (sdr->no==1 && (cnt%(1000*10)==0)) //10s when cnt is in ms
-                    SDRPRINTF("Tracking process %d sec...\n",(int)cnt/(1000));
-				
-				// Display Tracking cycles diff.
-				if ((sdr->no == 1) && (sdrini.dispay_track_cycles != 0))
+            /* calculate observation data (published by seqlock) */
+			if (proc->loopcnt % (SNSMOOTHMS / sdr->trk.loopms) == 0)
+			{
+				setobsdata(sdr, proc->buffloc, proc->cnt, &sdr->trk, 1);
+				//Detect tracking loss
+				double summ_value = sdr->trk.Isum_fin / 1000.0;
+				if (summ_value < TRACK_LOST_SUMM)
 				{
-					high_resolution_clock::time_point t1 = high_resolution_clock::now();
-					auto nanosec = t1.time_since_epoch();
-					auto seconds = std::chrono::duration_cast<std::chrono::seconds>(nanosec);
-					long long sec = seconds.count();
-
-					if (pvev_seconds != sec)
+					sdr->trk.track_loss_cnt++;
+					if (sdr->trk.track_loss_cnt==
+						TRACK_RESTORE_TIME_MS/SNSMOOTHMS+1) {
+						teetrigger(); /* triggered capture on loss of lock */
+					}
+					if ((sdr->trk.track_loss_cnt > 
+						(TRACK_RESTORE_TIME_MS / SNSMOOTHMS)) && (sdrini.use_restore_acq != 0))
 					{
-						int diff = cnt - prev_cnt;
-						SDRPRINTF("Tracking cycles diff: %li\n", (int)diff);
-						pvev_seconds = sec;
-						prev_cnt = cnt;
+						restart_acquisition(sdr);
+						proc->cnt = 0;
 					}
 				}
-				
-				
-
-                /* write tracking log */
-				if (sdrini.log)
+				else
 				{
-					writelog(fp, &sdr->trk, &sdr->nav);
-					//SDRPRINTF("LOG write\n");
+					sdr->trk.track_loss_cnt = 0;
 				}
+			}
+            else
+                setobsdata(sdr,proc->buffloc,proc->cnt,&sdr->trk,0);
 
-                if (sdr->trk.flagloopfilter) 
-					clearcumsumcorr(&sdr->trk);
-                cnt++;
-				sdr->trk.track_cnt = cnt;
-                buffloc+=sdr->currnsamp;
+            /* plot correator output */
+            if (proc->loopcnt%((int)(proc->plttrk.pltms/sdr->trk.loopms))==0&&
+                sdrini.plttrk&&proc->loopcnt>0) 
+			{
+                proc->plttrk.x=sdr->trk.corrx;
+                memcpy(proc->plttrk.y,sdr->trk.sumI, sizeof(double)*(sdr->trk.corrn*2+1));
+				//draw ABS values with a scale!
+                plotthread(&proc->plttrk); //plot tracking
             }
+            
+            /* LEX thread */
+            if (sdrini.nchL6!=0&&sdr->no==sdrini.nch+1&&proc->loopcnt>250) 
+                setevent(hlexeve);
+
+            proc->loopcnt++;
         }
-        sdr->trk.buffloc=buffloc;
-    }//end of while
-    
+
+        if (sdr->no==1 && (proc->cnt%(1000*10)==0)) //10s when cnt is in ms
+            SDRPRINTF("Tracking process %d sec...\n",(int)proc->cnt/(1000));
+		
+		// Display Tracking cycles diff.
+		if ((sdr->no == 1) && (sdrini.dispay_track_cycles != 0))
+		{
+			high_resolution_clock::time_point t1 = high_resolution_clock::now();
+			auto nanosec = t1.time_since_epoch();
+			auto seconds = std::chrono::duration_cast<std::chrono::seconds>(nanosec);
+			long long sec = seconds.count();
+
+			if (proc->prevsec != sec)
+			{
+				int diff = (int)(proc->cnt - proc->prevcnt);
+				SDRPRINTF("Tracking cycles diff: %li\n", (int)diff);
+				proc->prevsec = sec;
+				proc->prevcnt = proc->cnt;
+			}
+		}
+
+        /* write tracking log */
+		if (sdrini.log)
+		{
+			writelog(proc->fp, &sdr->trk, &sdr->nav);
+			//SDRPRINTF("LOG write\n");
+		}
+
+        if (sdr->trk.flagloopfilter) 
+			clearcumsumcorr(&sdr->trk);
+        proc->cnt++;
+		sdr->trk.track_cnt = proc->cnt;
+        proc->buffloc+=sdr->currnsamp;
+    }
+    sdr->trk.buffloc=proc->buffloc;
+    return sdr->flagtrk;
+}
+/* terminate sdr channel processing --------------------------------------------
+* close tracking log file and plot windows of sdr channel
+* args   : sdrch_t *sdr     I   sdr channel struct
+*          sdrproc_t *proc  I/O sdr channel processing state struct
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void quitsdrproc(sdrch_t *sdr, sdrproc_t *proc)
+{
     if (sdrini.nchL6!=0&&sdr->no==sdrini.nch+1) 
         setevent(hlexeve);
     
     /* plot termination */
-    quitpltstruct(&pltacq,&plttrk);
+    quitpltstruct(&proc->pltacq,&proc->plttrk);
 
     /* close tracking log file */
 	if (sdrini.log)
 	{
 		SDRPRINTF("LOG closed\n");
-		closelog(fp);
+		closelog(proc->fp);
 	}
+    if (proc->acqpower!=NULL) free(proc->acqpower);
+    proc->acqpower=NULL;
 
     if (sdr->flagacq) 
 	{
         SDRPRINTF("SDR channel %s thread finished! Delay=%d [ms]\n",
-            sdr->satstr,(int)(bufflocnow-buffloc)/sdr->nsamp);
+            sdr->satstr,(int)(proc->bufflocnow-proc->buffloc)/sdr->nsamp);
     } 
 	else
 	{
         SDRPRINTF("SDR channel %s thread finished!\n",sdr->satstr);
     }
+}
+/* sdr channel thread ----------------------------------------------------------
+* sdr channel thread for signal acquisition and tracking . Every sat have its own thread
+* args   : void   *arg      I   sdr channel struct
+* return : none
+* note : This thread handles the acquisition and tracking of one of the signals. 
+*        The thread is created at startsdr function.
+*-----------------------------------------------------------------------------*/
+#ifdef WIN32
+extern void sdrthread(void *arg)
+#else
+extern void *sdrthread(void *arg)
+#endif
+{
+    sdrch_t *sdr=(sdrch_t*)arg;
+    sdrproc_t proc;
+
+    sdrbindrcv(sdr->rcv);
+
+    /* real-time priority and cpu affinity of channel thread */
+    sdrrtthread(RT_CH);
+
+    if (initsdrproc(sdr,&proc)<0) {
+        return THRETVAL;
+    }
+    //sleepms(sdr->no*500);
+    SDRPRINTF("**** %s sdr thread %d start! ****\n",sdr->satstr,sdr->no);
+
+    while (!sdrstat.stopflag) 
+	{
+        sdrproc(sdr,&proc);
+    }//end of while
+    
+    quitsdrproc(sdr,&proc);
 
     return THRETVAL;
 }
@@ -5,6 +5,82 @@
 *-----------------------------------------------------------------------------*/
 #include "sdr.h"
 
+static uint64_t framebits(const sdrnav_t *nav, int k, int len);
+
+/* push navigation frame -------------------------------------------------------
+* push snapshot of frame bits to navigation decode queue. in offline mode, the
+* frame is decoded immediately (deterministic)
+* args   : sdrch_t *sdr     I/O sdr channel struct
+*          uint64_t cnt     I   counter of sdr channel thread
+* return : none
+* note : if queue is full, the frame is dropped. if the first frame after
+*        preamble detection is dropped, frame synchronization is retried
+*-----------------------------------------------------------------------------*/
+static void navpush(sdrch_t *sdr, uint64_t cnt)
+{
+    sdrnavq_t *q=sdr->nav.q;
+    sdrnavfrm_t frm,*p=&frm;
+    int i,n=sdr->nav.flen+sdr->nav.addflen;
+
+    if (!sdrini.offline) {
+        if (q->wp-q->rp>=NAVQLEN) {
+            q->ndrop++;
+            SDRPRINTF("%s nav decode queue full!\n",sdr->satstr);
+            if (cnt==sdr->nav.firstsfcnt) { /* reference tow is not decoded */
+                sdr->nav.flagsyncf=OFF;
+                sdr->nav.flagtow=OFF;
+            }
+            return;
+        }
+        p=&q->frm[q->wp%NAVQLEN];
+    }
+    for (i=0;i<(n+31)/32;i++) {
+        p->bits[i]=(uint32_t)framebits(&sdr->nav,32*i,32);
+    }
+    p->cnt=cnt;
+    p->polarity=sdr->nav.polarity;
+    p->first=cnt==sdr->nav.firstsfcnt;
+    p->gen=sdr->nav.gen;
+
+    if (sdrini.offline) {
+        navdecode(sdr,p);
+        return;
+    }
+    sdrbarrier();
+    q->wp++;
+}
+/* apply navigation decode results ---------------------------------------------
+* set frame synchronization and reference tow by results of decoder. results
+* of previous frame synchronization are discarded
+* args   : sdrch_t *sdr     I/O sdr channel struct
+* return : none
+*-----------------------------------------------------------------------------*/
+static void navresult(sdrch_t *sdr)
+{
+    sdrnavq_t *q=sdr->nav.q;
+    sdrnavres_t *res;
+
+    while (q->rrp<q->rwp) {
+        sdrbarrier();
+        res=&q->res[q->rrp%NAVQLEN];
+
+        if (res->gen==sdr->nav.gen&&sdr->nav.flagtow) {
+            if (res->tow==0||res->reset) {
+                /* reset if tow does not decoded */
+                sdr->nav.flagsyncf=OFF;
+                sdr->nav.flagtow=OFF;
+            }
+            else if (res->first) {
+                sdr->nav.flagdec=ON;
+                sdr->nav.firstsftow=res->tow; /* tow */
+
+                if (sdr->nav.ctype==CTYPE_G1) sdr->prn=res->prn;
+            }
+        }
+        sdrbarrier();
+        q->rrp++;
+    }
+}
 /* sdr navigation data function ------------------------------------------------
 * decide navigation bit and decode navigation data
 * args   : sdrch_t *sdr     I/O sdr channel struct
@@ -14,8 +90,6 @@
 *-----------------------------------------------------------------------------*/
 extern void sdrnavigation(sdrch_t *sdr, uint64_t buffloc, uint64_t cnt)
 {
-    int sfn;
-
     sdr->nav.biti=cnt%sdr->nav.rate; /* current bit location for bit sync */
     sdr->nav.ocodei=(sdr->nav.biti-sdr->nav.synci-1); /* overlay code index */
     if (sdr->nav.ocodei<0) 
@@ -60,39 +134,21 @@ extern void sdrnavigation(sdrch_t *sdr, uint64_t buffloc, uint64_t cnt)
 					SDRPRINTF("*** find preamble! %s %d %d ***\n",
 						sdr->satstr, (int)cnt, sdr->nav.polarity);
 					sdr->nav.flagtow = ON;
+					sdr->nav.gen++;
 				}
 			}
         }
 
-        /* decoding navigation data */
+        /* decoding navigation data (decoder thread) */
         if (sdr->nav.flagtow && sdr->nav.swsync) 
 		{
             /* if frame bits are stored */
             if ((int)(cnt-sdr->nav.firstsfcnt) % sdr->nav.update==0) 
-			{
-                predecodefec(&sdr->nav); /* FEC decoding */
-                sfn=decodenav(&sdr->nav); /* navigation message decoding */
-                
-                SDRPRINTF("%s ID=%d tow:%.1f week=%d int_loop_cnt=%d\n",
-                    sdr->satstr,sfn,sdr->nav.sdreph.tow_gpst,
-                    sdr->nav.sdreph.week_gpst,(int)cnt);
-
-                /* set reference tow data */
-                if (sdr->nav.sdreph.tow_gpst==0) {
-                    /* reset if tow does not decoded */
-                    sdr->nav.flagsyncf=OFF;
-                    sdr->nav.flagtow=OFF;
-                } else if (cnt-sdr->nav.firstsfcnt==0) {
-                    sdr->nav.flagdec=ON;
-                    sdr->nav.sdreph.eph.sat=sdr->sat; /* satellite number */
-                    sdr->nav.firstsftow=sdr->nav.sdreph.tow_gpst; /* tow */
-
-                    if (sdr->nav.ctype==CTYPE_G1)
-                        sdr->prn=sdr->nav.sdreph.prn;
-                }
-            }
+                navpush(sdr,cnt);
         }
     }
+    /* set reference tow data */
+    navresult(sdr);
 }
 /* extract unsigned/signed bits ------------------------------------------------
 * extract unsigned/signed bits from byte data (two components case)
@@ -200,6 +256,149 @@ extern void interleave(const int *in, int row, int col, int *out)
         }
     }
 }
+/* push navigation bit to frame bit ring ---------------------------------------
+* append navigation bit to bit packed frame ring (O(1), no shift of frame)
+* args   : sdrnav_t *nav    I/O navigation struct
+*          int    bit       I   navigation bit (+1 or -1)
+* return : none
+*-----------------------------------------------------------------------------*/
+static void pushbit(sdrnav_t *nav, int bit)
+{
+    uint32_t i=(uint32_t)(nav->fhead&nav->fmask);
+
+    if (bit>0) nav->fring[i>>5]|=1u<<(i&31);
+    else       nav->fring[i>>5]&=~(1u<<(i&31));
+    nav->fhead++;
+}
+/* frame bit -------------------------------------------------------------------
+* read bit of current frame (last flen+addflen bits) from frame bit ring. for
+* FEC coded signal (SBAS/SAIF), raw frame bit is returned
+* args   : sdrnav_t *nav    I   navigation struct
+*          int    k         I   bit index in frame (0:oldest)
+* return : int                  frame bit (+1 or -1, 0:not received yet)
+*-----------------------------------------------------------------------------*/
+static int framebit(const sdrnav_t *nav, int k)
+{
+    int n=nav->flen+nav->addflen;
+    uint32_t i;
+
+    if (nav->fhead+k<(uint64_t)n) return 0;
+    i=(uint32_t)((nav->fhead-n+k)&nav->fmask);
+    return (nav->fring[i>>5]>>(i&31))&1?1:-1;
+}
+/* packed frame bits -----------------------------------------------------------
+* read bits of current frame from frame bit ring as packed word
+* args   : sdrnav_t *nav    I   navigation struct
+*          int    k         I   first bit index in frame (0:oldest)
+*          int    len       I   number of bits (<=64)
+* return : uint64_t             packed bits (bit i:frame bit k+i is +1)
+* note : frame must be filled (fhead>=flen+addflen)
+*-----------------------------------------------------------------------------*/
+static uint64_t framebits(const sdrnav_t *nav, int k, int len)
+{
+    uint64_t w=0;
+    uint32_t i=(uint32_t)((nav->fhead-(nav->flen+nav->addflen)+k)&nav->fmask);
+    int n,m;
+
+    for (n=0;n<len;n+=m,i=(i+m)&nav->fmask) {
+        m=32-(i&31);
+        w|=(uint64_t)(nav->fring[i>>5]>>(i&31))<<n;
+    }
+    return len<64?w&((1ULL<<len)-1):w;
+}
+/* preamble correlation --------------------------------------------------------
+* correlation of packed bits and packed preamble by XOR and popcount
+* args   : uint64_t bits    I   packed bits
+*          uint64_t pre     I   packed preamble
+*          int    len       I   preamble length (bits) (<=64)
+* return : int                  correlation (len:match -len:inverted match)
+*-----------------------------------------------------------------------------*/
+static int precorr(uint64_t bits, uint64_t pre, int len)
+{
+    uint64_t mask=len<64?(1ULL<<len)-1:~0ULL;
+
+    return len-2*popcnt64((bits^pre)&mask);
+}
+/* decoded frame bits of sliding window decoder --------------------------------
+* read decoded bits of current SBAS/SAIF frame from sliding window decoder of
+* the symbol phase of frame
+* args   : sdrnav_t *nav    I   navigation struct
+*          int    j         I   first decoded bit index in frame (0:oldest)
+*          int    len       I   number of bits (<=64)
+*          uint64_t *bits   O   packed bits (bit i:decoded bit j+i is +1)
+* return : int                  1:okay 0:bits are not decoded yet
+*-----------------------------------------------------------------------------*/
+static int vitframe(const sdrnav_t *nav, int j, int len, uint64_t *bits)
+{
+    uint64_t x=nav->fhead-(nav->flen+nav->addflen)+2*j+1; /* pair end */
+    const sdrvit_t *vit=&nav->vit[x&1];
+    uint64_t x0=vit->sym-2*vit->n; /* pair end of first step */
+
+    if (vit->n<=VITTB||x<x0||(x-x0)/2+len>vit->n-VITTB) return 0;
+
+    *bits=vitbits(vit,(x-x0)/2,len);
+    return 1;
+}
+/* feed sliding window decoder -------------------------------------------------
+* decode new symbol pairs of SBAS/SAIF frame by sliding window decoder of the
+* symbol phase of last symbol. decoder is restarted from the oldest symbol of
+* frame if symbols were not fed (e.g. during frame lock)
+* args   : sdrnav_t *nav    I/O navigation struct
+* return : none
+*-----------------------------------------------------------------------------*/
+static void vitfeed(sdrnav_t *nav)
+{
+    uint64_t e=nav->fhead-1,lo,x;
+    int n=nav->flen+nav->addflen;
+    sdrvit_t *vit;
+
+    if (nav->fhead<2) return;
+    vit=&nav->vit[e&1];
+
+    /* oldest pair end of frame */
+    lo=e>=(uint64_t)(n-2)?e-(n-2):(e&1?1:2);
+
+    if (vit->n==0||vit->sym<lo) {
+        vitinit(vit);
+        vit->sym=lo;
+    }
+    for (;vit->sym<=e;vit->sym+=2) {
+        x=vit->sym;
+        vitupdate(vit,
+            !((nav->fring[((x-1)&nav->fmask)>>5]>>((x-1)&31))&1),
+            !((nav->fring[(x&nav->fmask)>>5]>>(x&31))&1));
+    }
+}
+/* linearize frame bits --------------------------------------------------------
+* copy current frame from frame bit ring (or sliding window decoder for SBAS/
+* SAIF before frame lock) to decoded frame bits if the ring is updated after
+* last copy
+* args   : sdrnav_t *nav    I/O navigation struct
+* return : none
+*-----------------------------------------------------------------------------*/
+static void linearbits(sdrnav_t *nav)
+{
+    uint64_t w;
+    int i,j;
+
+    if (nav->fview==nav->fhead) return;
+
+    if (nav->ctype==CTYPE_L1SAIF||nav->ctype==CTYPE_L1SBAS) {
+        if (nav->flagtow) return; /* decoded by block decoder */
+
+        for (j=0;j<nav->flen/2&&vitframe(nav,j,32,&w);j+=32) {
+            for (i=0;i<32&&j+i<nav->flen/2;i++) {
+                nav->fbitsdec[j+i]=(w>>i)&1?1:-1;
+            }
+        }
+    }
+    else {
+        for (i=0;i<nav->flen+nav->addflen;i++) {
+            nav->fbitsdec[i]=framebit(nav,i);
+        }
+    }
+    nav->fview=nav->fhead;
+}
 /* navigation bit synchronization ----------------------------------------------
 * check synchronization of navigation bit
 * args   : double IP        I   correlation output (IP data)
@@ -209,19 +408,18 @@ extern void interleave(const int *in, int row, int col, int *out)
 *-----------------------------------------------------------------------------*/
 extern int checksync(double IP, double IPold, sdrnav_t *nav)
 {
-    int i,corr=0,maxi;
+    uint32_t mask;
+    int maxi;
     
     /* BeiDou MEO/IGSO satellite (secondary code is NH20) */
     if (nav->ctype==CTYPE_B1I&&nav->sdreph.prn>5) {
-        shiftdata(&nav->bitsync[0],&nav->bitsync[1],sizeof(int),nav->rate-1);
-        nav->bitsync[nav->rate-1]=(IP<0?-1:1);
-        
-        /* correlation between NH20 */
-        for (i=0;i<nav->rate;i++)
-            corr+=nav->ocode[i]*nav->bitsync[i];
-        
-        /* if synchronization success */
-        if (abs(corr)==nav->rate) {
+        mask=(1u<<nav->rate)-1;
+        nav->nhreg=((nav->nhreg<<1)|(IP<0?1:0))&mask;
+        if (nav->nhcnt<nav->rate) nav->nhcnt++;
+
+        /* correlation between NH20 (all signs match or all inverted) */
+        if (nav->nhcnt==nav->rate&&((nav->nhreg^nav->nhcode)==0||
+            (nav->nhreg^nav->nhcode)==mask)) {
             nav->synci=nav->biti; /* synchronization bit index */
             return 1;
         }
@@ -292,9 +490,7 @@ extern int checkbit(double IP, int loopms, sdrnav_t *nav)
         nav->bit= (nav->bitIP < 0) ? -polarity: polarity;
 
         /* set bit*/
-        shiftdata(&nav->fbits[0],&nav->fbits[1],sizeof(int),
-            nav->flen+nav->addflen-1); /* shift to left */
-        nav->fbits[nav->flen+nav->addflen-1] = nav->bit; /* add last */
+        pushbit(nav,nav->bit);
         nav->swsync=ON;
     }
     nav->cnt++;
@@ -314,22 +510,23 @@ extern void predecodefec(sdrnav_t *nav)
     int dec2[NAVFLEN_SBAS/2];
 
     /* GPS/QZS L1CA / GLONASS G1 / Galileo E1B / BeiDou B1I */
-    if (nav->ctype==CTYPE_L1CA ||
-        nav->ctype==CTYPE_G1   ||
-        nav->ctype==CTYPE_B1I  ||
-        nav->ctype==CTYPE_E1B) {
-        /* FEC is not used before preamble detection */
-        memcpy(nav->fbitsdec,nav->fbits,sizeof(int)*(nav->flen+nav->addflen));
-    }
+    /* FEC is not used before preamble detection. frame bits are read from
+       ring by findpreamble() and linearized lazily by linearbits() */
+
     /* SBAS L1 / QZS L1SAIF */
     if (nav->ctype==CTYPE_L1SAIF||nav->ctype==CTYPE_L1SBAS) 
 	{
+        /* before frame lock: sliding window decoder (new symbols only) */
+        if (!nav->flagtow) {
+            vitfeed(nav);
+            return;
+        }
         /* 1/2 convolutional code */
-        init_viterbi27_port(nav->fec,0);
+        init_viterbi27(nav->fec,0);
         for (i=0;i<NAVFLEN_SBAS+NAVADDFLEN_SBAS;i++)
-            enc[i]=(nav->fbits[i]==1)? 0:255;
-        update_viterbi27_blk_port(nav->fec,enc,(nav->flen+nav->addflen)/2);
-        chainback_viterbi27_port(nav->fec,dec,nav->flen/2,0);
+            enc[i]=(framebit(nav,i)==1)? 0:255;
+        update_viterbi27_blk(nav->fec,enc,(nav->flen+nav->addflen)/2);
+        chainback_viterbi27(nav->fec,dec,nav->flen/2,0);
         for (i=0;i<94;i++) {
             for (j=0;j<8;j++) {
                 dec2[8*i+j]=((dec[i]<<j)&0x80)>>7;
@@ -348,34 +545,28 @@ extern void predecodefec(sdrnav_t *nav)
 *-----------------------------------------------------------------------------*/
 extern int paritycheck(sdrnav_t *nav)
 {
-    int i,j,stat=0,crc,bits[MAXBITS];
-    unsigned char bin[29]={0},pbin[3];
-
-    /* copy */
-    for (i=0;i<nav->flen+nav->addflen;i++) 
-        bits[i]=nav->polarity*nav->fbitsdec[i];
+    uint32_t w,inv=nav->polarity>0?0xFFFFFFFF:0;
+    unsigned char bin[29]={0},pbin[3]={0};
+    int i,crc;
 
     /* GPS/QZS L1CA parity check */
     if (nav->ctype==CTYPE_L1CA) {
-        /* chacking all words */
+        /* chacking all words (packed word of ring, bit i:-1) */
         for (i=0;i<10;i++) {
-            /* bit inversion */
-            if (bits[i*30+1]==-1) {
-                for (j=2;j<26;j++) 
-                    bits[i*30+j]*=-1;
-            }
-            stat+=paritycheck_l1ca(&bits[i*30]);
+            w=(uint32_t)framebits(nav,i*30,32)^inv;
+            if (w&2) w^=0x03FFFFFC; /* bit inversion */
+            if (!paritycheck_l1ca(w)) return 0;
         }
         /* all parities are correct */
-        if (stat==10) {
-            return 1;
-        }
+        return 1;
     }
     /* SBAS L1 / QZS SAIF parity check */
     if (nav->ctype==CTYPE_L1SAIF||nav->ctype==CTYPE_L1SBAS) {
-        bits2byte(&bits[0],226,29,1,bin);
-        bits2byte(&bits[226],24,3,0,pbin);
-
+        for (i=0;i<250;i++) {
+            if (nav->polarity*nav->fbitsdec[i]>0) continue; /* -1=>1, 1=>0 */
+            if (i<226) setbitu(bin,i+6,1,1);
+            else       setbitu(pbin,i-226,1,1);
+        }
         /* compute CRC24 */
         crc=crc24q(bin,29);
         if (crc==getbitu(pbin,0,24)) {
@@ -398,41 +589,44 @@ extern int paritycheck(sdrnav_t *nav)
 *-----------------------------------------------------------------------------*/
 extern int findpreamble(sdrnav_t *nav)
 {
-    int i,corr=0;
+    uint64_t b1,b2;
+    int len=nav->prelen,corr=0,c1,c2;
+
+    /* frame is not filled */
+    if (nav->fhead<(uint64_t)(nav->flen+nav->addflen)) return 0;
 
     /* GPS/QZS L1CA / BeiDou B1I*/
     if (nav->ctype==CTYPE_L1CA || nav->ctype==CTYPE_B1I) {
-        for (i=0;i<nav->prelen;i++)
-            corr+=(nav->fbitsdec[nav->addflen+i] * nav->prebits[i]); //correlation
+        corr=precorr(framebits(nav,nav->addflen,len),nav->prepack,len);
     }
     /* L1-SBAS/SAIF */
     /* check 2 preambles */
     if (nav->ctype==CTYPE_L1SAIF||nav->ctype==CTYPE_L1SBAS) {
-        for (i=0;i<nav->prelen/2;i++) {
-            corr+=(nav->fbitsdec[i    ]*nav->prebits[ 0+i]);
-            corr+=(nav->fbitsdec[i+250]*nav->prebits[ 8+i]);
+        if (!vitframe(nav,0,len/2,&b1)||!vitframe(nav,250,len/2,&b2)) {
+            return 0;
         }
+        c1=precorr(b1,nav->prepack,len/2);
+        c2=precorr(b2,nav->prepack>>len/2,len/2);
+        corr=c1+c2;
     }
     /*  GLONASS G1 */
     /* time mark is last in word */
     if (nav->ctype==CTYPE_G1) {
-        for (i=0;i<nav->prelen;i++)
-            corr+=(nav->fbitsdec[nav->flen-nav->prelen+i]*nav->prebits[i]);
+        corr=precorr(framebits(nav,nav->flen-len,len),nav->prepack,len);
     }
     /* Galileo E1B */
     /* check preambles in two words */
     if (nav->ctype==CTYPE_E1B) {
-        for (i=0;i<nav->prelen;i++)
-            corr+=(nav->fbitsdec[i]*nav->prebits[i]);
-        for (i=0;i<nav->prelen;i++)
-            corr+=(nav->fbitsdec[i+250]*nav->prebits[i]);
-        corr=(int)(corr/2);
+        c1=precorr(framebits(nav,0,len),nav->prepack,len);
+        c2=precorr(framebits(nav,250,len),nav->prepack,len);
+        corr=c1==c2?c1:0;
     }
     /* check preamble match */
     if (abs(corr)==nav->prelen) 
 	{ 
 		/* preamble matched */
         nav->polarity = corr>0 ? 1: -1; /* set bit polarity */
+        linearbits(nav); /* preamble candidate: linearize frame bits */
         /* parity check */
         if (paritycheck(nav)) {
             return 1;
@@ -453,6 +647,8 @@ extern int findpreamble(sdrnav_t *nav)
 *-----------------------------------------------------------------------------*/
 extern int decodenav(sdrnav_t *nav)
 {
+    linearbits(nav);
+
     switch (nav->ctype) {
         /* GPS/QZSS L1CA (LNAV) */
         case CTYPE_L1CA:
@@ -430,7 +430,7 @@ extern int decode_b1i(sdrnav_t *nav)
     uint8_t bin[38]; /* 300/8 byte */
 
     /* copy navigation bits (there are 300 bits in 1 subframe, bit is +1/-1) */
-    for (i=0;i<nav->flen;i++) bits[i]=nav->polarity*nav->fbits[i];
+    for (i=0;i<nav->flen;i++) bits[i]=nav->polarity*nav->fbitsdec[i];
     
     /* deinterleave and BCH decoding */
     for (i=0;i<10;i++) {
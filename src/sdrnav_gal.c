@@ -316,10 +316,10 @@ extern int decode_e1b(sdrnav_t *nav)
     uint8_t enc_e1b[240],dec_e1b1[15],dec_e1b2[15];
 
     /* copy navigation bits (500 bits in 1 page) */
-    for (i=0;i<nav->flen;i++) bits[i]=nav->polarity*nav->fbits[i];
+    for (i=0;i<nav->flen;i++) bits[i]=nav->polarity*nav->fbitsdec[i];
 
     /* initialize viterbi decoder */
-    init_viterbi27_port(nav->fec,0);
+    init_viterbi27(nav->fec,0);
         
     /* deinterleave (30 rows x 8 columns) see Galileo SISICD Table 28, pp. 27 */
     interleave(&bits[10],30,8,bits_e1b);
@@ -333,11 +333,11 @@ extern int decode_e1b(sdrnav_t *nav)
     }
 
     /* decode first page part */
-    update_viterbi27_blk_port(nav->fec,enc_e1b,120);
-    chainback_viterbi27_port(nav->fec,dec_e1b1,120-6,0);
+    update_viterbi27_blk(nav->fec,enc_e1b,120);
+    chainback_viterbi27(nav->fec,dec_e1b1,120-6,0);
 
     /* initialize viterbi decoder */
-    init_viterbi27_port(nav->fec,0);
+    init_viterbi27(nav->fec,0);
                 
     /* deinterleave (30 rows x 8 columns) see Galileo SISICD Table 28, pp. 27 */
     interleave(&bits[260],30,8,bits_e1b);
@@ -351,8 +351,8 @@ extern int decode_e1b(sdrnav_t *nav)
     }
 
     /* decode second page part */
-    update_viterbi27_blk_port(nav->fec,enc_e1b,120);
-    chainback_viterbi27_port(nav->fec,dec_e1b2,120-6,0);
+    update_viterbi27_blk(nav->fec,enc_e1b,120);
+    chainback_viterbi27(nav->fec,dec_e1b2,120-6,0);
         
     /* check page part (even/odd) */
     if (getbitu(dec_e1b1,0,1)) { /* if first page part is odd */
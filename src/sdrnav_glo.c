@@ -204,9 +204,9 @@ extern int decode_g1(sdrnav_t *nav)
     /* remove meandr from data */
     for (i=0;i<170;i++) {
         if (i%2==0)
-            bits1[i]= nav->polarity*nav->fbits[i];
+            bits1[i]= nav->polarity*nav->fbitsdec[i];
         else
-            bits1[i]=-nav->polarity*nav->fbits[i];
+            bits1[i]=-nav->polarity*nav->fbitsdec[i];
     }
     for (i=0;i<84;i++) {
         bits2[i+1]=bits1[2*i]*bits1[2*(i+1)];
@@ -164,33 +164,24 @@ int decode_frame_l1ca(const uint8_t *buff, sdreph_t *eph)
     return id;
 }
 /* parity check ----------------------------------------------------------------
-* GPS/QZS L1CA parity check function
-* args   : int    *bits     I   navigation bits (2+30 bits)
+* GPS/QZS L1CA parity check function. each parity mask selects the data bits
+* of a parity equation (IS-GPS-200 20.3.5.2) and its parity bit, so the word
+* is correct if all masked words have even weight
+* args   : uint32_t w       I   navigation bits (2+30 bits, bit i:bit i is -1)
 * return : int                  1:okay 0: wrong parity
+* note : data bits must be already inverted by D30*
 *-----------------------------------------------------------------------------*/
-extern int paritycheck_l1ca(int *bits)
+extern int paritycheck_l1ca(uint32_t w)
 {
-    int i,stat=0;
-    int pbits[6];
+    static const uint32_t mask[6]={
+        0x052CF8DD,0x0A59F1BA,0x10B3E375,0x2167C6EA,0x42CF8DD6,0x83915ED1
+    };
+    int i;
 
-    /* calculate parity bits*/
-    pbits[0]=bits[0]*bits[2]*bits[3]*bits[4]*bits[6]*bits[7 ]*bits[11]*bits[12]*
-        bits[13]*bits[14]*bits[15]*bits[18]*bits[19]*bits[21]*bits[24];
-    pbits[1]=bits[1]*bits[3]*bits[4]*bits[5]*bits[7]*bits[8 ]*bits[12]*bits[13]*
-        bits[14]*bits[15]*bits[16]*bits[19]*bits[20]*bits[22]*bits[25];
-    pbits[2]=bits[0]*bits[2]*bits[4]*bits[5]*bits[6]*bits[8 ]*bits[9 ]*bits[13]*
-        bits[14]*bits[15]*bits[16]*bits[17]*bits[20]*bits[21]*bits[23];
-    pbits[3]=bits[1]*bits[3]*bits[5]*bits[6]*bits[7]*bits[9 ]*bits[10]*bits[14]*
-        bits[15]*bits[16]*bits[17]*bits[18]*bits[21]*bits[22]*bits[24];
-    pbits[4]=bits[1]*bits[2]*bits[4]*bits[6]*bits[7]*bits[8 ]*bits[10]*bits[11]*
-        bits[15]*bits[16]*bits[17]*bits[18]*bits[19]*bits[22]*bits[23]*bits[25];
-    pbits[5]=bits[0]*bits[4]*bits[6]*bits[7]*bits[9]*bits[10]*bits[11]*bits[12]*
-        bits[14]*bits[16]*bits[20]*bits[23]*bits[24]*bits[25];
-
-    for (i=0;i<6;i++) stat+=(pbits[i]-bits[26+i]);
-    if (stat==0) return 1; /* parity is matched */
-
-    return 0;
+    for (i=0;i<6;i++) {
+        if (popcnt64(w&mask[i])&1) return 0;
+    }
+    return 1; /* parity is matched */
 }
 /* decode GPS/QZS L1CA navigation data -----------------------------------------
 * decode GPS/QZS L1CA navigation data and extract ephemeris
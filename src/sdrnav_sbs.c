@@ -101,6 +101,8 @@ extern int decode_l1sbas(sdrnav_t *nav)
 {
     int i,crc,crcmsg,bits[250];
     uint8_t bin[29]={0},pbin[3];
+    sdrtrksnap_t snap;
+    sdreph_t eph;
 
     /* copy navigation bits (250 bits/sec) */
     for (i=0;i<250;i++) bits[i]=nav->polarity*nav->fbitsdec[i];
@@ -121,9 +123,11 @@ extern int decode_l1sbas(sdrnav_t *nav)
     decode_msg_sbas(nav->sbas.msg,&nav->sbas);
 
     /* tentative: get tow from other channel */
-    if (sdrini.nch>1&&sdrch[sdrini.nch-2].nav.sdreph.week_gpst!=0) {
-        nav->sbas.tow=sdrch[sdrini.nch-2].trk.tow[0];
-        nav->sbas.week=sdrch[sdrini.nch-2].nav.sdreph.week_gpst;
+    if (sdrini.nch>1) navgeteph(&sdrch[sdrini.nch-2].nav,&eph);
+    if (sdrini.nch>1&&eph.week_gpst!=0) {
+        trkgetsnap(&sdrch[sdrini.nch-2].trk,&snap);
+        nav->sbas.tow=snap.tow;
+        nav->sbas.week=eph.week_gpst;
     }
 
     /* generate NovAtel sbas message */
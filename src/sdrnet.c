@@ -0,0 +1,739 @@
+/*------------------------------------------------------------------------------
+* sdrnet.c : network IF stream front end functions
+*
+* Copyright (C) 2014 Taro Suzuki <gnsssdrlib@gmail.com>
+*
+* protocols:
+*     RTLTCP : rtl_tcp server (TCP). 12 bytes dongle info {"RTL0",tuner type,
+*              number of gains} followed by unsigned 8-bit I/Q data. sampling
+*              and center frequency are set by 5 bytes commands {cmd,param}
+*     TCP    : framed int8 data over TCP
+*     UDP    : framed int8 data over UDP (one frame per datagram)
+*
+* frame of TCP/UDP (little-endian):
+*     offset  size  field
+*          0     4  identifier "GSDR"
+*          4     2  payload length (bytes, max NETMAXPKT)
+*          6     2  flags (bit0: end of stream)
+*          8     8  sequence: stream offset of first payload byte (bytes)
+*         16     -  payload (int8 data, I/Q interleaved)
+*
+* payloads are received directly to memory buffer. lost data detected by the
+* sequence are filled by zero, late or duplicated frames are discarded
+*-----------------------------------------------------------------------------*/
+#if defined(__linux__)
+#define _GNU_SOURCE /* recvmmsg */
+#endif
+#include "sdr.h"
+
+#ifdef WIN32
+#define socklen_t int
+static int istimeout(void) {return WSAGetLastError()==WSAETIMEDOUT;}
+#else
+#include <unistd.h>
+#include <errno.h>
+#include <netdb.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define INVALID_SOCKET     -1
+#define SOCKET_ERROR       -1
+#define closesocket        close
+typedef int SOCKET;
+
+static int istimeout(void) {return errno==EAGAIN||errno==EWOULDBLOCK||
+                                   errno==EINTR;}
+#endif
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL       0
+#endif
+
+#define NETMAGIC      "GSDR"           /* identifier of frame */
+#define NETF_EOS      0x01             /* frame flag: end of stream */
+#define NETPOLL       200              /* receive timeout of socket (ms) */
+#define RTLTCPCHUNK   16384            /* send size of rtl_tcp replay (bytes) */
+
+/* protocol name -------------------------------------------------------------*/
+extern int netprotocol(const char *str)
+{
+    if (!strcmp(str,"RTLTCP")||!strcmp(str,"rtltcp")) return NETP_RTLTCP;
+    if (!strcmp(str,"TCP")   ||!strcmp(str,"tcp"))    return NETP_TCP;
+    if (!strcmp(str,"UDP")   ||!strcmp(str,"udp"))    return NETP_UDP;
+    return -1;
+}
+/* encode/decode frame header ------------------------------------------------*/
+static void encodehdr(uint8_t *p, int len, int flag, uint64_t off)
+{
+    int i;
+
+    memcpy(p,NETMAGIC,4);
+    p[4]=(uint8_t)len; p[5]=(uint8_t)(len>>8);
+    p[6]=(uint8_t)flag; p[7]=(uint8_t)(flag>>8);
+    for (i=0;i<8;i++) p[8+i]=(uint8_t)(off>>(8*i));
+}
+static int decodehdr(const uint8_t *p, int *len, int *flag, uint64_t *off)
+{
+    int i;
+
+    if (memcmp(p,NETMAGIC,4)) return 0;
+    *len=p[4]|(p[5]<<8);
+    *flag=p[6]|(p[7]<<8);
+    for (*off=0,i=7;i>=0;i--) *off=(*off<<8)|p[8+i];
+    return 1;
+}
+/* memory buffer access --------------------------------------------------------
+* stream position (bytes) is mapped to memory buffer cyclically. ringput()
+* writes data (NULL: zero) and ringget() reads data across the end of buffer
+*-----------------------------------------------------------------------------*/
+static char *ringptr(const sdrnet_t *net, uint64_t pos)
+{
+    return (char *)sdrstat.buff+pos%net->ringlen;
+}
+static int ringspan(const sdrnet_t *net, uint64_t pos, int n)
+{
+    uint64_t m=net->ringlen-pos%net->ringlen;
+    return (uint64_t)n<m?n:(int)m;
+}
+static void ringput(sdrnet_t *net, uint64_t pos, const char *p, int n)
+{
+    int m=ringspan(net,pos,n);
+
+    if (p) {
+        memcpy(ringptr(net,pos),p,m);
+        memcpy(sdrstat.buff,p+m,n-m);
+    }
+    else {
+        memset(ringptr(net,pos),0,m);
+        memset(sdrstat.buff,0,n-m);
+    }
+}
+static void ringget(const sdrnet_t *net, uint64_t pos, char *p, int n)
+{
+    int m=ringspan(net,pos,n);
+
+    memcpy(p,ringptr(net,pos),m);
+    memcpy(p+m,sdrstat.buff,n-m);
+}
+/* place frame data ------------------------------------------------------------
+* place data of out-of-order frame to memory buffer. gap to the frame is
+* filled by zero. too large gap (stream restart) shifts the stream origin
+* args   : sdrnet_t *net    I/O network stream struct
+*          uint64_t off     I   sequence of frame (bytes)
+*          char   *p        I   payload of frame
+*          int    n         I   payload length (bytes)
+* return : none
+*-----------------------------------------------------------------------------*/
+static void place(sdrnet_t *net, uint64_t off, const char *p, int n)
+{
+    uint64_t gap;
+
+    if (!net->sync) {
+        net->org=off;
+        net->sync=1;
+    }
+    if (off<net->org||off-net->org+n<=net->wpos) {
+        net->nlate++;
+        return;
+    }
+    off-=net->org;
+
+    if (off<net->wpos) { /* partially duplicated */
+        p+=net->wpos-off;
+        n-=(int)(net->wpos-off);
+    }
+    else if ((gap=off-net->wpos)>0) {
+        net->nlost+=n>0?(gap+n-1)/n:1;
+
+        if (gap>net->ringlen/4) {
+            SDRPRINTF("warning: network stream discontinuity: %.0f bytes\n",
+                (double)gap);
+            net->org+=gap;
+        }
+        else {
+            ringput(net,net->wpos,NULL,(int)gap);
+            net->nfill+=gap;
+            net->wpos+=gap;
+        }
+    }
+    ringput(net,net->wpos,p,n);
+    net->wpos+=n;
+}
+/* publish filled blocks of memory buffer ------------------------------------*/
+static void publish(sdrnet_t *net)
+{
+    while ((sdrstat.buffcnt+1)*(uint64_t)net->blklen<=net->wpos) {
+        mlock(hreadmtx);
+        sdrstat.buffcnt++;
+        unmlock(hreadmtx);
+        teepush();
+    }
+}
+/* closed connection ---------------------------------------------------------*/
+static int closed(sdrnet_t *net, int ret)
+{
+    if (ret<0) return -1;
+    SDRPRINTF("network stream: connection closed\n");
+    net->eos=1;
+    return 0;
+}
+/* receive all data ------------------------------------------------------------
+* receive n bytes from stream socket
+* args   : sdrnet_t *net    I   network stream struct
+*          char   *p        O   received data
+*          int    n         I   number of bytes
+* return : int                  n:okay 0:closed -1:error or timeout
+*-----------------------------------------------------------------------------*/
+static int recvall(sdrnet_t *net, char *p, int n)
+{
+    unsigned int tick=tickget();
+    int r,m=0;
+
+    while (m<n) {
+        if ((r=recv(net->soc,p+m,n-m,0))>0) {
+            m+=r;
+            tick=tickget();
+            continue;
+        }
+        if (r==0) return 0;
+        if (!istimeout()||sdrstat.stopflag||
+            (int)(tickget()-tick)>NETTIMEOUT) return -1;
+    }
+    return n;
+}
+/* receive rtl_tcp stream ------------------------------------------------------
+* receive unsigned 8-bit data to memory buffer up to end of current block and
+* convert to int8 data in place
+* args   : sdrnet_t *net    I/O network stream struct
+* return : int                  received bytes (0: timeout, -1: error)
+*-----------------------------------------------------------------------------*/
+static int recvrtltcp(sdrnet_t *net)
+{
+    char *p=ringptr(net,net->wpos);
+    int r,n=net->blklen-(int)(net->wpos%net->blklen);
+
+    if ((r=recv(net->soc,p,n,0))>0) {
+        convu8((const uint8_t *)p,r,p);
+        net->wpos+=r;
+        return r;
+    }
+    if (r==0) return closed(net,0);
+    return istimeout()?0:-1;
+}
+/* receive framed TCP stream ---------------------------------------------------
+* receive one frame. payload in sequence is received to memory buffer directly
+* args   : sdrnet_t *net    I/O network stream struct
+* return : int                  1:received 0:timeout or closed -1:error
+*-----------------------------------------------------------------------------*/
+static int recvtcp(sdrnet_t *net)
+{
+    uint64_t off;
+    int r,n,len,flag;
+
+    /* wait for frame without consuming partial header */
+    if ((r=recv(net->soc,(char *)net->hdr,NETHDRLEN,MSG_PEEK))==0) {
+        return closed(net,0);
+    }
+    if (r<0) return istimeout()?0:-1;
+    if ((r=recvall(net,(char *)net->hdr,NETHDRLEN))<=0) return closed(net,r);
+
+    if (!decodehdr(net->hdr,&len,&flag,&off)||len>NETMAXPKT) {
+        SDRPRINTF("error: wrong frame header of network stream\n");
+        return -1;
+    }
+    if (flag&NETF_EOS) {
+        net->eos=1;
+        return 1;
+    }
+    net->npkt++;
+    if (!net->sync) {
+        net->org=off;
+        net->sync=1;
+    }
+    if (off>=net->org&&off-net->org==net->wpos) {
+        n=ringspan(net,net->wpos,len);
+        if ((r=recvall(net,ringptr(net,net->wpos),n))<=0||(n<len&&
+            (r=recvall(net,(char *)sdrstat.buff,len-n))<=0)) {
+            return closed(net,r);
+        }
+        net->wpos+=len;
+    }
+    else {
+        if ((r=recvall(net,net->tmp,len))<=0) return closed(net,r);
+        place(net,off,net->tmp,len);
+    }
+    return 1;
+}
+/* scatter buffers of datagram -------------------------------------------------
+* header of packet i is received to header buffer and payload to slot i of
+* memory buffer from head of stream
+* args   : sdrnet_t *net    I   network stream struct
+*          int    i         I   packet index in batch
+*          int    slot      I   slot length of payload (bytes)
+*          char   **p       O   buffers
+*          int    *n        O   buffer lengths (bytes)
+* return : int                  number of buffers
+*-----------------------------------------------------------------------------*/
+static int scatter(const sdrnet_t *net, int i, int slot, char **p, int *n)
+{
+    uint64_t pos=net->wpos+(uint64_t)i*slot;
+
+    p[0]=(char *)net->hdr+i*NETHDRLEN;
+    n[0]=NETHDRLEN;
+    p[1]=ringptr(net,pos);
+    n[1]=ringspan(net,pos,slot);
+    if (n[1]==slot) return 2;
+    p[2]=(char *)sdrstat.buff;
+    n[2]=slot-n[1];
+    return 3;
+}
+/* receive datagrams -----------------------------------------------------------
+* receive batch of datagrams by one system call (recvmmsg) if available
+* args   : sdrnet_t *net    I   network stream struct
+*          int    npkt      I   max number of packets
+*          int    slot      I   slot length of payload (bytes)
+*          int    *len      O   payload length of packets (-1: truncated)
+* return : int                  number of packets (0: timeout, -1: error)
+*-----------------------------------------------------------------------------*/
+static int recvpkts(sdrnet_t *net, int npkt, int slot, int *len)
+{
+    char *p[3];
+    int k,n[3],nb;
+#ifdef WIN32
+    WSABUF buf[3];
+    DWORD nr=0,flag=0;
+
+    nb=scatter(net,0,slot,p,n);
+    for (k=0;k<nb;k++) {
+        buf[k].buf=p[k];
+        buf[k].len=n[k];
+    }
+    if (WSARecv(net->soc,buf,nb,&nr,&flag,NULL,NULL)==SOCKET_ERROR) {
+        if (WSAGetLastError()==WSAEMSGSIZE) {
+            len[0]=-1;
+            return 1;
+        }
+        return istimeout()?0:-1;
+    }
+    len[0]=(int)nr<NETHDRLEN?-1:(int)nr-NETHDRLEN;
+    return 1;
+#elif defined(__linux__)
+    struct mmsghdr msg[NETBATCH];
+    struct iovec iov[NETBATCH][3];
+    int i,m;
+
+    memset(msg,0,sizeof(struct mmsghdr)*npkt);
+    for (i=0;i<npkt;i++) {
+        nb=scatter(net,i,slot,p,n);
+        for (k=0;k<nb;k++) {
+            iov[i][k].iov_base=p[k];
+            iov[i][k].iov_len=n[k];
+        }
+        msg[i].msg_hdr.msg_iov=iov[i];
+        msg[i].msg_hdr.msg_iovlen=nb;
+    }
+    if ((m=recvmmsg(net->soc,msg,npkt,MSG_WAITFORONE,NULL))<0) {
+        return istimeout()?0:-1;
+    }
+    for (i=0;i<m;i++) {
+        len[i]=(msg[i].msg_hdr.msg_flags&MSG_TRUNC)||
+            msg[i].msg_len<NETHDRLEN?-1:(int)msg[i].msg_len-NETHDRLEN;
+    }
+    return m;
+#else
+    struct msghdr msg;
+    struct iovec iov[3];
+    ssize_t r;
+
+    memset(&msg,0,sizeof(msg));
+    nb=scatter(net,0,slot,p,n);
+    for (k=0;k<nb;k++) {
+        iov[k].iov_base=p[k];
+        iov[k].iov_len=n[k];
+    }
+    msg.msg_iov=iov;
+    msg.msg_iovlen=nb;
+    if ((r=recvmsg(net->soc,&msg,0))<0) return istimeout()?0:-1;
+    len[0]=(msg.msg_flags&MSG_TRUNC)||r<NETHDRLEN?-1:(int)r-NETHDRLEN;
+    return 1;
+#endif
+}
+/* receive UDP stream ----------------------------------------------------------
+* receive batch of frames. payloads are received to consecutive slots in
+* memory buffer. if all frames are in sequence, no copy is needed. otherwise,
+* payloads are moved to their sequence with gap filling
+* args   : sdrnet_t *net    I/O network stream struct
+* return : int                  number of frames (0: timeout, -1: error)
+*-----------------------------------------------------------------------------*/
+static int recvudp(sdrnet_t *net)
+{
+    uint64_t off,base=net->wpos;
+    int i,m,fast=1,flag,hlen,len[NETBATCH];
+    int slot=net->plen>0?net->plen:NETMAXPKT,npkt=net->plen>0?NETBATCH:1;
+
+    if ((m=recvpkts(net,npkt,slot,len))<=0) return m;
+
+    for (i=0;i<m&&fast;i++) {
+        fast=len[i]>=0&&decodehdr(net->hdr+i*NETHDRLEN,&hlen,&flag,&off)&&
+            hlen==len[i]&&!(flag&NETF_EOS)&&(len[i]==slot||i==m-1);
+        if (fast&&!net->sync) {
+            net->org=off;
+            net->sync=1;
+        }
+        fast=fast&&off>=net->org&&off-net->org==base+(uint64_t)i*slot;
+    }
+    net->npkt+=m;
+
+    if (fast) {
+        net->wpos=base+(uint64_t)(m-1)*slot+len[m-1];
+        if (net->plen==0&&len[0]>0) net->plen=len[0];
+        return m;
+    }
+    /* out of sequence: copy payloads out of memory buffer and place them */
+    for (i=0;i<m;i++) {
+        if (len[i]>0) ringget(net,base+(uint64_t)i*slot,net->tmp+i*slot,len[i]);
+    }
+    for (i=0;i<m;i++) {
+        if (len[i]<0) { /* truncated: payload length is learned again */
+            net->plen=0;
+            continue;
+        }
+        if (!decodehdr(net->hdr+i*NETHDRLEN,&hlen,&flag,&off)||
+            hlen!=len[i]) continue;
+        if (flag&NETF_EOS) {
+            net->eos=1;
+            break;
+        }
+        place(net,off,net->tmp+i*slot,len[i]);
+        if (net->plen==0&&len[i]>0) net->plen=len[i];
+    }
+    return m;
+}
+/* set socket options --------------------------------------------------------*/
+static void setsockopts(SOCKET soc, int sockbuf)
+{
+    int size=sockbuf*1024*1024,yes=1;
+    socklen_t n=sizeof(size);
+#ifdef WIN32
+    DWORD tout=NETPOLL;
+#else
+    struct timeval tout={0,NETPOLL*1000};
+#endif
+    setsockopt(soc,SOL_SOCKET,SO_REUSEADDR,(const char *)&yes,sizeof(yes));
+    setsockopt(soc,SOL_SOCKET,SO_RCVTIMEO,(const char *)&tout,sizeof(tout));
+
+    /* large receive buffer absorbs scheduling jitter of grabber */
+    setsockopt(soc,SOL_SOCKET,SO_RCVBUF,(const char *)&size,sizeof(size));
+    if (getsockopt(soc,SOL_SOCKET,SO_RCVBUF,(char *)&size,&n)==0&&
+        size<sockbuf*1024*1024) {
+        SDRPRINTF("warning: socket receive buffer is limited to %d KB\n",
+            size/1024);
+    }
+}
+/* socket address ------------------------------------------------------------*/
+static int setaddr(const char *host, int port, struct sockaddr_in *addr)
+{
+    struct hostent *hp;
+
+    memset(addr,0,sizeof(struct sockaddr_in));
+    addr->sin_family=AF_INET;
+    addr->sin_port=htons((unsigned short)port);
+    if (!*host) {
+        addr->sin_addr.s_addr=htonl(INADDR_ANY);
+        return 0;
+    }
+    if (!(hp=gethostbyname(host))) {
+        SDRPRINTF("error: unknown host: %s\n",host);
+        return -1;
+    }
+    memcpy(&addr->sin_addr,hp->h_addr,hp->h_length);
+    return 0;
+}
+/* send rtl_tcp command ------------------------------------------------------*/
+static int sendcmd(SOCKET soc, int cmd, unsigned int param)
+{
+    char buff[5];
+
+    buff[0]=(char)cmd;
+    buff[1]=(char)(param>>24); buff[2]=(char)(param>>16);
+    buff[3]=(char)(param>>8);  buff[4]=(char)param;
+    return send(soc,buff,5,MSG_NOSIGNAL)==5?0:-1;
+}
+/* connect to rtl_tcp server ---------------------------------------------------
+* check dongle info and set sampling and center frequency
+* args   : sdrnet_t *net    I   network stream struct
+*          sdrini_t *ini    I   sdr initialization struct
+* return : int                  status 0:okay -1:failure
+*-----------------------------------------------------------------------------*/
+static int rtltcpinit(sdrnet_t *net, sdrini_t *ini)
+{
+    char info[12];
+
+    if (recvall(net,info,12)<12||memcmp(info,"RTL0",4)) {
+        SDRPRINTF("error: no dongle info from rtl_tcp server\n");
+        return -1;
+    }
+    SDRPRINTF("rtl_tcp: tuner type %d\n",(uint8_t)info[7]);
+
+    if (sendcmd(net->soc,0x02,(unsigned int)ini->f_sf[0])<0|| /* sampling */
+        (ini->f_cf[0]>0.0&&
+        sendcmd(net->soc,0x01,(unsigned int)ini->f_cf[0])<0)|| /* center */
+        sendcmd(net->soc,0x03,0)<0) { /* automatic gain */
+        SDRPRINTF("error: failed to send command to rtl_tcp server\n");
+        return -1;
+    }
+    return 0;
+}
+/* initialize network stream front end -----------------------------------------
+* connect to server (RTLTCP/TCP) or bind to port (UDP)
+* args   : sdrini_t *ini    I   sdr initialization struct
+* return : int                  status 0:okay -1:failure
+* note : call after the memory buffer of front end is allocated
+*-----------------------------------------------------------------------------*/
+extern int netinit(sdrini_t *ini)
+{
+    sdrnet_t *net;
+    struct sockaddr_in addr;
+    int udp=ini->netproto==NETP_UDP;
+
+    if (!(net=(sdrnet_t *)calloc(1,sizeof(sdrnet_t)))||
+        !(net->hdr=(uint8_t *)malloc(NETBATCH*NETHDRLEN))||
+        !(net->tmp=(char *)malloc(NETBATCH*NETMAXPKT))) {
+        SDRPRINTF("error: netinit memory allocation\n");
+        if (net) free(net->hdr);
+        free(net);
+        return -1;
+    }
+    net->proto=ini->netproto;
+    net->blklen=ini->dtype[0]*sdrstat.fendbuffsize;
+    net->ringlen=(uint64_t)sdrstat.nblk*net->blklen;
+    net->soc=INVALID_SOCKET;
+    sdrstat.net=net;
+
+    if (setaddr(ini->nethost,ini->netport,&addr)<0) return -1;
+
+    if ((net->soc=socket(AF_INET,udp?SOCK_DGRAM:SOCK_STREAM,0))==
+        INVALID_SOCKET) {
+        SDRPRINTF("error: network stream socket failed\n");
+        return -1;
+    }
+    setsockopts(net->soc,ini->netsockbuf);
+
+    if (udp) {
+        if (bind(net->soc,(struct sockaddr *)&addr,sizeof(addr))==
+            SOCKET_ERROR) {
+            SDRPRINTF("error: network stream bind failed: port %d\n",
+                ini->netport);
+            return -1;
+        }
+    }
+    else if (connect(net->soc,(struct sockaddr *)&addr,sizeof(addr))==
+        SOCKET_ERROR) {
+        SDRPRINTF("error: network stream connect failed: %s:%d\n",
+            ini->nethost,ini->netport);
+        return -1;
+    }
+    if (net->proto==NETP_RTLTCP&&rtltcpinit(net,ini)<0) return -1;
+
+    SDRPRINTF("Data is taken from network stream: %s:%d\n",
+        *ini->nethost?ini->nethost:"*",ini->netport);
+    return 0;
+}
+/* statistics of network stream ------------------------------------------------
+* print statistics of received frames
+* args   : none
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void netstats(void)
+{
+    sdrnet_t *net=sdrstat.net;
+
+    if (net==NULL||net->proto==NETP_RTLTCP) return;
+
+    SDRPRINTF("network stream: frames=%.0f lost=%.0f late=%.0f "
+        "zero-filled=%.0f bytes\n",(double)net->npkt,(double)net->nlost,
+        (double)net->nlate,(double)net->nfill);
+}
+/* stop network stream front end -----------------------------------------------
+* close socket
+* args   : none
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void netquit(void)
+{
+    sdrnet_t *net=sdrstat.net;
+
+    if (net==NULL) return;
+
+    sdrstat.net=NULL;
+    if (net->soc!=INVALID_SOCKET) closesocket(net->soc);
+    free(net->hdr);
+    free(net->tmp);
+    free(net);
+}
+/* push data to memory buffer --------------------------------------------------
+* receive network stream until at least one block of memory buffer is filled
+* args   : none
+* return : int                  status 0:okay -1:failure
+* note : at end of stream, the last block is padded by zero
+*-----------------------------------------------------------------------------*/
+extern int net_pushtomembuf(void)
+{
+    sdrnet_t *net=sdrstat.net;
+    uint64_t cnt=sdrstat.buffcnt;
+    unsigned int tick=tickget();
+    int ret,n;
+
+    while (sdrstat.buffcnt==cnt&&!sdrstat.stopflag) {
+        switch (net->proto) {
+            case NETP_RTLTCP: ret=recvrtltcp(net); break;
+            case NETP_TCP:    ret=recvtcp(net);    break;
+            default:          ret=recvudp(net);    break;
+        }
+        if (ret<0) return sdrstat.stopflag?0:-1;
+
+        if (net->eos) {
+            if ((n=(int)(net->wpos%net->blklen))>0) {
+                ringput(net,net->wpos,NULL,net->blklen-n);
+                net->wpos+=net->blklen-n;
+            }
+            publish(net);
+            rcveof();
+            return 0;
+        }
+        if (ret>0) tick=tickget();
+        else if ((int)(tickget()-tick)>NETTIMEOUT) {
+            SDRPRINTF("error: no data from network stream (%d ms)\n",
+                NETTIMEOUT);
+            return -1;
+        }
+        publish(net);
+    }
+    return 0;
+}
+/* send all data -------------------------------------------------------------*/
+static int sendall(SOCKET soc, const char *p, int n)
+{
+    int r,m=0;
+
+    while (m<n) {
+        if ((r=send(soc,p+m,n-m,MSG_NOSIGNAL))<=0) return -1;
+        m+=r;
+    }
+    return 0;
+}
+/* replay IF file to network ---------------------------------------------------
+* serve IF file (FILE1, raw or packed) as network stream at paced rate for
+* testing of network stream front end. RTLTCP/TCP serve one client on port.
+* UDP sends to host:port
+* args   : sdrini_t *ini    I   sdr initialization struct (FILE front end)
+*          char   *proto    I   protocol ("RTLTCP","TCP","UDP")
+*          int    port      I   port number
+*          char   *host     I   destination host of UDP ("": localhost)
+*          double speed     I   replay speed (1.0: real-time, 0: no pacing)
+* return : int                  status 0:okay -1:failure
+*-----------------------------------------------------------------------------*/
+extern int sdrnetserve(sdrini_t *ini, const char *proto, int port,
+                       const char *host, double speed)
+{
+    sdrpack_t pk;
+    FILE *fp;
+    SOCKET s=INVALID_SOCKET,c=INVALID_SOCKET;
+    struct sockaddr_in addr;
+    socklen_t addrlen=sizeof(addr);
+    uint64_t sent=0;
+    unsigned int t0;
+    double rate=ini->f_sf[0]*ini->dtype[0]*speed; /* bytes/s */
+    char *buff,*data,info[12]={'R','T','L','0',0,0,0,5,0,0,0,0};
+    int i,n,p=netprotocol(proto),len,ret=0,yes=1;
+
+    if (p<0||port<=0) {
+        SDRPRINTF("error: wrong network stream: %s port %d\n",proto,port);
+        return -1;
+    }
+    memset(&pk,0,sizeof(pk));
+    if (!(fp=fopen(ini->file1,"rb"))||packopen(fp,&pk)<0) {
+        SDRPRINTF("error: failed to open file(FILE1): %s\n",ini->file1);
+        if (fp) fclose(fp);
+        return -1;
+    }
+    len=p==NETP_RTLTCP?RTLTCPCHUNK:NETPKTLEN;
+    if (!(buff=(char *)malloc(NETHDRLEN+RTLTCPCHUNK))||socketstartup()<0) {
+        free(buff);
+        packclose(&pk);
+        fclose(fp);
+        return -1;
+    }
+    data=buff+NETHDRLEN;
+
+    if (p==NETP_UDP) {
+        if (setaddr(*host?host:"127.0.0.1",port,&addr)<0||
+            (c=socket(AF_INET,SOCK_DGRAM,0))==INVALID_SOCKET||
+            connect(c,(struct sockaddr *)&addr,sizeof(addr))==SOCKET_ERROR) {
+            SDRPRINTF("error: udp socket failed: %s:%d\n",host,port);
+            ret=-1;
+        }
+    }
+    else {
+        setaddr("",port,&addr);
+        if ((s=socket(AF_INET,SOCK_STREAM,0))==INVALID_SOCKET||
+            setsockopt(s,SOL_SOCKET,SO_REUSEADDR,(const char *)&yes,
+                sizeof(yes))==SOCKET_ERROR||
+            bind(s,(struct sockaddr *)&addr,sizeof(addr))==SOCKET_ERROR||
+            listen(s,1)==SOCKET_ERROR) {
+            SDRPRINTF("error: tcp/ip server failed: port %d\n",port);
+            ret=-1;
+        }
+        else {
+            SDRPRINTF("Waiting for connection on port %d ...\n",port);
+            if ((c=accept(s,(struct sockaddr *)&addr,&addrlen))==
+                INVALID_SOCKET) ret=-1;
+            else SDRPRINTF("Connected from %s!\n",inet_ntoa(addr.sin_addr));
+        }
+    }
+    if (ret==0&&p==NETP_RTLTCP&&sendall(c,info,12)<0) ret=1;
+
+    t0=tickget();
+    while (ret==0) {
+        n=pk.hdr.bits?packread(&pk,data,len):(int)fread(data,1,len,fp);
+        if (n<=0) break;
+
+        /* pacing */
+        while (speed>0.0&&(double)sent>(tickget()-t0)*rate/1000.0) {
+            sleepms(1);
+        }
+        if (p==NETP_RTLTCP) { /* int8 to unsigned 8-bit offset-binary */
+            for (i=0;i<n;i++) {
+                data[i]=(char)(data[i]>=0?data[i]+128:
+                    (data[i]>-128?data[i]+127:0));
+            }
+            if (sendall(c,data,n)<0) ret=1;
+        }
+        else {
+            encodehdr((uint8_t *)buff,n,0,sent);
+            if (p==NETP_UDP?send(c,buff,NETHDRLEN+n,0)!=NETHDRLEN+n:
+                sendall(c,buff,NETHDRLEN+n)<0) ret=1; /* disconnected */
+        }
+        sent+=n;
+    }
+    if (p!=NETP_RTLTCP&&ret==0) {
+        encodehdr((uint8_t *)buff,0,NETF_EOS,sent);
+        if (p==NETP_UDP) send(c,buff,NETHDRLEN,0);
+        else sendall(c,buff,NETHDRLEN);
+    }
+    SDRPRINTF("network stream: served %.0f bytes (%.1f s)\n",(double)sent,
+        (tickget()-t0)*1E-3);
+
+    /* graceful close: unread commands of client would reset connection */
+    if (c!=INVALID_SOCKET&&p!=NETP_UDP) {
+        shutdown(c,1);
+        while (recv(c,buff,NETHDRLEN,0)>0) ;
+    }
+    if (c!=INVALID_SOCKET) closesocket(c);
+    if (s!=INVALID_SOCKET) closesocket(s);
+    socketcleanup();
+    free(buff);
+    packclose(&pk);
+    fclose(fp);
+    return ret<0?-1:0;
+}
@@ -0,0 +1,430 @@
+/*------------------------------------------------------------------------------
+* sdrobsq.c : SDR observation output queue functions
+*
+* Copyright (C) 2014 Taro Suzuki <gnsssdrlib@gmail.com>
+*-----------------------------------------------------------------------------*/
+#include "sdr.h"
+
+#define BENCHCH     32          /* channels of benchmark */
+#define BENCHMS     10          /* output interval of benchmark (ms) */
+#define BENCHTIME   2000        /* measurement time of benchmark (ms) */
+#define BENCHFS     4E6         /* sampling frequency of benchmark (Hz) */
+
+/* encode binary observation record --------------------------------------------
+* record of an epoch (host byte order, little-endian on supported platforms):
+*   header : id[4], week (uint16), n (uint16), tow (double, s)
+*   n data : sat (uint8), SNR (uint8, 0.25 dB-Hz), code (uint8), LLI (uint8),
+*            doppler (float, Hz), pseudorange (double, m),
+*            carrier phase (double, cycle)
+* args   : obsd_t *obs      I   observation data of epoch
+*          int    n         I   number of observation data
+*          uint8_t *p       O   binary record
+* return : int                  length of record (bytes)
+*-----------------------------------------------------------------------------*/
+static int encrec(const obsd_t *obs, int n, uint8_t *p)
+{
+    uint16_t week,ns=(uint16_t)n;
+    double tow;
+    int i,w;
+
+    tow=time2gpst(obs[0].time,&w);
+    week=(uint16_t)w;
+    memcpy(p,OBSBINID,4);
+    memcpy(p+4,&week,2);
+    memcpy(p+6,&ns,2);
+    memcpy(p+8,&tow,8);
+    p+=OBSBINHDR;
+
+    for (i=0;i<n;i++,p+=OBSBINSAT) {
+        p[0]=(uint8_t)obs[i].sat;
+        p[1]=obs[i].SNR[0];
+        p[2]=obs[i].code[0];
+        p[3]=obs[i].LLI[0];
+        memcpy(p+4,&obs[i].D[0],4);
+        memcpy(p+8,&obs[i].P[0],8);
+        memcpy(p+16,&obs[i].L[0],8);
+    }
+    return OBSBINHDR+OBSBINSAT*n;
+}
+/* write batch of queue --------------------------------------------------------
+* write queued epochs (up to OBSQBATCH) to binary observation file by one
+* write and to rinex observation file by one open
+* args   : sdrobsq_t *q     I/O observation output queue
+* return : int                  number of written epochs
+*-----------------------------------------------------------------------------*/
+static int writebatch(sdrobsq_t *q)
+{
+    FILE *fp=NULL;
+    uint64_t k,wp=q->wp;
+    const obsd_t *obs;
+    double lat;
+    int i,len=0;
+
+    if (q->rp>=wp) return 0;
+    if (wp-q->rp>OBSQBATCH) wp=q->rp+OBSQBATCH;
+    sdrbarrier();
+
+    if (q->rnxfile&&!(fp=fopen(q->rnxfile,"a"))) {
+        SDRPRINTF("error: rinex obs can't be written %s\n",q->rnxfile);
+        sdrstat.stopflag=ON;
+        q->nerr++;
+    }
+    for (k=q->rp;k<wp;k++) {
+        i=(int)(k%q->qlen);
+        obs=q->obs+(size_t)i*q->nmax;
+        if (fp) outrnxobsb(fp,q->opt,obs,q->n[i],0);
+        if (q->fp) len+=encrec(obs,q->n[i],q->buff+len);
+    }
+    if (fp) fclose(fp);
+    if (q->fp&&(fwrite(q->buff,1,len,q->fp)!=(size_t)len||fflush(q->fp))) {
+        q->nerr++;
+    }
+    lat=(double)(tickgetus()-q->tick[q->rp%q->qlen]); /* oldest epoch */
+    if (lat>q->latmax) q->latmax=lat;
+
+    i=(int)(wp-q->rp);
+    q->nepoch+=i;
+    q->nbatch++;
+    sdrbarrier();
+    q->rp=wp;
+    return i;
+}
+/* observation writer thread ---------------------------------------------------
+* drain queue of observation epochs to output files in batches. sync thread
+* never waits for the writer
+* args   : void   *arg      I   observation output queue
+* return : none
+*-----------------------------------------------------------------------------*/
+#ifdef WIN32
+static void obsthread(void *arg)
+#else
+static void *obsthread(void *arg)
+#endif
+{
+    sdrobsq_t *q=(sdrobsq_t *)arg;
+    int quit;
+
+    sdrrtthread(RT_OUT);
+
+    do {
+        quit=q->quit;
+        while (writebatch(q)) ;
+        if (!quit) sleepms(OBSQPOLL);
+    } while (!quit);
+
+    return THRETVAL;
+}
+/* create queue --------------------------------------------------------------*/
+static sdrobsq_t *newq(int qlen, int nmax)
+{
+    sdrobsq_t *q;
+
+    if (!(q=(sdrobsq_t *)calloc(1,sizeof(sdrobsq_t)))) return NULL;
+
+    /* queue length: power of 2 */
+    for (q->qlen=1;q->qlen<qlen;) q->qlen*=2;
+    q->nmax=nmax;
+
+    if (!(q->obs=(obsd_t *)calloc((size_t)q->qlen*nmax,sizeof(obsd_t)))||
+        !(q->n=(int *)calloc(q->qlen,sizeof(int)))||
+        !(q->tick=(unsigned long *)calloc(q->qlen,sizeof(unsigned long)))||
+        !(q->buff=(uint8_t *)malloc((size_t)OBSQBATCH*
+        (OBSBINHDR+OBSBINSAT*nmax)))) {
+        free(q->obs); free(q->n); free(q->tick); free(q);
+        return NULL;
+    }
+    return q;
+}
+/* free queue ----------------------------------------------------------------*/
+static void freeq(sdrobsq_t *q)
+{
+    free(q->obs); free(q->n); free(q->tick); free(q->buff); free(q);
+}
+/* stop queue ------------------------------------------------------------------
+* stop writer thread after the queue is drained
+* args   : sdrobsq_t *q     I/O observation output queue
+* return : none
+*-----------------------------------------------------------------------------*/
+static void stopq(sdrobsq_t *q)
+{
+    if (q->run) {
+        q->quit=1;
+        waitthread(q->hwrite);
+        q->run=0;
+    }
+    else while (writebatch(q)) ;
+}
+/* push epoch to queue ---------------------------------------------------------
+* args   : sdrobsq_t *q     I/O observation output queue
+*          obsd_t *obs      I   observation data of epoch
+*          int    n         I   number of observation data
+* return : none
+* note : single producer (sync thread) and single consumer (writer thread).
+*        if queue is full, the epoch is dropped
+*-----------------------------------------------------------------------------*/
+static void pushq(sdrobsq_t *q, const obsd_t *obs, int n)
+{
+    int i=(int)(q->wp%q->qlen);
+
+    if (q->wp-q->rp>=(uint64_t)q->qlen) {
+        q->ndrop++;
+        return;
+    }
+    if (n>q->nmax) n=q->nmax;
+    memcpy(q->obs+(size_t)i*q->nmax,obs,sizeof(obsd_t)*n);
+    q->n[i]=n;
+    q->tick[i]=tickgetus();
+    sdrbarrier();
+    q->wp++;
+}
+/* initialize observation output -----------------------------------------------
+* start writer thread of rinex observation file and binary observation file.
+* in offline mode, epochs are written synchronously by obsqpush()
+* args   : sdrini_t *ini    I   sdr initialization struct
+* return : int                  status 0:okay -1:failure
+* note : call after rinex observation file is created
+*-----------------------------------------------------------------------------*/
+extern int obsqinit(sdrini_t *ini)
+{
+    sdrobsq_t *q;
+
+    if (!ini->rinex&&!ini->obsbin[0]) return 0;
+
+    if (!(q=newq(ini->obsqueue>0?ini->obsqueue:OBSQLEN,ini->nch))) {
+        SDRPRINTF("error: obsqinit memory allocation\n");
+        return -1;
+    }
+    if (ini->obsbin[0]&&!(q->fp=fopen(ini->obsbin,"wb"))) {
+        SDRPRINTF("error: failed to open file: %s\n",ini->obsbin);
+        freeq(q);
+        return -1;
+    }
+    if (ini->rinex) {
+        q->rnxfile=sdrout.rinexobs;
+        q->opt=&sdrout.opt;
+    }
+    sdrstat.obsq=q;
+
+    if (!ini->offline) {
+        cratethread(q->hwrite,obsthread,q);
+        q->run=1;
+    }
+    if (ini->obsbin[0]) {
+        SDRPRINTF("binary obs output: %s (queue %d epochs)\n",ini->obsbin,
+            q->qlen);
+    }
+    return 0;
+}
+/* stop observation output -----------------------------------------------------
+* drain queue, close binary observation file and print statistics
+* args   : none
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void obsqquit(void)
+{
+    sdrobsq_t *q=sdrstat.obsq;
+
+    if (q==NULL) return;
+
+    sdrstat.obsq=NULL;
+    stopq(q);
+    SDRPRINTF("obs output: written=%.0f batches=%.0f dropped=%.0f error=%.0f "
+        "epochs, max latency=%.1f ms\n",(double)q->nepoch,(double)q->nbatch,
+        (double)q->ndrop,(double)q->nerr,q->latmax*1E-3);
+    if (q->fp) fclose(q->fp);
+    freeq(q);
+}
+/* push observation epoch ------------------------------------------------------
+* queue observation data of an epoch to writer thread (rinex and binary
+* observation output). called by sync thread at every output epoch
+* args   : obsd_t *obs      I   observation data of epoch
+*          int    n         I   number of observation data
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void obsqpush(const obsd_t *obs, int n)
+{
+    sdrobsq_t *q=sdrstat.obsq;
+
+    if (q==NULL||n<=0) return;
+
+    pushq(q,obs,n);
+    if (!q->run) while (writebatch(q)) ; /* offline mode */
+}
+/* tracking of benchmark */
+typedef struct {
+    sdrtrk_t *trk;       /* tracking structs of channels */
+    volatile int mode;   /* 0:baseline 1:paced output 2:unpaced output */
+    volatile int quit;   /* quit flag */
+    uint64_t cnt;        /* loop counter */
+    double n[3],tsum[3],tmax[3]; /* passes, sum and max of pass time (us) */
+} benchtrk_t;
+
+/* update observation history of benchmark (seqlock writer) ------------------*/
+static void benchupd(sdrobsh_t *h, int ch, uint64_t cnt)
+{
+    int i=h->head==OBSINTERPN-1?0:h->head+1;
+
+    h->seq++;
+    sdrbarrier();
+    h->tow[i]=cnt*BENCHMS*1E-3;
+    h->codei[i]=(uint64_t)(cnt*BENCHMS*1E-3*BENCHFS)+ch*97;
+    h->cntout[i]=cnt;
+    h->remcout[i]=0.0;
+    h->D[i]=1000.0+ch;
+    h->L[i]=h->L[h->head]+h->D[i]*BENCHMS*1E-3;
+    h->head=i;
+    sdrbarrier();
+    h->seq++;
+}
+/* tracking thread of benchmark ------------------------------------------------
+* update observation histories of all channels at loop interval and measure
+* time of update pass
+* args   : void   *arg      I   tracking of benchmark
+* return : none
+*-----------------------------------------------------------------------------*/
+#ifdef WIN32
+static void benchtrkthread(void *arg)
+#else
+static void *benchtrkthread(void *arg)
+#endif
+{
+    benchtrk_t *bt=(benchtrk_t *)arg;
+    unsigned long t0;
+    double t;
+    int i,m;
+
+    while (!bt->quit) {
+        m=bt->mode;
+        t0=tickgetus();
+        for (i=0;i<BENCHCH;i++) benchupd(&bt->trk[i].obsh,i,bt->cnt);
+        t=(double)(tickgetus()-t0);
+        bt->cnt++;
+        bt->n[m]+=1.0;
+        bt->tsum[m]+=t;
+        if (t>bt->tmax[m]) bt->tmax[m]=t;
+        sleepms(BENCHMS);
+    }
+    return THRETVAL;
+}
+/* output epoch of benchmark ---------------------------------------------------
+* copy observation histories, interpolate and push epoch (same steps as sync
+* thread)
+* args   : benchtrk_t *bt   I   tracking of benchmark
+*          sdrobsh_t *h     I/O copy of observation histories
+*          int    *hint     I/O ring index of last interpolation bracket
+*          sdrobsq_t *q     I/O observation output queue
+*          obsd_t *obs      O   observation data
+* return : double               time of epoch (us)
+*-----------------------------------------------------------------------------*/
+static double benchepoch(benchtrk_t *bt, sdrobsh_t *h, int *hint,
+                         sdrobsq_t *q, obsd_t *obs)
+{
+    unsigned long t0=tickgetus();
+    double base,L,D;
+    int i,k;
+
+    for (i=0;i<BENCHCH;i++) {
+        obsgethist(&bt->trk[i],&h[i]);
+        k=obsidx(&h[i],2);
+        base=(double)h[i].codei[obsidx(&h[i],OBSINTERPN-1)];
+        obsinterp(&h[i],FTYPE1,base,(double)h[i].codei[k]-base+
+            0.5*BENCHMS*1E-3*BENCHFS,&hint[i],&L,&D);
+
+        obs[i].time=gpst2time(2000,h[i].tow[k]);
+        obs[i].sat=(unsigned char)(i+1);
+        obs[i].P[0]=2E7+i*1E5;
+        obs[i].L[0]=L;
+        obs[i].D[0]=(float)D;
+        obs[i].SNR[0]=180;
+        obs[i].code[0]=CODE_L1C;
+    }
+    pushq(q,obs,BENCHCH);
+    return (double)(tickgetus()-t0);
+}
+/* benchmark of observation output ---------------------------------------------
+* measure high-rate observation output of BENCHCH channels at 1000/BENCHMS Hz:
+* cost of output epoch in sync thread, writer batches and latency, max rate
+* and update time of tracking with and without output
+* args   : none
+* return : int                  status 0:okay -1:failure
+*-----------------------------------------------------------------------------*/
+extern int sdrobsbench(void)
+{
+    benchtrk_t bt;
+    sdrobsh_t *h;
+    sdrobsq_t *q;
+    obsd_t obs[BENCHCH]={{{0}}};
+    thread_t htrk;
+    unsigned int t0;
+    double t,n=0.0,tsum=0.0,tmax=0.0,nfast=0.0,sec,nep,nbat,ndrop,lat;
+    int i,hint[BENCHCH]={0},wait;
+    long bytes;
+
+    memset(&bt,0,sizeof(bt));
+    bt.trk=(sdrtrk_t *)calloc(BENCHCH,sizeof(sdrtrk_t));
+    h=(sdrobsh_t *)calloc(BENCHCH,sizeof(sdrobsh_t));
+    q=newq(OBSQLEN,BENCHCH);
+    if (!bt.trk||!h||!q||!(q->fp=tmpfile())) {
+        SDRPRINTF("error: sdrobsbench initialization\n");
+        free(bt.trk); free(h);
+        if (q) freeq(q);
+        return -1;
+    }
+    for (bt.cnt=0;bt.cnt<OBSINTERPN;bt.cnt++) {
+        for (i=0;i<BENCHCH;i++) benchupd(&bt.trk[i].obsh,i,bt.cnt);
+    }
+    cratethread(htrk,benchtrkthread,&bt);
+    sleepms(BENCHTIME/4); /* tracking without output */
+
+    cratethread(q->hwrite,obsthread,q);
+    q->run=1;
+    bt.mode=1;
+
+    /* paced output */
+    for (t0=tickget(),i=1;tickget()-t0<BENCHTIME;i++) {
+        t=benchepoch(&bt,h,hint,q,obs);
+        n+=1.0;
+        tsum+=t;
+        if (t>tmax) tmax=t;
+        if ((wait=(int)(t0+i*BENCHMS-tickget()))>0) sleepms(wait);
+    }
+    sec=(tickget()-t0)*1E-3;
+    sleepms(OBSQPOLL*4);
+    nep=(double)q->nepoch;
+    nbat=(double)q->nbatch;
+    ndrop=(double)q->ndrop;
+    lat=q->latmax;
+
+    /* unpaced output */
+    bt.mode=2;
+    for (t0=tickget();tickget()-t0<BENCHTIME/4;nfast+=1.0) {
+        benchepoch(&bt,h,hint,q,obs);
+    }
+    bt.quit=1;
+    waitthread(htrk);
+    stopq(q);
+    bytes=ftell(q->fp);
+
+    SDRPRINTF("observation output (%d channels, %d Hz):\n",BENCHCH,
+        1000/BENCHMS);
+    SDRPRINTF("  %-26s: mean %.1f max %.1f us (%.2f%% cpu)\n",
+        "sync epoch",tsum/n,tmax,tsum/n*1E-4*1000/BENCHMS);
+    SDRPRINTF("  %-26s: %.1f Hz (%.0f epochs, %.0f dropped)\n",
+        "output rate",n/sec,nep,ndrop);
+    SDRPRINTF("  %-26s: %.1f epochs/batch, max latency %.1f ms\n",
+        "writer",nbat>0.0?nep/nbat:0.0,lat*1E-3);
+    SDRPRINTF("  %-26s: push %.0f Hz, write %.0f Hz (%.0f dropped, "
+        "%.0f bytes)\n","unpaced output",nfast/(BENCHTIME/4*1E-3),
+        ((double)q->nepoch-nep)/(BENCHTIME/4*1E-3),(double)q->ndrop-ndrop,
+        (double)bytes);
+    SDRPRINTF("  %-26s: mean %.2f max %.1f us (no output)\n",
+        "tracking update",bt.tsum[0]/bt.n[0],bt.tmax[0]);
+    SDRPRINTF("  %-26s: mean %.2f max %.1f us (%d Hz output)\n","",
+        bt.tsum[1]/bt.n[1],bt.tmax[1],1000/BENCHMS);
+
+    fclose(q->fp);
+    freeq(q);
+    free(bt.trk);
+    free(h);
+    return 0;
+}
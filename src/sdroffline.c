@@ -0,0 +1,232 @@
+/*------------------------------------------------------------------------------
+* sdroffline.c : SDR deterministic offline processing functions
+*
+* Copyright (C) 2014 Taro Suzuki <gnsssdrlib@gmail.com>
+*-----------------------------------------------------------------------------*/
+#include "sdr.h"
+
+/* dependent channel -----------------------------------------------------------
+* check whether sdr channel depends on other channels (sbas uses tow of other
+* channel). dependent channels are processed after other channels
+* args   : sdrch_t *sdr     I   sdr channel struct
+* return : int                  1:dependent 0:independent
+*-----------------------------------------------------------------------------*/
+static int isdepch(sdrch_t *sdr)
+{
+    return sdr->ctype==CTYPE_L1SBAS||sdr->ctype==CTYPE_L1SAIF;
+}
+/* process sdr channel up to limit ---------------------------------------------
+* process acquisition/tracking of sdr channel until the channel reaches the
+* limit of buffer location or no data remains in memory buffer
+* args   : sdrch_t *sdr     I/O sdr channel struct
+*          sdrproc_t *proc  I/O sdr channel processing state struct
+*          uint64_t lim     I   limit of buffer location (common time index)
+* return : none
+*-----------------------------------------------------------------------------*/
+static void runch(sdrch_t *sdr, sdrproc_t *proc, uint64_t lim)
+{
+    lim=(uint64_t)rcvstrmloc(sdr->ftype,(double)lim); /* sample of stream */
+
+    while ((sdr->flagacq?proc->buffloc:sdr->acq.acqloc)<lim) {
+        if (!sdrproc(sdr,proc)) break;
+    }
+}
+/* wait flag of worker ---------------------------------------------------------
+* args   : sdrworker_t *w   I   worker struct
+*          event_t *ev      I   event
+*          volatile int *flag I flag
+*          int    val       I   value to wait
+* return : none
+*-----------------------------------------------------------------------------*/
+static void waitflag(sdrworker_t *w, event_t *ev, volatile int *flag, int val)
+{
+#ifdef WIN32
+    while (*flag<val&&!w->quit) WaitForSingleObject(*ev,INFINITE);
+#else
+    mlock(w->mtx);
+    while (*flag<val&&!w->quit) waitevent(*ev,w->mtx);
+    unmlock(w->mtx);
+#endif
+}
+/* set flag of worker ----------------------------------------------------------
+* args   : sdrworker_t *w   I/O worker struct
+*          event_t *ev      I   event
+*          volatile int *flag O flag
+*          int    val       I   value to set
+* return : none
+*-----------------------------------------------------------------------------*/
+static void setflag(sdrworker_t *w, event_t *ev, volatile int *flag, int val)
+{
+#ifdef WIN32
+    *flag=val;
+    setevent(*ev);
+#else
+    mlock(w->mtx);
+    *flag=val;
+    setevent(*ev);
+    unmlock(w->mtx);
+#endif
+}
+/* process assigned channels of worker -----------------------------------------
+* args   : sdrworker_t *w   I/O worker struct
+* return : none
+*-----------------------------------------------------------------------------*/
+static void runworker(sdrworker_t *w)
+{
+    int i;
+
+    for (i=0;i<w->nch;i++) {
+        runch(&sdrch[w->ich[i]],&w->proc[w->ich[i]],w->lim);
+    }
+}
+/* offline worker thread -------------------------------------------------------
+* worker thread processes assigned channels at every round
+* args   : void   *arg      I   worker struct
+* return : none
+*-----------------------------------------------------------------------------*/
+#ifdef WIN32
+static void offworker(void *arg)
+#else
+static void *offworker(void *arg)
+#endif
+{
+    sdrworker_t *w=(sdrworker_t *)arg;
+    int round;
+
+    /* cpu affinity of worker thread */
+    sdrrtthread(RT_CH);
+
+    for (round=1;;round++) {
+        waitflag(w,&w->start,&w->round,round);
+        if (w->quit) break;
+        runworker(w);
+        setflag(w,&w->done,&w->ndone,round);
+    }
+    return THRETVAL;
+}
+/* process one time slice ------------------------------------------------------
+* process all sdr channels up to limit of buffer location, then compute
+* observation data
+* args   : sdrworker_t *w   I/O worker structs
+*          int    nw        I   number of workers
+*          int    round     I   round number
+*          uint64_t lim     I   limit of buffer location (sample)
+*          sdrproc_t *proc  I/O sdr channel processing state structs
+*          sdrsync_t *sync  I/O sdr synchronization struct
+* return : none
+*-----------------------------------------------------------------------------*/
+static void runslice(sdrworker_t *w, int nw, int round, uint64_t lim,
+                     sdrproc_t *proc, sdrsync_t *sync)
+{
+    int i;
+
+    /* independent channels */
+    for (i=0;i<nw;i++) w[i].lim=lim;
+    for (i=1;i<nw;i++) setflag(&w[i],&w[i].start,&w[i].round,round);
+    runworker(&w[0]);
+    for (i=1;i<nw;i++) waitflag(&w[i],&w[i].done,&w[i].ndone,round);
+
+    /* dependent channels */
+    for (i=0;i<sdrini.nch;i++) {
+        if (isdepch(&sdrch[i])) runch(&sdrch[i],&proc[i],lim);
+    }
+    /* observation data */
+    syncobs(sync);
+}
+/* sdr offline processing ------------------------------------------------------
+* deterministic offline processing of IF data file. data is pushed to memory
+* buffer only after all sdr channels consumed the data, so the results do not
+* depend on cpu speed, thread scheduling and number of workers
+* args   : none
+* return : int                  status 0:okay -1:failure
+* note : channels are statically assigned to workers (channel % nworker) and
+*        all channels are processed in time slices of 1 ms. sbas channels are
+*        processed in main thread after other channels
+*-----------------------------------------------------------------------------*/
+extern int sdroffline(void)
+{
+    sdrproc_t *proc;
+    sdrworker_t *w;
+    sdrsync_t sync;
+    uint64_t head,lim=0,slice;
+    int i,nw,round=0,ret=0,last=0;
+
+    SDRPRINTF("offline processing start: nch=%d nworker=%d\n",sdrini.nch,
+        sdrini.nworker);
+
+    nw=sdrini.nworker<sdrini.nch?sdrini.nworker:sdrini.nch;
+    if (nw<1) nw=1;
+
+    proc=(sdrproc_t *)calloc(sdrini.nch,sizeof(sdrproc_t));
+    w=(sdrworker_t *)calloc(nw,sizeof(sdrworker_t));
+    if (proc==NULL||w==NULL) {
+        SDRPRINTF("error: sdroffline memory allocation\n");
+        free(proc); free(w);
+        return -1;
+    }
+    if (initsync(&sync)<0) {
+        free(proc); free(w);
+        return -1;
+    }
+    /* sdr channels */
+    for (i=0;i<sdrini.nch;i++) {
+        if (initsdrproc(&sdrch[i],&proc[i])<0) {
+            sdrstat.stopflag=ON;
+        }
+        sdrch[i].acq.acqloc=sdrini.acqstart[i];
+        if (isdepch(&sdrch[i])) continue;
+        w[i%nw].ich[w[i%nw].nch++]=i;
+    }
+    /* worker threads */
+    for (i=0;i<nw;i++) {
+        w[i].no=i;
+        w[i].proc=proc;
+        if (i==0) continue;
+        initmlock(w[i].mtx);
+        initevent(w[i].start);
+        initevent(w[i].done);
+        cratethread(w[i].hwork,offworker,&w[i]);
+    }
+    slice=(uint64_t)(sdrini.f_sf[0]/1000); /* 1 ms */
+    if (slice<1) slice=1;
+
+    /* offline processing loop */
+    while (!last) {
+        if (sdrstat.stopflag) {
+            last=1; /* process remained data at end of file */
+        }
+        else if (rcvgrabdata(&sdrini)<0) {
+            ret=-1;
+            break;
+        }
+        head=rcvheadloc();
+
+        while (lim+slice<=head) {
+            lim+=slice;
+            runslice(w,nw,++round,lim,proc,&sync);
+        }
+        if (last&&lim<head) {
+            lim=head;
+            runslice(w,nw,++round,lim,proc,&sync);
+        }
+    }
+    sdrstat.stopflag=ON;
+
+    /* worker termination */
+    for (i=1;i<nw;i++) {
+        setflag(&w[i],&w[i].start,&w[i].quit,1);
+        waitthread(w[i].hwork);
+        delmlock(w[i].mtx);
+        delevent(w[i].start);
+        delevent(w[i].done);
+    }
+    for (i=0;i<sdrini.nch;i++) {
+        quitsdrproc(&sdrch[i],&proc[i]);
+    }
+    quitsync(&sync);
+    free(proc);
+    free(w);
+
+    SDRPRINTF("offline processing finished: %d slices\n",round);
+    return ret;
+}
@@ -90,6 +90,7 @@ extern int createrinexobs(char *file, rnxopt_t *opt)
     time_t timer;
     struct tm *utc;
     nav_t nav={0};
+    int n;
 
     /* UTC time */
     timer=time(NULL);
@@ -97,6 +98,14 @@ extern int createrinexobs(char *file, rnxopt_t *opt)
     sprintf(file,"%s/sdr_%04d%02d%02d%02d%02d%02d.obs",sdrini.rinexpath,
         utc->tm_year+1900,utc->tm_mon+1,utc->tm_mday,
         utc->tm_hour,utc->tm_min,utc->tm_sec);
+    if (sdrini.ichunk>0) { /* batch chunk process */
+        n=snprintf(file,sizeof(sdrout.rinexobs),"%s/sdr_chunk%03d.obs",
+            sdrini.rinexpath,sdrini.ichunk);
+        if (n<0||n>=(int)sizeof(sdrout.rinexobs)) {
+            SDRPRINTF("error: rinex path too long: %s\n",sdrini.rinexpath);
+            return -1;
+        }
+    }
 
     /* write rinex header */
     if ((fd=fopen(file,"w"))==NULL) {
@@ -139,6 +148,7 @@ extern int createrinexnav(char *file, rnxopt_t *opt)
     time_t timer;
     struct tm *utc;
     nav_t nav={0};
+    int n;
 
     /* UTC time */
     timer=time(NULL);
@@ -146,6 +156,14 @@ extern int createrinexnav(char *file, rnxopt_t *opt)
     sprintf(file,"%s/sdr_%04d%02d%02d%02d%02d%02d.nav",sdrini.rinexpath,
         utc->tm_year+1900,utc->tm_mon+1,utc->tm_mday,
         utc->tm_hour,utc->tm_min,utc->tm_sec);
+    if (sdrini.ichunk>0) { /* batch chunk process */
+        n=snprintf(file,sizeof(sdrout.rinexnav),"%s/sdr_chunk%03d.nav",
+            sdrini.rinexpath,sdrini.ichunk);
+        if (n<0||n>=(int)sizeof(sdrout.rinexnav)) {
+            SDRPRINTF("error: rinex path too long: %s\n",sdrini.rinexpath);
+            return -1;
+        }
+    }
 
     /* write rinex header */
     if ((fd=fopen(file,"w"))==NULL) {
@@ -219,6 +237,9 @@ static void *tcpsvrthread(void * arg)
     socklen_t dstAddrSize=sizeof(dstAddr);
     int yes=1;
 
+    /* cpu affinity of output thread */
+    sdrrtthread(RT_OUT);
+
     /* socket startup (for windows) */
     if (socketstartup()!=0) return THRETVAL;
 
@@ -423,7 +444,7 @@ void writelog_header(FILE *fp, sdrtrk_t *trk)
 *-----------------------------------------------------------------------------*/
 extern void writelog(FILE *fp, sdrtrk_t *trk,sdrnav_t *nav)
 {
-    int i,ind[64]={0},n=trk->corrn;
+    int i,ind[64]={0},n=trk->corrn,h=trk->obsh.head;
     /* generating correlation points indices */
     for (i=0;i<n;i++) {
         ind[i    ]=2*(n-i)-1;
@@ -432,10 +453,10 @@ extern void writelog(FILE *fp, sdrtrk_t *trk,sdrnav_t *nav)
 
 #ifdef WIN32
     fprintf(fp,"%llu,%f,%f,%f",
-        trk->cntout[0],trk->tow[0],trk->II[0],trk->QQ[0]);
+        trk->obsh.cntout[h],trk->obsh.tow[h],trk->II[0],trk->QQ[0]);
 #else
     fprintf(fp,"%"PRIu64",%f,%f,%f",
-        trk->cntout[0],trk->tow[0],trk->II[0],trk->QQ[0]);
+        trk->obsh.cntout[h],trk->obsh.tow[h],trk->II[0],trk->QQ[0]);
 #endif
     fprintf(fp,",%f,%f",trk->sumI[0],trk->sumQ[0]);
 
@@ -448,7 +469,7 @@ extern void writelog(FILE *fp, sdrtrk_t *trk,sdrnav_t *nav)
 		fprintf(fp,",%f",trk->II[ind[i]]);
     fprintf(fp,",%f,%f,%f",trk->codefreq,trk->codeErr,trk->codeNco);
     fprintf(fp,",%f,%f,%f",trk->carrfreq,trk->carrPhaseErr,trk->carrNco);
-    fprintf(fp,",%f,%f",trk->freqErr,trk->L[0]);
+    fprintf(fp,",%f,%f",trk->freqErr,trk->obsh.L[h]);
     fprintf(fp,",%d,%d,%d,%d,%d,%d",
         nav->flagsync,nav->flagsyncf,nav->flagtow,nav->flagdec,
         trk->flagloopfilter,nav->swsync);
@@ -0,0 +1,496 @@
+/*------------------------------------------------------------------------------
+* sdrpack.c : SDR packed IF file functions
+*
+* Copyright (C) 2014 Taro Suzuki <gnsssdrlib@gmail.com>
+*
+* packed IF file format (little endian):
+*   header (PACKHDRLEN bytes)
+*      0: identifier "GNSSPACK" (8)  8: version (u4)   12: header length (u4)
+*     16: sampling freq (f8)       24: IF (f8)       32: center freq (f8)
+*     40: sampling type (i4)       44: bits (i4)     48: samples/block (i4)
+*     56: number of samples (u8)   64: number of blocks (u8)
+*     72: offset of block index (u8)                 80: decoding table (16)
+*     96: front end type (32)
+*   packed data: lsb-first bits per data, I/Q interleaved (DTYPEIQ)
+*   block index: {first sample (u8), offset of block (u8)} x number of blocks
+*-----------------------------------------------------------------------------*/
+#ifndef WIN32
+#define _FILE_OFFSET_BITS 64
+#endif
+#include "sdr.h"
+
+/* set/get little endian values ----------------------------------------------*/
+static void setu4(uint8_t *p, uint32_t v)
+{
+    int i;
+    for (i=0;i<4;i++) p[i]=(uint8_t)(v>>(8*i));
+}
+static void setu8(uint8_t *p, uint64_t v)
+{
+    int i;
+    for (i=0;i<8;i++) p[i]=(uint8_t)(v>>(8*i));
+}
+static void setf8(uint8_t *p, double v)
+{
+    uint64_t u;
+    memcpy(&u,&v,8);
+    setu8(p,u);
+}
+static uint32_t getu4(const uint8_t *p)
+{
+    uint32_t v=0;
+    int i;
+    for (i=0;i<4;i++) v|=(uint32_t)p[i]<<(8*i);
+    return v;
+}
+static uint64_t getu8(const uint8_t *p)
+{
+    uint64_t v=0;
+    int i;
+    for (i=0;i<8;i++) v|=(uint64_t)p[i]<<(8*i);
+    return v;
+}
+static double getf8(const uint8_t *p)
+{
+    uint64_t u=getu8(p);
+    double v;
+    memcpy(&v,&u,8);
+    return v;
+}
+/* seek file -----------------------------------------------------------------*/
+static int seekfile(FILE *fp, uint64_t off)
+{
+#ifdef WIN32
+    return _fseeki64(fp,(__int64)off,SEEK_SET)?-1:0;
+#else
+    return fseeko(fp,(off_t)off,SEEK_SET)?-1:0;
+#endif
+}
+/* encode header ---------------------------------------------------------------
+* args   : sdrpackhdr_t *hdr I  header struct
+*          uint8_t *buf     O   header (PACKHDRLEN bytes)
+* return : none
+*-----------------------------------------------------------------------------*/
+static void encodehdr(const sdrpackhdr_t *hdr, uint8_t *buf)
+{
+    memset(buf,0,PACKHDRLEN);
+    memcpy(buf,PACKID,8);
+    setu4(buf+ 8,(uint32_t)hdr->ver);
+    setu4(buf+12,(uint32_t)hdr->hdrlen);
+    setf8(buf+16,hdr->f_sf);
+    setf8(buf+24,hdr->f_if);
+    setf8(buf+32,hdr->f_cf);
+    setu4(buf+40,(uint32_t)hdr->dtype);
+    setu4(buf+44,(uint32_t)hdr->bits);
+    setu4(buf+48,(uint32_t)hdr->blklen);
+    setu8(buf+56,hdr->nsamp);
+    setu8(buf+64,hdr->nblk);
+    setu8(buf+72,hdr->idxoff);
+    memcpy(buf+80,hdr->lut,16);
+    memcpy(buf+96,hdr->fend,31);
+}
+/* decode header ---------------------------------------------------------------
+* args   : uint8_t *buf     I   header (PACKHDRLEN bytes)
+*          sdrpackhdr_t *hdr O  header struct
+* return : int                  status 1:packed IF file 0:not packed IF file
+*-----------------------------------------------------------------------------*/
+static int decodehdr(const uint8_t *buf, sdrpackhdr_t *hdr)
+{
+    if (memcmp(buf,PACKID,8)) return 0;
+
+    memset(hdr,0,sizeof(sdrpackhdr_t));
+    hdr->ver   =(int)getu4(buf+ 8);
+    hdr->hdrlen=(int)getu4(buf+12);
+    hdr->f_sf  =getf8(buf+16);
+    hdr->f_if  =getf8(buf+24);
+    hdr->f_cf  =getf8(buf+32);
+    hdr->dtype =(int)getu4(buf+40);
+    hdr->bits  =(int)getu4(buf+44);
+    hdr->blklen=(int)getu4(buf+48);
+    hdr->nsamp =getu8(buf+56);
+    hdr->nblk  =getu8(buf+64);
+    hdr->idxoff=getu8(buf+72);
+    memcpy(hdr->lut,buf+80,16);
+    memcpy(hdr->fend,buf+96,31);
+    return 1;
+}
+/* default decoding table ------------------------------------------------------
+* odd symmetric levels. code: magnitude (lower bits) | sign (msb)
+* (1-bit: +1,-1, 2-bit: +1,+3,-1,-3, 4-bit: +1,+3,...,+15,-1,...,-15)
+* args   : int    bits      I   bits per data (1,2,4)
+*          char   *lut      O   decoding table (16 entries)
+* return : none
+*-----------------------------------------------------------------------------*/
+static void deflut(int bits, char *lut)
+{
+    int i,h=1<<(bits-1);
+
+    memset(lut,0,16);
+    for (i=0;i<(1<<bits)&&bits<8;i++) {
+        lut[i]=(char)((2*(i&(h-1))+1)*(i&h?-1:1));
+    }
+}
+/* encoding table --------------------------------------------------------------
+* encode int8 data to nearest level of decoding table
+* args   : char   *lut      I   decoding table (16 entries)
+*          int    bits      I   bits per data (1,2,4,8)
+*          uint8_t *enc     O   encoding table (index: int8 data+128)
+* return : none
+* note : 8-bit data are not encoded by the table (identity mapping)
+*-----------------------------------------------------------------------------*/
+static void enctbl(const char *lut, int bits, uint8_t *enc)
+{
+    int i,j,d,dmin;
+
+    if (bits>=8) {
+        for (i=0;i<256;i++) enc[i]=(uint8_t)(i-128);
+        return;
+    }
+    for (i=0;i<256;i++) {
+        for (j=0,dmin=1024;j<(1<<bits);j++) {
+            if ((d=abs(i-128-lut[j]))>=dmin) continue;
+            dmin=d;
+            enc[i]=(uint8_t)j;
+        }
+    }
+}
+/* allocate buffers of packed IF file (n: number of data) --------------------*/
+static int packbuff(sdrpack_t *pk, int n)
+{
+    if (n<=pk->nbuf) return 0;
+    free(pk->buf); free(pk->tmp);
+    pk->buf=(uint8_t *)malloc(n*pk->hdr.bits/8+1);
+    pk->tmp=(char *)malloc(n+8);
+    if (!pk->buf||!pk->tmp) {
+        SDRPRINTF("error: packed IF file memory allocation\n");
+        pk->nbuf=0;
+        return -1;
+    }
+    pk->nbuf=n;
+    return 0;
+}
+/* read header of packed IF file -----------------------------------------------
+* read header of IF file. front end settings of packed IF file are taken from
+* the header instead of front end configuration file
+* args   : char   *file     I   IF file path
+*          sdrpackhdr_t *hdr O  header struct
+* return : int                  status 1:packed IF file 0:raw IF file
+*                                      -1:error
+*-----------------------------------------------------------------------------*/
+extern int packreadhdr(const char *file, sdrpackhdr_t *hdr)
+{
+    uint8_t buf[PACKHDRLEN];
+    FILE *fp;
+    int ret;
+
+    if (!(fp=fopen(file,"rb"))) return -1;
+    ret=fread(buf,PACKHDRLEN,1,fp)==1&&decodehdr(buf,hdr);
+    fclose(fp);
+    return ret;
+}
+/* open packed IF file ---------------------------------------------------------
+* check header of opened IF file and read block index. the file is positioned
+* at the first packed data
+* args   : FILE   *fp       I   IF file pointer (opened by caller)
+*          sdrpack_t *pk    O   packed IF file struct
+* return : int                  status 1:packed IF file 0:raw IF file
+*                                      -1:error
+*-----------------------------------------------------------------------------*/
+extern int packopen(FILE *fp, sdrpack_t *pk)
+{
+    uint8_t buf[PACKHDRLEN],*p;
+    uint64_t i;
+
+    memset(pk,0,sizeof(sdrpack_t));
+
+    if (fread(buf,PACKHDRLEN,1,fp)!=1||!decodehdr(buf,&pk->hdr)) {
+        rewind(fp);
+        return 0;
+    }
+    if (pk->hdr.ver>PACKVER||pk->hdr.hdrlen<PACKHDRLEN||
+        (pk->hdr.bits!=1&&pk->hdr.bits!=2&&pk->hdr.bits!=4&&
+        pk->hdr.bits!=8)||(pk->hdr.dtype!=DTYPEI&&pk->hdr.dtype!=DTYPEIQ)) {
+        SDRPRINTF("error: unsupported packed IF file ver=%d bits=%d\n",
+            pk->hdr.ver,pk->hdr.bits);
+        return -1;
+    }
+    pk->fp=fp;
+
+    /* block index */
+    if (pk->hdr.idxoff>0&&pk->hdr.nblk>0) {
+        pk->idx=(uint64_t *)malloc(sizeof(uint64_t)*2*pk->hdr.nblk);
+        p=(uint8_t *)malloc(16*pk->hdr.nblk);
+        if (pk->idx&&p&&seekfile(fp,pk->hdr.idxoff)==0&&
+            fread(p,16,(size_t)pk->hdr.nblk,fp)==pk->hdr.nblk) {
+            for (i=0;i<2*pk->hdr.nblk;i++) pk->idx[i]=getu8(p+8*i);
+            pk->nidx=pk->hdr.nblk;
+        }
+        free(p);
+    }
+    if (seekfile(fp,pk->hdr.hdrlen)<0) return -1;
+    return 1;
+}
+/* seek packed IF file ---------------------------------------------------------
+* set position of packed IF file by sample using block index
+* args   : sdrpack_t *pk    I/O packed IF file struct
+*          uint64_t samp    I   sample number from start of data
+* return : int                  status 0:okay -1:failure
+* note : if the sample is not byte aligned, the byte including the sample is
+*        carried to the next read
+*-----------------------------------------------------------------------------*/
+extern int packseek(sdrpack_t *pk, uint64_t samp)
+{
+    uint64_t off=pk->hdr.hdrlen,base=0,bit;
+    int lo=0,hi=(int)pk->nidx-1,mid;
+
+    /* last block starting at or before the sample */
+    while (lo<=hi) {
+        mid=(lo+hi)/2;
+        if (pk->idx[2*mid]<=samp) {
+            base=pk->idx[2*mid];
+            off =pk->idx[2*mid+1];
+            lo=mid+1;
+        }
+        else hi=mid-1;
+    }
+    bit=(samp-base)*pk->hdr.dtype*pk->hdr.bits;
+    pk->pos=samp*pk->hdr.dtype;
+    pk->skip=(int)(bit%8)/pk->hdr.bits;
+
+    if (seekfile(pk->fp,off+bit/8)<0) return -1;
+    if (pk->skip>0&&fread(&pk->carry,1,1,pk->fp)!=1) return -1;
+    return 0;
+}
+/* read packed IF file ---------------------------------------------------------
+* read packed data and unpack to int8 data
+* args   : sdrpack_t *pk    I/O packed IF file struct
+*          char   *out      O   unpacked data
+*          int    n         I   number of data (I and Q, n*bits: multiple of 8)
+* return : int                  number of read data (<n: end of file)
+*-----------------------------------------------------------------------------*/
+extern int packread(sdrpack_t *pk, char *out, int n)
+{
+    int nb=n*pk->hdr.bits/8,nr,nd,dpb=8/pk->hdr.bits;
+    uint64_t rem=pk->hdr.nsamp*pk->hdr.dtype-pk->pos;
+
+    if (packbuff(pk,n)<0) return 0;
+
+    if (pk->skip==0) {
+        nr=(int)fread(pk->buf,1,nb,pk->fp);
+        nd=nr*dpb;
+        convunpack(pk->buf,nd,pk->hdr.bits,pk->hdr.lut,out);
+    }
+    else {
+        /* unaligned data: unpack with carried byte */
+        pk->buf[0]=pk->carry;
+        nr=(int)fread(pk->buf+1,1,nb,pk->fp);
+        convunpack(pk->buf,(nr+1)*dpb,pk->hdr.bits,pk->hdr.lut,pk->tmp);
+        nd=nr*dpb;
+        memcpy(out,pk->tmp+pk->skip,nd);
+        pk->carry=pk->buf[nr];
+    }
+    /* padding of last byte */
+    if ((uint64_t)nd>rem) nd=(int)rem;
+    pk->pos+=nd;
+    return nd;
+}
+/* close packed IF file --------------------------------------------------------
+* free buffers of packed IF file (file pointer is closed by caller)
+* args   : sdrpack_t *pk    I/O packed IF file struct
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void packclose(sdrpack_t *pk)
+{
+    free(pk->idx);
+    free(pk->buf);
+    free(pk->tmp);
+    memset(pk,0,sizeof(sdrpack_t));
+}
+/* add block index -------------------------------------------------------------
+* args   : sdrpack_t *pk    I/O packed IF file struct
+*          uint64_t samp    I   first sample of block
+*          uint64_t off     I   offset of block (bytes)
+* return : int                  status 0:okay -1:failure
+*-----------------------------------------------------------------------------*/
+static int addindex(sdrpack_t *pk, uint64_t samp, uint64_t off)
+{
+    uint64_t *p;
+
+    if (pk->nidx%1024==0) {
+        if (!(p=(uint64_t *)realloc(pk->idx,
+                sizeof(uint64_t)*2*(pk->nidx+1024)))) {
+            return -1;
+        }
+        pk->idx=p;
+    }
+    pk->idx[2*pk->nidx  ]=samp;
+    pk->idx[2*pk->nidx+1]=off;
+    pk->nidx++;
+    return 0;
+}
+/* create packed IF file -------------------------------------------------------
+* create packed IF file and write header. decoding table is set to default
+* odd-symmetric levels
+* args   : char   *file     I   packed IF file path
+*          sdrpackhdr_t *hdr I  header (f_sf,f_if,f_cf,dtype,bits,fend)
+*          sdrpack_t *pk    O   packed IF file struct
+* return : int                  status 0:okay -1:failure
+*-----------------------------------------------------------------------------*/
+extern int packcreate(const char *file, const sdrpackhdr_t *hdr, sdrpack_t *pk)
+{
+    uint8_t buf[PACKHDRLEN];
+
+    memset(pk,0,sizeof(sdrpack_t));
+
+    if (hdr->bits!=1&&hdr->bits!=2&&hdr->bits!=4&&hdr->bits!=8) {
+        SDRPRINTF("error: wrong bits of packed IF file: %d\n",hdr->bits);
+        return -1;
+    }
+    if (hdr->dtype!=DTYPEI&&hdr->dtype!=DTYPEIQ) {
+        SDRPRINTF("error: wrong sampling type of packed IF file\n");
+        return -1;
+    }
+    if (!(pk->fp=fopen(file,"wb"))) {
+        SDRPRINTF("error: failed to open file: %s\n",file);
+        return -1;
+    }
+    pk->hdr=*hdr;
+    pk->hdr.ver   =PACKVER;
+    pk->hdr.hdrlen=PACKHDRLEN;
+    pk->hdr.blklen=0;
+    pk->hdr.nsamp =0;
+    pk->hdr.nblk  =0;
+    pk->hdr.idxoff=0;
+    deflut(hdr->bits,pk->hdr.lut);
+    enctbl(pk->hdr.lut,hdr->bits,pk->enc);
+    pk->pos=PACKHDRLEN;
+
+    encodehdr(&pk->hdr,buf);
+    if (fwrite(buf,PACKHDRLEN,1,pk->fp)!=1) {
+        fclose(pk->fp);
+        pk->fp=NULL;
+        return -1;
+    }
+    return 0;
+}
+/* write packed IF file --------------------------------------------------------
+* pack int8 data and write them as one block of packed IF file
+* args   : sdrpack_t *pk    I/O packed IF file struct
+*          char   *in       I   int8 data (I/Q interleaved)
+*          int    n         I   number of data (I and Q)
+* return : int                  status 0:okay -1:failure
+* note : data which are not byte aligned are padded by the first level.
+*        only the last block can be padded
+*-----------------------------------------------------------------------------*/
+extern int packwrite(sdrpack_t *pk, const char *in, int n)
+{
+    int i,np,nb,bits=pk->hdr.bits;
+
+    for (np=n;(np*bits)%8;np++) ;
+    nb=np*bits/8;
+
+    if (packbuff(pk,np)<0||!pk->fp) return -1;
+
+    /* pad last data in tmp buffer */
+    if (np>n) {
+        memcpy(pk->tmp,in,n);
+        for (i=n;i<np;i++) pk->tmp[i]=pk->hdr.lut[0];
+        in=pk->tmp;
+    }
+    if (addindex(pk,pk->hdr.nsamp,pk->pos)<0) return -1;
+    convpack(in,np,bits,pk->enc,pk->buf);
+    if (fwrite(pk->buf,1,nb,pk->fp)!=(size_t)nb) return -1;
+
+    if (pk->hdr.blklen<n/pk->hdr.dtype) pk->hdr.blklen=n/pk->hdr.dtype;
+    pk->hdr.nsamp+=n/pk->hdr.dtype;
+    pk->pos+=nb;
+    return 0;
+}
+/* finish packed IF file -------------------------------------------------------
+* write block index and header, and close packed IF file
+* args   : sdrpack_t *pk    I/O packed IF file struct
+* return : int                  status 0:okay -1:failure
+*-----------------------------------------------------------------------------*/
+extern int packfinish(sdrpack_t *pk)
+{
+    uint8_t buf[PACKHDRLEN];
+    uint64_t i;
+    int ret=0;
+
+    if (!pk->fp) return -1;
+
+    pk->hdr.nblk=pk->nidx;
+    pk->hdr.idxoff=pk->pos;
+    for (i=0;i<2*pk->nidx&&!ret;i++) {
+        setu8(buf,pk->idx[i]);
+        if (fwrite(buf,8,1,pk->fp)!=1) ret=-1;
+    }
+    encodehdr(&pk->hdr,buf);
+    if (ret<0||seekfile(pk->fp,0)<0||fwrite(buf,PACKHDRLEN,1,pk->fp)!=1) {
+        ret=-1;
+    }
+    fclose(pk->fp);
+    pk->fp=NULL;
+    packclose(pk);
+    return ret;
+}
+/* convert raw IF file to packed IF file ---------------------------------------
+* convert raw IF file (int8 data) of front end configuration to packed IF file.
+* int8 data are encoded to nearest level of decoding table
+* args   : sdrini_t *ini    I   sdr initialization struct
+*          int    ftype     I   IF file to convert (FTYPE1 or FTYPE2)
+*          int    bits      I   bits per data (1,2,4,8)
+*          char   *outfile  I   output packed IF file path
+*          char   *fend     I   front end type written to header
+* return : int                  status 0:okay -1:failure
+*-----------------------------------------------------------------------------*/
+extern int sdrpackconv(sdrini_t *ini, int ftype, int bits, const char *outfile,
+                       const char *fend)
+{
+    sdrpackhdr_t hdr={0};
+    sdrpack_t pk;
+    const char *infile=ftype==FTYPE2?ini->file2:ini->file1;
+    char *in;
+    FILE *fp;
+    uint64_t nsamp,ninexact=0;
+    int i,k=ftype==FTYPE2?1:0,nr,ret=0,len=ini->dtype[k]*FILE_BUFFSIZE;
+
+    hdr.f_sf =ini->f_sf[k];
+    hdr.f_if =ini->f_if[k];
+    hdr.f_cf =ini->f_cf[k];
+    hdr.dtype=ini->dtype[k];
+    hdr.bits =bits;
+    strncpy(hdr.fend,fend,31);
+
+    if (!(fp=fopen(infile,"rb"))) {
+        SDRPRINTF("error: failed to open file: %s\n",infile);
+        return -1;
+    }
+    if (!(in=(char *)malloc(len))||packcreate(outfile,&hdr,&pk)<0) {
+        free(in);
+        fclose(fp);
+        return -1;
+    }
+    while (!ret&&(nr=(int)fread(in,1,len,fp))>0) {
+
+        /* requantization of data not on levels of decoding table */
+        for (i=0;bits<8&&i<nr;i++) {
+            if (pk.hdr.lut[pk.enc[(signed char)in[i]+128]]!=in[i]) ninexact++;
+        }
+        ret=packwrite(&pk,in,nr);
+    }
+    nsamp=pk.hdr.nsamp;
+    if (packfinish(&pk)<0) ret=-1;
+
+    if (ret<0) {
+        SDRPRINTF("error: failed to write file: %s\n",outfile);
+    }
+    else {
+        SDRPRINTF("packed IF file: %s samples=%.0f bits=%d size=%.1f%% "
+            "requantized=%.0f\n",outfile,(double)nsamp,bits,100.0*bits/8,
+            (double)ninexact);
+    }
+    free(in);
+    fclose(fp);
+    return ret;
+}
@@ -115,6 +115,7 @@ extern int initsdrplot(sdrplt_t *plt)
 {
     int xi,yi;
     int posx,posy;
+    uint64_t oldmask;
 
     /* memory allocation */
     switch (plt->type) {
@@ -154,16 +155,20 @@ extern int initsdrplot(sdrplt_t *plt)
         SDRPRINTF("error: updatepltini\n");
         return -1;
     }
-    /* pipe open */
+    /* pipe open (gnuplot inherits cpu affinity of plotting threads) */
+    oldmask=getthreadaffinity();
+    setthreadaffinity(rtcpumask(RT_PLOT));
 #ifdef WIN32
     if (!(plt->fp=_popen(".\\gnuplot\\gnuplot.exe","w"))) {
 #else
     if (!(plt->fp=popen("gnuplot","w"))) {
 #endif
+        setthreadaffinity(oldmask);
         unmlock(hpltmtx);
         SDRPRINTF("error: gnuplot doesn't exist \n");
         return -1;
     }
+    setthreadaffinity(oldmask);
     sleepms(200);
     unmlock(hpltmtx);
 #ifdef GUI
@@ -358,6 +363,7 @@ static void *plotgnuplot(void *arg)
 #ifndef WIN32
     pthread_detach(pthread_self()); /* release memory */
 #endif
+    sdrrtthread(RT_PLOT); /* isolate from grabber and channel threads */
 
     /* selection of plot type */
     switch (plt->type) {
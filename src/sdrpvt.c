@@ -0,0 +1,361 @@
+/*------------------------------------------------------------------------------
+* sdrpvt.c : SDR single point positioning functions
+*
+* Copyright (C) 2014 Taro Suzuki <gnsssdrlib@gmail.com>
+*-----------------------------------------------------------------------------*/
+#include "sdr.h"
+
+#define MU_GPS      3.9860050E14   /* gravitational constant (GPS) (m^3/s^2) */
+#define MU_GAL      3.986004418E14 /* gravitational constant (GAL) (m^3/s^2) */
+#define OMGE_GAL    7.2921151467E-5 /* earth angular velocity (GAL) (rad/s) */
+#define KEPTOL      1E-13          /* tolerance of kepler equation (rad) */
+#define KEPITR      30             /* max iterations of kepler equation */
+#define PVTITR      10             /* max iterations of least square */
+#define PVTTOL      1E-4           /* tolerance of least square (m) */
+#define PVTERR      3.0            /* code error at zenith (m) */
+#define PVTGDOP     30.0           /* max gdop of solution */
+#define PVTHUMI     0.7            /* relative humidity of troposphere model */
+
+/* load orbit cache ------------------------------------------------------------
+* load ephemeris published by decoder and compute orbit constants. constants
+* are valid until the decoder completes next ephemeris
+* args   : sdrpvtsat_t *ps  O   orbit cache
+*          sdrch_t *sdr     I   sdr channel struct
+* return : none
+*-----------------------------------------------------------------------------*/
+static void loadsat(sdrpvtsat_t *ps, const sdrch_t *sdr)
+{
+    sdreph_t eph;
+    double mu,omge,tt;
+
+    ps->ephnew=sdr->nav.ephnew;
+    navgeteph(&sdr->nav,&eph);
+    ps->eph=eph.eph;
+    ps->sys=sdr->sys;
+    ps->valid=0;
+
+    if (ps->eph.A<=0.0) return;
+
+    if (ps->sys==SYS_GAL) {
+        ps->toe=ps->eph.toe;
+        mu=MU_GAL; omge=OMGE_GAL;
+    }
+    else if (ps->sys==SYS_GPS||ps->sys==SYS_QZS) {
+        /* toe in the week of toc */
+        ps->toe=gpst2time(ps->eph.week,ps->eph.toes);
+        tt=timediff(ps->toe,ps->eph.toc);
+        if      (tt<-302400.0) ps->toe=timeadd(ps->toe, 604800.0);
+        else if (tt> 302400.0) ps->toe=timeadd(ps->toe,-604800.0);
+        mu=MU_GPS; omge=OMGE;
+    }
+    else return; /* GLONASS and BeiDou orbits are not supported */
+
+    ps->n=sqrt(mu/(ps->eph.A*ps->eph.A*ps->eph.A))+ps->eph.deln;
+    ps->sqe=sqrt(1.0-ps->eph.e*ps->eph.e);
+    ps->omgk=ps->eph.OMGd-omge;
+    ps->omg0=ps->eph.OMG0-omge*ps->eph.toes;
+    ps->fr=-2.0*sqrt(mu*ps->eph.A)*ps->eph.e/(CLIGHT*CLIGHT);
+    ps->valid=ps->toe.time!=0;
+}
+/* satellite position and clock by ephemeris -----------------------------------
+* compute satellite position and clock bias by broadcast ephemeris
+* args   : sdrpvtsat_t *ps  I   orbit cache
+*          gtime_t t        I   transmission time (gpst)
+*          double *rs       O   satellite position (ecef) (m)
+*          double *dts      O   satellite clock bias (s)
+* return : int                  1:okay 0:no valid ephemeris
+*-----------------------------------------------------------------------------*/
+static int ephpos(const sdrpvtsat_t *ps, gtime_t t, double *rs, double *dts)
+{
+    const eph_t *eph=&ps->eph;
+    double tk,M,E,Ek,sinE,cosE,u,r,i,sin2u,cos2u,x,y,O,sinO,cosO,cosi,tc;
+    int k;
+
+    tk=timediff(t,ps->toe);
+    if (!ps->valid||eph->svh!=0||fabs(tk)>MAXDTOE) return 0;
+
+    M=eph->M0+ps->n*tk;
+    for (E=M,k=0;k<KEPITR;k++) {
+        Ek=E;
+        E-=(E-eph->e*sin(E)-M)/(1.0-eph->e*cos(E));
+        if (fabs(E-Ek)<KEPTOL) break;
+    }
+    sinE=sin(E); cosE=cos(E);
+    u=atan2(ps->sqe*sinE,cosE-eph->e)+eph->omg;
+    r=eph->A*(1.0-eph->e*cosE);
+    i=eph->i0+eph->idot*tk;
+    sin2u=sin(2.0*u); cos2u=cos(2.0*u);
+    u+=eph->cus*sin2u+eph->cuc*cos2u;
+    r+=eph->crs*sin2u+eph->crc*cos2u;
+    i+=eph->cis*sin2u+eph->cic*cos2u;
+    x=r*cos(u); y=r*sin(u); cosi=cos(i);
+    O=ps->omg0+ps->omgk*tk;
+    sinO=sin(O); cosO=cos(O);
+    rs[0]=x*cosO-y*cosi*sinO;
+    rs[1]=x*sinO+y*cosi*cosO;
+    rs[2]=y*sin(i);
+
+    tc=timediff(t,eph->toc);
+    *dts=eph->f0+eph->f1*tc+eph->f2*tc*tc+ps->fr*sinE;
+    return 1;
+}
+/* pseudorange residuals -------------------------------------------------------
+* compute weighted residuals and design matrix. clock bias of system without
+* satellite is constrained to zero by pseudo observation
+* args   : double *x        I   states {x,y,z,dtr_gps,dtr_gal} (m)
+*          gtime_t time     I   receiver time (gpst)
+*          double *rs       I   satellite positions (ecef) (m)
+*          double *pr       I   corrected pseudoranges (m) (0:not used)
+*          int    *sys      I   navigation systems
+*          int    n         I   number of satellites
+*          double *H        O   transpose of design matrix (PVTNX x nv)
+*          double *v        O   residuals (nv x 1)
+*          double *azel     O   azimuth/elevation angles (rad)
+*          int    *vsat     O   valid satellite flags
+* return : int                  number of residuals nv
+*-----------------------------------------------------------------------------*/
+static int resid(const double *x, gtime_t time, const double *rs,
+                 const double *pr, const int *sys, int n, double *H,
+                 double *v, double *azel, int *vsat)
+{
+    const double ion[8]={0}; /* default klobuchar parameters */
+    double pos[3],e[3],r,w;
+    int i,j,k,nv=0,mask[PVTNX-3]={0};
+
+    ecef2pos(x,pos);
+
+    for (i=0;i<n;i++) {
+        vsat[i]=0;
+        if (pr[i]==0.0||(r=geodist(rs+i*3,x,e))<=0.0) continue;
+        if (satazel(pos,e,azel+i*2)<sdrini.elmask*D2R) continue;
+
+        j=sys[i]==SYS_GAL?1:0;
+        r+=x[3+j]+ionmodel(time,ion,pos,azel+i*2)+
+            tropmodel(time,pos,azel+i*2,PVTHUMI);
+
+        w=sin(azel[1+i*2])/PVTERR; /* weight by elevation */
+        v[nv]=w*(pr[i]-r);
+        for (k=0;k<PVTNX;k++) {
+            H[k+nv*PVTNX]=w*(k<3?-e[k]:(k==3+j?1.0:0.0));
+        }
+        mask[j]=vsat[i]=1;
+        nv++;
+    }
+    for (j=0;j<PVTNX-3;j++) {
+        if (mask[j]) continue;
+        v[nv]=-x[3+j];
+        for (k=0;k<PVTNX;k++) H[k+nv*PVTNX]=k==3+j?1.0:0.0;
+        nv++;
+    }
+    return nv;
+}
+/* least square estimation -----------------------------------------------------
+* args   : double *x        I/O states {x,y,z,dtr_gps,dtr_gal} (m)
+*          gtime_t time     I   receiver time (gpst)
+*          double *rs,*pr   I   satellite positions and pseudoranges
+*          int    *sys      I   navigation systems
+*          int    n         I   number of satellites
+*          sdrsol_t *sol    O   solution (ns and gdop)
+* return : int                  1:okay 0:no solution
+*-----------------------------------------------------------------------------*/
+static int estpos(double *x, gtime_t time, const double *rs, const double *pr,
+                  const int *sys, int n, sdrsol_t *sol)
+{
+    double H[PVTNX*(MAXSAT+PVTNX)],v[MAXSAT+PVTNX],dx[PVTNX],Q[PVTNX*PVTNX];
+    double azel[2*MAXSAT],azv[2*MAXSAT],dop[4];
+    int i,k,nv,ns,vsat[MAXSAT];
+
+    for (k=0;k<PVTITR;k++) {
+        if ((nv=resid(x,time,rs,pr,sys,n,H,v,azel,vsat))<PVTNX) return 0;
+        if (lsq(H,v,PVTNX,nv,dx,Q)) return 0;
+
+        for (i=0;i<PVTNX;i++) x[i]+=dx[i];
+        if (norm(dx,PVTNX)<PVTTOL) break;
+    }
+    if (k>=PVTITR) return 0;
+
+    for (i=ns=0;i<n;i++) {
+        if (!vsat[i]) continue;
+        azv[ns*2]=azel[i*2]; azv[1+ns*2]=azel[1+i*2];
+        ns++;
+    }
+    dops(ns,azv,sdrini.elmask*D2R,dop);
+    sol->ns=ns;
+    sol->gdop=dop[0];
+    return dop[0]>0.0&&dop[0]<=PVTGDOP;
+}
+/* output solution -------------------------------------------------------------
+* write solution to solution file and print it to console once a second
+* args   : sdrpvt_t *pvt    I/O single point positioning struct
+*          sdrsol_t *sol    I   solution
+* return : none
+*-----------------------------------------------------------------------------*/
+static void writesol(sdrpvt_t *pvt, const sdrsol_t *sol)
+{
+    char tstr[64];
+
+    time2str(sol->time,tstr,3);
+
+    if (pvt->fp) {
+        fprintf(pvt->fp,"%s %14.9f %14.9f %10.4f %3d %6.1f %8.1f\n",tstr,
+            sol->pos[0]*R2D,sol->pos[1]*R2D,sol->pos[2],sol->ns,sol->gdop,
+            sol->latency*1E3);
+    }
+#if !defined(GUI) /* GUI shows solution on monitor */
+    if (tickget()-pvt->tout>=1000) {
+        SDRPRINTF("PVT: %s %12.7f %12.7f %8.1f ns=%d gdop=%.1f lat=%.0fms\n",
+            tstr,sol->pos[0]*R2D,sol->pos[1]*R2D,sol->pos[2],sol->ns,
+            sol->gdop,sol->latency*1E3);
+        pvt->tout=tickget();
+    }
+#endif
+}
+/* initialize single point positioning -----------------------------------------
+* args   : sdrini_t *ini    I   sdr initialization struct
+* return : int                  status 0:okay -1:failure
+*-----------------------------------------------------------------------------*/
+extern int pvtinit(sdrini_t *ini)
+{
+    sdrpvt_t *pvt;
+
+    if (!ini->pvt) return 0;
+
+    if (!(pvt=(sdrpvt_t *)calloc(1,sizeof(sdrpvt_t)))) {
+        SDRPRINTF("error: pvtinit memory allocation\n");
+        return -1;
+    }
+    if (ini->pvtfile[0]) {
+        if (!(pvt->fp=fopen(ini->pvtfile,"w"))) {
+            SDRPRINTF("error: failed to open file: %s\n",ini->pvtfile);
+            free(pvt);
+            return -1;
+        }
+        fprintf(pvt->fp,"%%  GPST                   latitude(deg) "
+            "longitude(deg)  height(m)  ns   gdop latency(ms)\n");
+    }
+    sdrstat.pvt=pvt;
+    return 0;
+}
+/* terminate single point positioning ------------------------------------------
+* close solution file and print statistics of solutions
+* args   : none
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void pvtquit(void)
+{
+    sdrpvt_t *pvt=sdrstat.pvt;
+    double n;
+
+    if (pvt==NULL) return;
+
+    sdrstat.pvt=NULL;
+    if (pvt->nsol+pvt->nfail>0) {
+        n=pvt->nsol>0?(double)pvt->nsol:1.0;
+        SDRPRINTF("PVT: solutions=%.0f failed=%.0f latency mean=%.1f "
+            "max=%.1f ms, compute mean=%.1f max=%.1f us\n",
+            (double)pvt->nsol,(double)pvt->nfail,pvt->latsum/n*1E3,
+            pvt->latmax*1E3,pvt->tcsum/n,pvt->tcmax);
+        if (sdrini.pvtlat>0.0) {
+            SDRPRINTF("PVT: %.0f solutions over latency budget %.0f ms\n",
+                (double)pvt->nover,sdrini.pvtlat);
+        }
+    }
+    if (pvt->fp) fclose(pvt->fp);
+    free(pvt);
+}
+/* single point positioning ----------------------------------------------------
+* compute receiver position by pseudoranges of an observation epoch and
+* publish the solution. orbit constants of channels are cached while the
+* ephemeris is not updated
+* args   : obsd_t *obs      I   observation data
+*          int    n         I   number of observation data
+*          int    *ich      I   channel index of observation data
+*          double comloc    I   common time index of observation epoch (sample)
+* return : int                  1:solution published 0:no solution
+* note : latency is the data received after the observation epoch until the
+*        solution is published. called by sync thread (or offline processing)
+*-----------------------------------------------------------------------------*/
+extern int pvtsolve(const obsd_t *obs, int n, const int *ich, double comloc)
+{
+    sdrpvt_t *pvt=sdrstat.pvt;
+    sdrpvtsat_t *ps;
+    sdrsol_t sol={{0}};
+    gtime_t t;
+    double rs[3*MAXSAT],pr[MAXSAT],dts,x[PVTNX],tc;
+    int i,sys[MAXSAT];
+    unsigned long t0;
+
+    if (pvt==NULL||n<=0) return 0;
+
+    t0=tickgetus();
+    for (i=0;i<n&&i<MAXSAT;i++) {
+        ps=&pvt->sat[ich[i]];
+        if (ps->ephnew!=sdrch[ich[i]].nav.ephnew||!ps->valid) {
+            loadsat(ps,&sdrch[ich[i]]);
+        }
+        sys[i]=ps->sys;
+        pr[i]=0.0;
+        if (obs[i].P[0]==0.0) continue;
+
+        /* transmission time corrected by satellite clock */
+        t=timeadd(obs[i].time,-obs[i].P[0]/CLIGHT);
+        if (!ephpos(ps,t,rs+i*3,&dts)) continue;
+        t=timeadd(t,-dts);
+        if (!ephpos(ps,t,rs+i*3,&dts)) continue;
+
+        pr[i]=obs[i].P[0]+CLIGHT*dts;
+        if (sys[i]!=SYS_GAL) pr[i]-=CLIGHT*ps->eph.tgd[0]; /* L1 group delay */
+    }
+    memcpy(x,pvt->x,sizeof(x)); /* last solution as initial states */
+
+    if (!estpos(x,obs[0].time,rs,pr,sys,i,&sol)) {
+        memset(pvt->x,0,sizeof(pvt->x));
+        pvt->nfail++;
+        return 0;
+    }
+    memcpy(pvt->x,x,sizeof(x));
+
+    sol.time=timeadd(obs[0].time,-x[3]/CLIGHT);
+    matcpy(sol.rr,x,3,1);
+    ecef2pos(x,sol.pos);
+    sol.dtr[0]=x[3];
+    sol.dtr[1]=x[4];
+    sol.latency=((double)rcvheadloc()-comloc)/sdrini.f_sf[0];
+
+    /* publish solution */
+    pvt->sol[(pvt->solver+1)&1]=sol;
+    sdrbarrier();
+    pvt->solver++;
+
+    tc=(double)(tickgetus()-t0);
+    pvt->nsol++;
+    pvt->latsum+=sol.latency;
+    pvt->tcsum+=tc;
+    if (sol.latency>pvt->latmax) pvt->latmax=sol.latency;
+    if (tc>pvt->tcmax) pvt->tcmax=tc;
+    if (sdrini.pvtlat>0.0&&sol.latency*1E3>sdrini.pvtlat) pvt->nover++;
+
+    writesol(pvt,&sol);
+    return 1;
+}
+/* get solution ----------------------------------------------------------------
+* copy latest solution. solution is double buffered, so positioning never
+* waits for readers
+* args   : sdrsol_t *sol    O   solution
+* return : int                  1:okay 0:no solution
+*-----------------------------------------------------------------------------*/
+extern int pvtgetsol(sdrsol_t *sol)
+{
+    sdrpvt_t *pvt=sdrstat.pvt;
+    uint32_t ver;
+
+    if (pvt==NULL||pvt->solver==0) return 0;
+
+    do {
+        ver=pvt->solver;
+        sdrbarrier();
+        *sol=pvt->sol[ver&1];
+        sdrbarrier();
+    } while (pvt->solver!=ver);
+    return 1;
+}
@@ -3,273 +3,656 @@
 *
 * Copyright (C) 2014 Taro Suzuki <gnsssdrlib@gmail.com>
 *-----------------------------------------------------------------------------*/
+#ifndef WIN32
+#define _FILE_OFFSET_BITS 64
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
 #include "sdr.h"
 
-/* sdr receiver initialization -------------------------------------------------
-* receiver initialization, memory allocation, file open
-* args   : sdrini_t *ini    I   sdr initialization struct
+/* seek file -------------------------------------------------------------------
+* set file position by 64 bit offset
+* args   : FILE   *fp       I   file pointer
+*          uint64_t off     I   offset from start of file (bytes)
 * return : int                  status 0:okay -1:failure
 *-----------------------------------------------------------------------------*/
+static int fileseek(FILE *fp, uint64_t off)
+{
+#ifdef WIN32
+    return _fseeki64(fp,(__int64)off,SEEK_SET)?-1:0;
+#else
+    return fseeko(fp,(off_t)off,SEEK_SET)?-1:0;
+#endif
+}
+/* map IF file -----------------------------------------------------------------
+* map whole IF file to memory (read-only)
+* args   : char   *file     I   IF file path
+*          uint64_t off     I   start offset of IF data (bytes)
+*          sdrmap_t *map    O   memory-mapped IF file struct
+* return : int                  status 0:okay -1:failure
+*-----------------------------------------------------------------------------*/
+static int mapfile(const char *file, uint64_t off, sdrmap_t *map)
+{
+#ifdef WIN32
+    LARGE_INTEGER size;
 
-extern int rcvinit(sdrini_t *ini)
+    map->hfile=CreateFileA(file,GENERIC_READ,FILE_SHARE_READ,NULL,
+        OPEN_EXISTING,FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+    if (map->hfile==INVALID_HANDLE_VALUE) return -1;
+    if (!GetFileSizeEx(map->hfile,&size)||(uint64_t)size.QuadPart<=off||
+        !(map->hmap=CreateFileMappingA(map->hfile,NULL,PAGE_READONLY,0,0,
+        NULL))) {
+        CloseHandle(map->hfile);
+        return -1;
+    }
+    if (!(map->base=MapViewOfFile(map->hmap,FILE_MAP_READ,0,0,0))) {
+        CloseHandle(map->hmap);
+        CloseHandle(map->hfile);
+        return -1;
+    }
+    map->len=(uint64_t)size.QuadPart;
+#else
+    struct stat st;
+    void *p;
+
+    if ((map->fd=open(file,O_RDONLY))<0) return -1;
+    if (fstat(map->fd,&st)<0||(uint64_t)st.st_size<=off||
+        (uint64_t)st.st_size>(uint64_t)SIZE_MAX) {
+        close(map->fd);
+        return -1;
+    }
+    p=mmap(NULL,(size_t)st.st_size,PROT_READ,MAP_SHARED,map->fd,0);
+    if (p==MAP_FAILED) {
+        close(map->fd);
+        return -1;
+    }
+    madvise(p,(size_t)st.st_size,MADV_SEQUENTIAL);
+    map->base=p;
+    map->len=(uint64_t)st.st_size;
+#endif
+    map->skip=off;
+    map->p=(const uint8_t *)map->base+off;
+    map->size=map->len-off;
+    map->ahead=map->drop=0;
+    return 0;
+}
+/* unmap IF file ---------------------------------------------------------------
+* args   : sdrmap_t *map    I/O memory-mapped IF file struct
+* return : none
+*-----------------------------------------------------------------------------*/
+static void unmapfile(sdrmap_t *map)
 {
+    if (map->p==NULL) return;
 #ifdef WIN32
-    WSADATA wsaData;
-    WSAStartup(MAKEWORD(1,0),&wsaData);
+    UnmapViewOfFile(map->base);
+    CloseHandle(map->hmap);
+    CloseHandle(map->hfile);
+#else
+    munmap(map->base,(size_t)map->len);
+    close(map->fd);
 #endif
+    memset(map,0,sizeof(sdrmap_t));
+}
+/* advise access pattern of mapped IF file -------------------------------------
+* prefetch data ahead of the file reader and release data behind the slowest
+* sdr channel, so that the resident memory stays flat for large files
+* args   : sdrmap_t *map    I/O memory-mapped IF file struct
+*          uint64_t ahead   I   end of data to be prefetched (bytes)
+*          uint64_t drop    I   end of data to be released (bytes)
+* return : none
+* note : released pages are read again from the file if they are accessed.
+*        windows relies on sequential scan hint of the cache manager
+*-----------------------------------------------------------------------------*/
+static void mapadvise(sdrmap_t *map, uint64_t ahead, uint64_t drop)
+{
+#ifndef WIN32
+    uint64_t pg=(uint64_t)sysconf(_SC_PAGESIZE),s,e;
 
-    /* FFT initialization */
-    fftwf_init_threads();
+    if (ahead>map->size) ahead=map->size;
+    if (ahead>map->ahead) {
+        s=(map->skip+map->ahead)/pg*pg;
+        e=map->skip+ahead;
+        madvise((char *)map->base+s,(size_t)(e-s),MADV_WILLNEED);
+        map->ahead=ahead;
+    }
+    if (drop>map->ahead) drop=map->ahead;
+    s=(map->skip+map->drop)/pg*pg;
+    e=(map->skip+drop)/pg*pg;
+    if (e>s) {
+        madvise((char *)map->base+s,(size_t)(e-s),MADV_DONTNEED);
+        map->drop=drop;
+    }
+#endif
+}
+/* span of mapped IF file ------------------------------------------------------
+* get pointer to IF data in memory-mapped file. data beyond end of file are
+* padded by zero in extracted data buffer
+* args   : sdrmap_t *map    I   memory-mapped IF file struct
+*          uint64_t off     I   offset of data (bytes)
+*          int    n         I   size of data (bytes)
+*          char   *expbuf   O   extracted data buffer (end of file)
+* return : char*                pointer to IF data
+*-----------------------------------------------------------------------------*/
+static const char *mapspan(const sdrmap_t *map, uint64_t off, int n,
+                           char *expbuf)
+{
+    int m=0;
 
-    sdrstat.buff=sdrstat.buff2=NULL;
+    if (off+n<=map->size) return (const char *)map->p+off;
 
-    switch (ini->fend) 
-	{
-#ifdef GN3S
-    /* SiGe GN3S v2/v3 */
-    case FEND_GN3SV2: 
-    case FEND_GN3SV3: 
-        if (gn3s_init()<0) return -1; /* GN3S initialization */
-
-		if (ini->fend == FEND_GN3SV2)
-		{
-			sdrstat.fendbuffsize = GN3S_BUFFSIZE / 2; /* frontend buff size */
-			fgn3s_set_rx_buf(sdrstat.fendbuffsize);
-			sdrstat.buffsize = sdrstat.fendbuffsize * 2 * MEMBUFFLEN; /* total */
-		}
-		if (ini->fend == FEND_GN3SV3)
-		{
-			sdrstat.fendbuffsize = GN3S_BUFFSIZE; /* frontend buff size */
-			fgn3s_set_rx_buf(sdrstat.fendbuffsize);
-			sdrstat.buffsize = sdrstat.fendbuffsize * MEMBUFFLEN; /* total */
-		}
-
-        /* memory allocation */
-		// This buffer is used to store raw data from USB
-        sdrstat.buff=(uint8_t*)malloc(sdrstat.buffsize);
-        if (NULL==sdrstat.buff) {
-            SDRPRINTF("error: failed to allocate memory for the buffer\n");
-            return -1;
-        }
-        break;
-    /* GN3S Binary File */
-    case FEND_FGN3SV2:
-    case FEND_FGN3SV3:
-        /* IF file open */
-        if ((ini->fp1 = fopen(ini->file1,"rb"))==NULL){
-            SDRPRINTF("error: failed to open file : %s\n",ini->file1);
-            return -1;
-        }
-        
-		if (ini->fend == FEND_FGN3SV2)
-		{
-			sdrstat.fendbuffsize = GN3S_BUFFSIZE / 2; /* frontend buff size */
-			sdrstat.fendbuffsize = sdrstat.fendbuffsize * GN3S_FILE_READ_RATIO;//increase to make more realtime
-			fgn3s_set_rx_buf(sdrstat.fendbuffsize);
-			sdrstat.buffsize = sdrstat.fendbuffsize * 2 * MEMBUFFLEN; /* total */
-		}
-		if (ini->fend == FEND_FGN3SV3)
-		{
-			sdrstat.fendbuffsize = GN3S_BUFFSIZE; /* frontend buff size */
-			sdrstat.fendbuffsize = sdrstat.fendbuffsize * GN3S_FILE_READ_RATIO;//increase to make more realtime
-			fgn3s_set_rx_buf(sdrstat.fendbuffsize);
-			sdrstat.buffsize = sdrstat.fendbuffsize * MEMBUFFLEN; /* total */
-		}
-
-        /* memory allocation */
-        sdrstat.buff=(uint8_t*)malloc(sdrstat.buffsize);
-        if (NULL==sdrstat.buff) {
-            SDRPRINTF("error: failed to allocate memory for the buffer\n");
-            return -1;
-        }
-		SDRPRINTF("Data is taken from file, reading is not real-time\n");
-        break;
+    if (off<map->size) {
+        m=(int)(map->size-off);
+        memcpy(expbuf,map->p+off,m);
+    }
+    memset(expbuf+m,0,n-m);
+    return expbuf;
+}
+/* number of blocks of memory buffer -------------------------------------------
+* set number of blocks of memory buffer from its depth (RINGMS). the number
+* is rounded up to power of 2 so that block index is masked by nblkmask
+* args   : sdrini_t *ini    I   sdr initialization struct
+*          int    fendbuffsize  I   front end buffer size (samples per block)
+* return : none
+*-----------------------------------------------------------------------------*/
+static void ringblocks(sdrini_t *ini, int fendbuffsize)
+{
+    int n,ms=ini->ringms>0?ini->ringms:RINGMS;
+
+    sdrstat.fendbuffsize=fendbuffsize; /* frontend buff size */
+    n=(int)ceil(ms*1E-3*ini->f_sf[0]/fendbuffsize);
+    for (sdrstat.nblk=RINGMINBLK;sdrstat.nblk<n;sdrstat.nblk*=2) ;
+    sdrstat.nblkmask=sdrstat.nblk-1;
+}
+/* allocate memory buffer ------------------------------------------------------
+* args   : sdrini_t *ini    I   sdr initialization struct
+*          int    fendbuffsize  I   front end buffer size (samples per block)
+*          int    blklen    I   size of one block (bytes)
+* return : int                  status 0:okay -1:failure
+* note : blocks are aligned by cache line if blklen is a multiple of 64
+*-----------------------------------------------------------------------------*/
+static int allocbuff(sdrini_t *ini, int fendbuffsize, int blklen)
+{
+    ringblocks(ini,fendbuffsize);
+    sdrstat.buffsize=blklen*sdrstat.nblk; /* total */
+
+    sdrstat.buff=(uint8_t*)sdrmemalloc(sdrstat.buffsize,ini->hugepage);
+    if (NULL==sdrstat.buff) {
+        SDRPRINTF("error: failed to allocate memory for the buffer\n");
+        return -1;
+    }
+    return 0;
+}
+#if defined(GN3S)||defined(RTLSDR)||defined(BLADERF)
+/* open/close IF file of front end binary file -------------------------------*/
+static int openfend(sdrini_t *ini)
+{
+    if ((ini->fp1=fopen(ini->file1,"rb"))==NULL) {
+        SDRPRINTF("error: failed to open file : %s\n",ini->file1);
+        return -1;
+    }
+    return 0;
+}
+static void closefend(sdrini_t *ini)
+{
+    if (ini->fp1!=NULL) fclose(ini->fp1);
+    ini->fp1=NULL;
+}
 #endif
-#ifdef BLADERF
-    /* Nuand bladeRF */
-    case FEND_BLADERF:
-        if (bladerf_init()<0) return -1; /* bladeRF initialization */
+/* span of memory buffer -------------------------------------------------------
+* lend span of memory buffer (zero-copy). data wrapped around the end of
+* memory buffer are extracted to buffer
+* args   : sdrini_t *ini    I   sdr initialization struct
+*          uint64_t buffloc I   buffer location
+*          int    n         I   number of samples of data data to get
+*          int    ftype     I   front end type (FTYPE1 or FTYPE2)
+*          int    dtype     I   data type (DTYPEI or DTYPEIQ)
+*          char   *expbuff  O   extracted data buffer (n*dtype bytes)
+* return : char*                pointer to data
+*-----------------------------------------------------------------------------*/
+static const char *spanbuff(sdrini_t *ini, uint64_t buffloc, int n, int ftype,
+                            int dtype, char *expbuf)
+{
+    uint64_t size=(uint64_t)sdrstat.nblk*dtype*sdrstat.fendbuffsize;
+    uint64_t loc=dtype*buffloc%size;
+
+    if (ftype==FTYPE1&&loc+dtype*n<=size) {
+        return (const char *)sdrstat.buff+loc;
+    }
+    membuff_getbuff(buffloc,n,ftype,dtype,expbuf);
+    return expbuf;
+}
+/* data format of memory buffer ----------------------------------------------*/
+static void fmtbuff(sdrini_t *ini, sdrfmt_t *fmt)
+{
+    memset(fmt,0,sizeof(sdrfmt_t));
+    fmt->nbuf=1;
+    fmt->dtype[0]=ini->dtype[0];
+    fmt->blklen[0]=sdrstat.fendbuffsize;
+    fmt->nblk[0]=sdrstat.nblk;
+    fmt->zerocopy=1;
+}
+#ifdef GN3S
+/* SiGe GN3S v2/v3 -----------------------------------------------------------*/
+static int initgn3s(sdrini_t *ini)
+{
+    if (gn3s_init()<0) return -1; /* GN3S initialization */
 
-        sdrstat.fendbuffsize=BLADERF_DATABUFF_SIZE; /* frontend buff size */
-        sdrstat.buffsize=2*BLADERF_DATABUFF_SIZE*MEMBUFFLEN; /* total */
+    /* buff: expanded int8 data, buff2: raw data from USB (one block) */
+    if (ini->fend==FEND_GN3SV2) {
+        if (allocbuff(ini,GN3S_BUFFSIZE/2,GN3S_BUFFSIZE/2*2)<0) return -1;
+    }
+    else if (allocbuff(ini,GN3S_BUFFSIZE,GN3S_BUFFSIZE*ini->dtype[0])<0) {
+        return -1;
+    }
 
-        /* memory allocation */
-        sdrstat.buff=(uint8_t*)malloc(sdrstat.buffsize);
-        if (NULL==sdrstat.buff) {
-            SDRPRINTF("error: failed to allocate memory for the buffer\n");
-            return -1;
-        }
-        break;
-    /* BladeRF Binary File */
-    case FEND_FBLADERF:
-        /* IF file open */
-        if ((ini->fp1 = fopen(ini->file1,"rb"))==NULL){
-            SDRPRINTF("error: failed to open file : %s\n",ini->file1);
-            return -1;
-        }
+    sdrstat.buff2=(uint8_t*)sdrmemalloc(GN3S_BUFFSIZE,0);
+    if (NULL==sdrstat.buff2) {
+        SDRPRINTF("error: failed to allocate memory for the buffer\n");
+        return -1;
+    }
+    return 0;
+}
+static int startgn3s(sdrini_t *ini)
+{
+    return gn3s_pushtomembuf(); /* overruns are counted, not fatal */
+}
+static void stopgn3s(sdrini_t *ini)
+{
+    gn3s_quit();
+    SDRPRINTF("GN3S buffer overruns: %.0f\n",(double)sdrstat.noverrun);
+}
+/* GN3S binary file ----------------------------------------------------------*/
+static int initfgn3s(sdrini_t *ini)
+{
+    int size=GN3S_BUFFSIZE*GN3S_FILE_READ_RATIO; /* increase to be realtime */
 
-        sdrstat.fendbuffsize=BLADERF_DATABUFF_SIZE; /* frontend buff size */
-        sdrstat.buffsize=2*BLADERF_DATABUFF_SIZE*MEMBUFFLEN; /* total */
+    if (openfend(ini)<0) return -1;
 
-        /* memory allocation */
-        sdrstat.buff=(uint8_t*)malloc(sdrstat.buffsize);
-        if (NULL==sdrstat.buff) {
-            SDRPRINTF("error: failed to allocate memory for the buffer\n");
-            return -1;
-        }
-		SDRPRINTF("Data is taken from file, reading is not real-time\n");
-        break;
+    if (ini->fend==FEND_FGN3SV2) {
+        if (allocbuff(ini,size/2,size/2*2)<0) return -1;
+    }
+    else if (allocbuff(ini,size,size*ini->dtype[0])<0) return -1;
+
+	SDRPRINTF("Data is taken from file, reading is not real-time\n");
+    return 0;
+}
+static int startfgn3s(sdrini_t *ini)
+{
+    fgn3s_pushtomembuf(); /* copy to membuffer */
+    rcvflowctrl(ini); /* wait for sdr channels */
+    return 0;
+}
+/* Simple 8bit ---------------------------------------------------------------*/
+static int initsimple(sdrini_t *ini)
+{
+    if (simple_rf_init()<0) return -1;
+
+    if (allocbuff(ini,SIMPLE_RF_BUFFSIZE,SIMPLE_RF_BUFFSIZE)<0) return -1;
+    return 0;
+}
+static int startsimple(sdrini_t *ini)
+{
+    return simple_rf_pushtomembuf(); /* overruns are counted, not fatal */
+}
+static void stopsimple(sdrini_t *ini)
+{
+    simple_rf_quit();
+    SDRPRINTF("Simple frontend buffer overruns: %.0f\n",
+        (double)sdrstat.noverrun);
+}
 #endif
-#ifdef RTLSDR
-    /* RTL-SDR */
-    case FEND_RTLSDR:
-        if (rtlsdr_init()<0) return -1; /* rtlsdr initialization */
-
-        /* frontend buffer size */
-        sdrstat.fendbuffsize=RTLSDR_DATABUFF_SIZE; /* frontend buff size */
-		rtlsdr_set_rx_buf(sdrstat.fendbuffsize);
-        sdrstat.buffsize=2 * RTLSDR_DATABUFF_SIZE * MEMBUFFLEN; /* total */
-
-        /* memory allocation */
-        sdrstat.buff=(uint8_t*)malloc(sdrstat.buffsize);
-        if (NULL==sdrstat.buff) {
-            SDRPRINTF("error: failed to allocate memory for the buffer\n");
-            return -1;
-        }
-        break;
-    /* RTL-SDR Binary File */
-    case FEND_FRTLSDR:
-        /* IF file open */
-        if ((ini->fp1 = fopen(ini->file1,"rb"))==NULL){
-            SDRPRINTF("error: failed to open file : %s\n",ini->file1);
-            return -1;
-        }
+#ifdef BLADERF
+/* Nuand bladeRF -------------------------------------------------------------*/
+static int initbladerf(sdrini_t *ini)
+{
+    if (bladerf_init()<0) return -1; /* bladeRF initialization */
 
-        /* frontend buffer size */
-        sdrstat.fendbuffsize=RTLSDR_DATABUFF_SIZE * RTLSDR_FILE_READ_RATIO; /* frontend buff size */
-		rtlsdr_set_rx_buf(sdrstat.fendbuffsize);
-        sdrstat.buffsize= 2 * sdrstat.fendbuffsize * MEMBUFFLEN; /* total */
-		
-        /* memory allocation */
-        sdrstat.buff=(uint8_t*)malloc(sdrstat.buffsize);
-        if (NULL==sdrstat.buff)
-		{
-            SDRPRINTF("error: failed to allocate memory for the buffer\n");
-			return -1;
-        }
-		SDRPRINTF("Data is taken from file, reading is not real-time\n");
-        break;
+    return allocbuff(ini,BLADERF_DATABUFF_SIZE,2*BLADERF_DATABUFF_SIZE);
+}
+static int startbladerf(sdrini_t *ini)
+{
+    if (bladerf_start()<0) {
+        SDRPRINTF("error: bladeRF...\n");
+        return -1;
+    }
+    return 0;
+}
+static void stopbladerf(sdrini_t *ini)
+{
+    bladerf_quit();
+}
+/* bladeRF binary file -------------------------------------------------------*/
+static int initfbladerf(sdrini_t *ini)
+{
+    if (openfend(ini)<0||allocbuff(ini,BLADERF_DATABUFF_SIZE,
+        2*BLADERF_DATABUFF_SIZE)<0) return -1;
+
+	SDRPRINTF("Data is taken from file, reading is not real-time\n");
+    return 0;
+}
+static int startfbladerf(sdrini_t *ini)
+{
+    fbladerf_pushtomembuf(); /* copy to membuffer */
+    rcvflowctrl(ini); /* wait for sdr channels */
+    return 0;
+}
 #endif
-#ifdef GN3S
-	case FEND_SIMPLE8B:
-		if (simple_rf_init() < 0) 
-			return -1;
-
-		if (ini->fend == FEND_SIMPLE8B)
-		{
-			sdrstat.fendbuffsize = SIMPLE_RF_BUFFSIZE; /* frontend buff size */
-			simple_rf_set_rx_buf(sdrstat.fendbuffsize);
-			sdrstat.buffsize = sdrstat.fendbuffsize * MEMBUFFLEN; /* total */
-		}
-
-		/* memory allocation */
-		sdrstat.buff = (uint8_t*)malloc(sdrstat.buffsize);
-		if (NULL == sdrstat.buff) {
-			SDRPRINTF("error: failed to allocate memory for the buffer\n");
-			return -1;
-		}
-		break;
+#ifdef RTLSDR
+/* RTL-SDR -------------------------------------------------------------------*/
+static int initrtlsdr(sdrini_t *ini)
+{
+    if (rtlsdr_init()<0) return -1; /* rtlsdr initialization */
+
+    if (allocbuff(ini,RTLSDR_DATABUFF_SIZE,2*RTLSDR_DATABUFF_SIZE)<0) {
+        return -1;
+    }
+    rtlsdr_set_rx_buf(sdrstat.fendbuffsize);
+    return 0;
+}
+static int startrtlsdr(sdrini_t *ini)
+{
+    if (rtlsdr_start()<0) {
+        SDRPRINTF("error: rtlsdr...\n");
+        return -1;
+    }
+    return 0;
+}
+static void stoprtlsdr(sdrini_t *ini)
+{
+    rtlsdr_quit();
+}
+/* RTL-SDR binary file -------------------------------------------------------*/
+static int initfrtlsdr(sdrini_t *ini)
+{
+    int size=RTLSDR_DATABUFF_SIZE*RTLSDR_FILE_READ_RATIO;
+
+    if (openfend(ini)<0||allocbuff(ini,size,2*size)<0) return -1;
+    rtlsdr_set_rx_buf(sdrstat.fendbuffsize);
+
+	SDRPRINTF("Data is taken from file, reading is not real-time\n");
+    return 0;
+}
+static int startfrtlsdr(sdrini_t *ini)
+{
+    frtlsdr_pushtomembuf(); /* copy to membuffer */
+    rcvflowctrl(ini); /* wait for sdr channels */
+    return 0;
+}
 #endif
-    /* File */
-    case FEND_FILE:
-        /* IF file open (FILE1) */
-        if ((ini->fp1 = fopen(ini->file1,"rb"))==NULL){
-            SDRPRINTF("error: failed to open file(FILE1): %s\n",ini->file1);
+/* IF file -------------------------------------------------------------------*/
+static int initfile(sdrini_t *ini)
+{
+    int packed;
+
+    /* IF file open (FILE1) */
+    if ((ini->fp1 = fopen(ini->file1,"rb"))==NULL){
+        SDRPRINTF("error: failed to open file(FILE1): %s\n",ini->file1);
+        return -1;
+    }
+    /* IF file open (FILE2) */
+    if (strlen(ini->file2)!=0) {
+        if ((ini->fp2 = fopen(ini->file2,"rb"))==NULL){
+            SDRPRINTF("error: failed to open file(FILE2): %s\n",ini->file2);
             return -1;
         }
-        /* IF file open (FILE2) */
-        if (strlen(ini->file2)!=0) {
-            if ((ini->fp2 = fopen(ini->file2,"rb"))==NULL){
-                SDRPRINTF("error: failed to open file(FILE2): %s\n",ini->file2);
-                return -1;
-            }
-        }
-        /* frontend buffer size */
-        sdrstat.fendbuffsize=FILE_BUFFSIZE; /* frontend buff size */
-        sdrstat.buffsize=FILE_BUFFSIZE*MEMBUFFLEN; /* total */
-
-        /* memory allocation */
-        if (ini->fp1!=NULL) {
-            sdrstat.buff=(uint8_t*)malloc(ini->dtype[0]*sdrstat.buffsize);
-            if (NULL==sdrstat.buff) {
-                SDRPRINTF("error: failed to allocate memory for the buffer\n");
-                return -1;
-            }
+    }
+    /* frontend buffer size */
+    ringblocks(ini,FILE_BUFFSIZE);
+    sdrstat.buffsize=FILE_BUFFSIZE*sdrstat.nblk; /* total */
+
+    /* packed IF files (unpacked to memory buffer) */
+    if ((ini->fp1!=NULL&&packopen(ini->fp1,&sdrstat.pack[0])<0)||
+        (ini->fp2!=NULL&&packopen(ini->fp2,&sdrstat.pack[1])<0)) {
+        return -1;
+    }
+    /* FILE2 stream (own ring and reader thread) */
+    if (strminit(ini)<0) return -1;
+
+    packed=sdrstat.pack[0].hdr.bits||sdrstat.pack[1].hdr.bits;
+    if (packed&&(ini->filemap||ini->filereader)) {
+        SDRPRINTF("warning: MMAP and READER are off for packed IF file\n");
+    }
+    /* memory-mapped IF file (no memory buffer) */
+    if (ini->filemap&&!packed) {
+        if (mapfile(ini->file1,ini->fileoff*ini->dtype[0],
+                &sdrstat.map[0])<0||
+            (ini->fp2!=NULL&&(sdrstat.strm->pos<0||mapfile(ini->file2,
+                sdrstat.strm->pos*ini->dtype[1],&sdrstat.map[1])<0))) {
+            SDRPRINTF("error: failed to map file, use buffered input\n");
+            unmapfile(&sdrstat.map[0]);
+            unmapfile(&sdrstat.map[1]);
         }
-        if (ini->fp2!=NULL) {
-            sdrstat.buff2=(uint8_t*)malloc(ini->dtype[1]*sdrstat.buffsize);
-            if (NULL==sdrstat.buff2) {
-                SDRPRINTF("error: failed to allocate memory for the buffer\n");
-                return -1;
-            }
+        else {
+            SDRPRINTF("Data is taken from memory-mapped file\n");
+            return 0;
         }
-		SDRPRINTF("Data is taken from file, reading is not real-time\n");
-        break;
-    default:
+    }
+    /* start offset of FILE2 (batch chunk and alignment of stream) */
+    if (sdrstat.strm!=NULL&&sdrstat.strm->pos>0&&(sdrstat.pack[1].hdr.bits?
+        packseek(&sdrstat.pack[1],sdrstat.strm->pos):
+        fileseek(ini->fp2,sdrstat.strm->pos*ini->dtype[1]))<0) {
+        SDRPRINTF("error: failed to seek file offset (FILE2): %.0f\n",
+            (double)sdrstat.strm->pos);
+        return -1;
+    }
+    if (strmstart(ini)<0) return -1;
+
+    /* asynchronous reader thread (reads ahead into memory buffer) */
+    if (ini->filereader&&!packed) {
+        return readerinit(ini);
+    }
+    /* memory allocation */
+    sdrstat.buff=(uint8_t*)sdrmemalloc(
+        (size_t)ini->dtype[0]*sdrstat.buffsize,ini->hugepage);
+    if (NULL==sdrstat.buff) {
+        SDRPRINTF("error: failed to allocate memory for the buffer\n");
+        return -1;
+    }
+    /* start offset of IF file (batch chunk) */
+    if (ini->fileoff>0&&(sdrstat.pack[0].hdr.bits?
+        packseek(&sdrstat.pack[0],ini->fileoff):
+        fileseek(ini->fp1,ini->fileoff*ini->dtype[0]))<0) {
+        SDRPRINTF("error: failed to seek file offset: %.0f\n",
+            (double)ini->fileoff);
         return -1;
     }
+	SDRPRINTF("Data is taken from file, reading is not real-time\n");
     return 0;
 }
-/* stop front-end --------------------------------------------------------------
-* stop grabber of front end
-* args   : sdrini_t *ini    I   sdr initialization struct
-* return : int                  status 0:okay -1:failure
-*-----------------------------------------------------------------------------*/
-extern int rcvquit(sdrini_t *ini)
+static int startfile(sdrini_t *ini)
+{
+    file_pushtomembuf(); /* copy to membuffer */
+    strmpush(); /* FILE2 stream (offline mode) */
+    rcvflowctrl(ini); /* wait for sdr channels */
+    return 0;
+}
+static void stopfile(sdrini_t *ini)
 {
-    switch (ini->fend) {
+    strmquit(); /* reader thread of FILE2 stream */
+    if (ini->fp1!=NULL) fclose(ini->fp1);
+    if (ini->fp2!=NULL) fclose(ini->fp2);
+    ini->fp1=ini->fp2=NULL;
+    unmapfile(&sdrstat.map[0]);
+    unmapfile(&sdrstat.map[1]);
+    packclose(&sdrstat.pack[0]);
+    packclose(&sdrstat.pack[1]);
+    teequit();
+    readerquit();
+}
+/* span of IF file: memory-mapped file data are lent directly ----------------*/
+static const char *spanfile(sdrini_t *ini, uint64_t buffloc, int n, int ftype,
+                            int dtype, char *expbuf)
+{
+    const sdrmap_t *map=&sdrstat.map[ftype==FTYPE2?1:0];
+    const uint8_t *buff=ftype==FTYPE1?sdrstat.buff:sdrstat.buff2;
+    uint64_t size=(uint64_t)dtype*rcvringlen(ftype),loc;
+
+    if (map->p!=NULL) {
+        return mapspan(map,dtype*buffloc,dtype*n,expbuf);
+    }
+    loc=dtype*buffloc%size;
+    if (buff!=NULL&&loc+dtype*n<=size) {
+        return (const char *)buff+loc;
+    }
+    membuff_getbuff(buffloc,n,ftype,dtype,expbuf);
+    return expbuf;
+}
+static void fmtfile(sdrini_t *ini, sdrfmt_t *fmt)
+{
+    const sdrstrm_t *st=sdrstat.strm;
+
+    fmtbuff(ini,fmt);
+    if (sdrstat.map[0].p!=NULL) fmt->nblk[0]=0; /* whole file is mapped */
+    if (st==NULL) return;
+    fmt->nbuf=2;
+    fmt->dtype[1]=st->dtype;
+    fmt->blklen[1]=st->blklen;
+    fmt->nblk[1]=st->nblk;
+}
+/* network IF stream ---------------------------------------------------------*/
+static int initnet(sdrini_t *ini)
+{
+    /* frames are received to memory buffer */
+    if (allocbuff(ini,NET_BUFFSIZE,ini->dtype[0]*NET_BUFFSIZE)<0) return -1;
+    return netinit(ini);
+}
+static int startnet(sdrini_t *ini)
+{
+    if (net_pushtomembuf()<0) {
+        SDRPRINTF("error: network stream...\n");
+        return -1;
+    }
+    return 0;
+}
+static void stopnet(sdrini_t *ini)
+{
+    netquit();
+}
+static void statsnet(sdrini_t *ini)
+{
+    netstats();
+}
+/* built-in front end drivers ------------------------------------------------*/
+static const sdrfend_t fendtbl[]={
 #ifdef GN3S
-    /* SiGe GN3S v2/v3 */
-    case FEND_GN3SV2:
-    case FEND_GN3SV3:
-        gn3s_quit();
-        break;
+    {"GN3SV2"     ,FEND_GN3SV2  ,0,initgn3s    ,startgn3s    ,stopgn3s   ,
+     spanbuff,fmtbuff,NULL},
+    {"GN3SV3"     ,FEND_GN3SV3  ,0,initgn3s    ,startgn3s    ,stopgn3s   ,
+     spanbuff,fmtbuff,NULL},
+    {"FILEGN3SV2" ,FEND_FGN3SV2 ,1,initfgn3s   ,startfgn3s   ,closefend  ,
+     spanbuff,fmtbuff,NULL},
+    {"FILEGN3SV3" ,FEND_FGN3SV3 ,1,initfgn3s   ,startfgn3s   ,closefend  ,
+     spanbuff,fmtbuff,NULL},
+    {"SIMPLE8B"   ,FEND_SIMPLE8B,0,initsimple  ,startsimple  ,stopsimple ,
+     spanbuff,fmtbuff,NULL},
 #endif
 #ifdef BLADERF
-    /* Nuand bladeRF */
-    case FEND_BLADERF:
-        bladerf_quit();
-        break;
+    {"BLADERF"    ,FEND_BLADERF ,0,initbladerf ,startbladerf ,stopbladerf,
+     spanbuff,fmtbuff,NULL},
+    {"FILEBLADERF",FEND_FBLADERF,1,initfbladerf,startfbladerf,closefend  ,
+     spanbuff,fmtbuff,NULL},
 #endif
 #ifdef RTLSDR
-    /* RTL-SDR */
-    case FEND_RTLSDR:
-        rtlsdr_quit();
-        break;
+    {"RTLSDR"     ,FEND_RTLSDR  ,0,initrtlsdr  ,startrtlsdr  ,stoprtlsdr ,
+     spanbuff,fmtbuff,NULL},
+    {"FILERTLSDR" ,FEND_FRTLSDR ,1,initfrtlsdr ,startfrtlsdr ,closefend  ,
+     spanbuff,fmtbuff,NULL},
 #endif
-#ifdef GN3S
-	case FEND_SIMPLE8B:
-		simple_rf_quit();
-		break;
+    {"FILE"       ,FEND_FILE    ,1,initfile    ,startfile    ,stopfile   ,
+     spanfile,fmtfile,NULL},
+    {"NET"        ,FEND_NET     ,0,initnet     ,startnet     ,stopnet    ,
+     spanbuff,fmtbuff,statsnet}
+};
+static const sdrfend_t *fendreg[MAXFENDREG]; /* registered front ends */
+static int nfendreg=0;
+
+/* register front end driver ---------------------------------------------------
+* register front end driver in addition to built-in drivers. registered driver
+* precedes built-in driver of same type name or type (e.g. test stand-in)
+* args   : sdrfend_t *fend  I   front end driver (static storage)
+* return : int                  status 0:okay -1:failure
+* note : call before the receivers are started
+*-----------------------------------------------------------------------------*/
+extern int rcvregister(const sdrfend_t *fend)
+{
+    if (nfendreg>=MAXFENDREG||!fend->init||!fend->start||!fend->span) {
+        return -1;
+    }
+    fendreg[nfendreg++]=fend;
+    return 0;
+}
+/* search front end driver -----------------------------------------------------
+* search front end driver by type name or type
+* args   : char   *name     I   type name (TYPE in ini file, NULL: by type)
+*          int    type      I   front end type (FEND_???)
+* return : sdrfend_t*           front end driver (NULL: not found)
+*-----------------------------------------------------------------------------*/
+extern const sdrfend_t *rcvfend(const char *name, int type)
+{
+    int i,n=(int)(sizeof(fendtbl)/sizeof(sdrfend_t));
+
+    for (i=nfendreg-1;i>=0;i--) {
+        if (name?!strcmp(fendreg[i]->name,name):fendreg[i]->type==type) {
+            return fendreg[i];
+        }
+    }
+    for (i=0;i<n;i++) {
+        if (name?!strcmp(fendtbl[i].name,name):fendtbl[i].type==type) {
+            return fendtbl+i;
+        }
+    }
+    return NULL;
+}
+/* sdr receiver initialization -------------------------------------------------
+* receiver initialization, memory allocation, file open
+* args   : sdrini_t *ini    I   sdr initialization struct
+* return : int                  status 0:okay -1:failure
+*-----------------------------------------------------------------------------*/
+extern int rcvinit(sdrini_t *ini)
+{
+#ifdef WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(1,0),&wsaData);
 #endif
-    /* Front End Binary File */
-    case FEND_FGN3SV2:
-    case FEND_FGN3SV3:
-    case FEND_FBLADERF:
-    case FEND_FRTLSDR:
-        if (ini->fp1!=NULL) fclose(ini->fp1); ini->fp1=NULL;
-        break;
-    /* File */
-    case FEND_FILE:
-        if (ini->fp1!=NULL) fclose(ini->fp1); ini->fp1=NULL;
-        if (ini->fp2!=NULL) fclose(ini->fp2); ini->fp2=NULL;
-        break;
-    default:
+
+    /* FFT initialization */
+    fftwf_init_threads();
+
+    sdrstat.buff=sdrstat.buff2=NULL;
+
+    /* front end driver */
+    if (!(sdrstat.fend=rcvfend(NULL,ini->fend))) {
+        SDRPRINTF("error: front end is not supported: %d\n",ini->fend);
         return -1;
     }
+    if (sdrstat.fend->init(ini)<0) return -1;
+
+    /* tee recording and triggered capture */
+    return teeinit(ini);
+}
+/* stop front-end --------------------------------------------------------------
+* stop grabber of front end
+* args   : sdrini_t *ini    I   sdr initialization struct
+* return : int                  status 0:okay -1:failure
+*-----------------------------------------------------------------------------*/
+extern int rcvquit(sdrini_t *ini)
+{
+    const sdrfend_t *fend=sdrstat.fend;
+
+    if (fend==NULL) return -1;
+
+    if (fend->stats) fend->stats(ini);
+    if (fend->stop) fend->stop(ini);
+
+    /* tee recording (uses memory buffer) */
+    teequit();
+
     /* free memory */
-    if (NULL!=sdrstat.buff)    free(sdrstat.buff);    sdrstat.buff=NULL;
-    if (NULL!=sdrstat.buff2)   free(sdrstat.buff2);   sdrstat.buff2=NULL;
+    sdrmemfree(sdrstat.buff);  sdrstat.buff=NULL;
+    sdrmemfree(sdrstat.buff2); sdrstat.buff2=NULL;
+    sdrstat.fend=NULL;
     return 0;
 }
 
@@ -280,73 +663,22 @@ extern int rcvquit(sdrini_t *ini)
 *-----------------------------------------------------------------------------*/
 extern int rcvgrabdata(sdrini_t *ini)
 {
-    unsigned long buffcnt=0;
-
-    switch (ini->fend) 
-	{
-#ifdef GN3S
-    /* SiGe GN3S v2/v3 */
-    case FEND_GN3SV2:
-    case FEND_GN3SV3:
-        if (gn3s_pushtomembuf()<0) {
-            SDRPRINTF("error: GN3S Buffer overrun...\n");
-            return -1;
-        }
-        break;
-    /* GN3S Binary File */
-    case FEND_FGN3SV2:
-    case FEND_FGN3SV3: 
-        fgn3s_pushtomembuf(); /* copy to membuffer */
-        sleepms(5);
-        break;
-#endif
-#ifdef GN3S
-	case FEND_SIMPLE8B:
-		if (simple_rf_pushtomembuf() < 0) {
-			SDRPRINTF("error: Simple Frontend Buffer overrun...\n");
-			return -1;
-		}
-		break;
-#endif
-#ifdef BLADERF
-    /* Nuand BladeRF */
-    case FEND_BLADERF:
-        if (bladerf_start()<0) {
-            SDRPRINTF("error: bladeRF...\n");
-            return -1;
-        }
-        break;
-    /* BladeRF Binary File */
-    case FEND_FBLADERF: 
-        fbladerf_pushtomembuf(); /* copy to membuffer */
-        sleepms(5);
-        break;
-#endif
-#ifdef RTLSDR
-    /* RTL-SDR */
-    case FEND_RTLSDR:
-        if (rtlsdr_start()<0) {
-            SDRPRINTF("error: rtlsdr...\n");
-            return -1;
-        }
-        break;
-    /* RTL-SDR Binary File */
-    case FEND_FRTLSDR: 
-        frtlsdr_pushtomembuf(); /* copy to membuffer */
-        sleepms(5);
-        break;/* File */
-#endif
-    case FEND_FILE:
-        file_pushtomembuf(); /* copy to membuffer */
-        sleepms(5);
-        break;
-    default:
-        return -1;
-    }
-    return 0;
+    return sdrstat.fend->start(ini);
+}
+/* data format of front end ----------------------------------------------------
+* get layout of memory buffer (or mapped file) of front end
+* args   : sdrini_t *ini    I   sdr initialization struct
+*          sdrfmt_t *fmt    O   data format
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void rcvformat(sdrini_t *ini, sdrfmt_t *fmt)
+{
+    if (sdrstat.fend->format) sdrstat.fend->format(ini,fmt);
+    else fmtbuff(ini,fmt);
 }
 /* grab current buffer ---------------------------------------------------------
-* get current data buffer from memory buffer
+* get current data buffer from memory buffer. front ends expand raw data to
+* int8 data (canonical format) once when the data are pushed to memory buffer
 * args   : sdrini_t *ini    I   sdr initialization struct
 *          uint64_t buffloc I   buffer location
 *          int    n         I   number of samples of data data to get
@@ -358,58 +690,209 @@ extern int rcvgrabdata(sdrini_t *ini)
 extern int rcvgetbuff(sdrini_t *ini, uint64_t buffloc, int n, int ftype,
                       int dtype, char *expbuf)
 {
-	if (n < 0)
-		return -1;
+    const char *p;
 
-    switch (ini->fend) 
-	{
-#ifdef GN3S
-    /* SiGe GN3S v2 */
-    case FEND_GN3SV2:
-        gn3s_getbuff_v2(buffloc,n,dtype,expbuf);
-        break;
-    /* SiGe GN3S v3 */
-    case FEND_GN3SV3:
-        gn3s_getbuff_v3(buffloc,n,dtype,expbuf);
-        break;
-    /* GN3Sv2/v3 Binary File */
-    case FEND_FGN3SV2: 
-    case FEND_FGN3SV3: 
-        fgn3s_getbuff(buffloc,n,dtype,expbuf);
-        break;
-	case FEND_SIMPLE8B:
-		simple_rf_getbuf(buffloc, n, dtype, expbuf);
-		break;
-#endif
-#ifdef BLADERF
-    /* Nuand BladeRF */
-    case FEND_BLADERF:
-        bladerf_getbuff(buffloc,n,expbuf);
-        break;    
-    /* BladeRF Binary File */
-    case FEND_FBLADERF: 
-        bladerf_getbuff(buffloc,n,expbuf);
-        break;
-#endif
-#ifdef RTLSDR
-    /* RTL-SDR */
-    case FEND_RTLSDR:
-        rtlsdr_getbuff(buffloc,n,expbuf);
-        break;    
-    /* RTL-SDR Binary File */
-    case FEND_FRTLSDR: 
-        rtlsdr_getbuff(buffloc,n,expbuf);
-        break;
-#endif
-    /* File */
-    case FEND_FILE:
-        file_getbuff(buffloc,n,ftype,dtype,expbuf);
-        break;
-    default:
-        return -1;
-    }
+    if (n<0||(sdrstat.buff==NULL&&sdrstat.map[0].p==NULL)) return -1;
+
+    /* all front ends store expanded int8 data in memory buffer */
+    p=sdrstat.fend->span(ini,buffloc,n,ftype,dtype,expbuf);
+    if (p!=expbuf) memcpy(expbuf,p,dtype*n);
     return 0;
 }
+/* grab current buffer without copy --------------------------------------------
+* get read-only span of current data lent by front end driver (memory buffer
+* or memory-mapped IF file). data wrapped around the end of memory buffer are
+* extracted to buffer
+* args   : sdrini_t *ini    I   sdr initialization struct
+*          uint64_t buffloc I   buffer location
+*          int    n         I   number of samples of data data to get
+*          int    ftype     I   front end type (FTYPE1 or FTYPE2)
+*          int    dtype     I   data type (DTYPEI or DTYPEIQ)
+*          char   *expbuff  O   extracted data buffer (n*dtype bytes)
+* return : char*                pointer to data (NULL: failure)
+*-----------------------------------------------------------------------------*/
+extern const char *rcvgetspan(sdrini_t *ini, uint64_t buffloc, int n,
+                              int ftype, int dtype, char *expbuf)
+{
+    if (n<0) return NULL;
+
+    return sdrstat.fend->span(ini,buffloc,n,ftype,dtype,expbuf);
+}
+/* head of memory buffer -------------------------------------------------------
+* get buffer location of the latest data in memory buffer
+* args   : none
+* return : uint64_t             buffer location of head (sample)
+*-----------------------------------------------------------------------------*/
+extern uint64_t rcvheadloc(void)
+{
+    uint64_t head;
+
+    mlock(hreadmtx);
+    head=(uint64_t)sdrstat.fendbuffsize*sdrstat.buffcnt;
+    unmlock(hreadmtx);
+    return head;
+}
+/* head of stream --------------------------------------------------------------
+* get buffer location of the latest data of front end stream
+* args   : int    ftype     I   front end type (FTYPE1 or FTYPE2)
+* return : uint64_t             buffer location of head (sample of stream)
+*-----------------------------------------------------------------------------*/
+extern uint64_t rcvstrmhead(int ftype)
+{
+    sdrstrm_t *st=ftype==FTYPE2?sdrstat.strm:NULL;
+    uint64_t head;
+
+    if (st==NULL) return rcvheadloc();
+
+    /* memory-mapped FILE2 follows FTYPE1 */
+    if (st->buff==NULL) {
+        return (uint64_t)rcvstrmloc(ftype,(double)rcvheadloc());
+    }
+    mlock(st->mtx);
+    head=st->cnt*st->blklen;
+    unmlock(st->mtx);
+    return head;
+}
+/* length of memory buffer -----------------------------------------------------
+* args   : int    ftype     I   front end type (FTYPE1 or FTYPE2)
+* return : uint64_t             length of memory buffer (sample of stream)
+*-----------------------------------------------------------------------------*/
+extern uint64_t rcvringlen(int ftype)
+{
+    const sdrstrm_t *st=ftype==FTYPE2?sdrstat.strm:NULL;
+    uint64_t len=(uint64_t)sdrstat.nblk*sdrstat.fendbuffsize;
+
+    if (st==NULL) return len;
+    if (st->buff==NULL) return (uint64_t)(len*st->ratio);
+    return (uint64_t)st->nblk*st->blklen;
+}
+/* common time index -----------------------------------------------------------
+* convert buffer location of stream to common time index. common time index is
+* buffer location of FTYPE1 (sample of FTYPE1)
+* args   : int    ftype     I   front end type (FTYPE1 or FTYPE2)
+*          double loc       I   buffer location (sample of stream)
+* return : double               common time index (sample of FTYPE1)
+*-----------------------------------------------------------------------------*/
+extern double rcvcomloc(int ftype, double loc)
+{
+    const sdrstrm_t *st=ftype==FTYPE2?sdrstat.strm:NULL;
+
+    return st==NULL?loc:(loc-st->frac)/st->ratio;
+}
+/* buffer location of stream ---------------------------------------------------
+* convert common time index to buffer location of stream
+* args   : int    ftype     I   front end type (FTYPE1 or FTYPE2)
+*          double com       I   common time index (sample of FTYPE1)
+* return : double               buffer location (sample of stream)
+*-----------------------------------------------------------------------------*/
+extern double rcvstrmloc(int ftype, double com)
+{
+    const sdrstrm_t *st=ftype==FTYPE2?sdrstat.strm:NULL;
+
+    return st==NULL?com:com*st->ratio+st->frac;
+}
+/* slowest channel buffer location ---------------------------------------------
+* get buffer location of the slowest tracking/acquiring sdr channel
+* args   : uint64_t *buffloc O  buffer location of slowest channel
+*                               (common time index)
+* return : int                  number of active channels
+*-----------------------------------------------------------------------------*/
+static int slowestbuffloc(uint64_t *buffloc)
+{
+    uint64_t loc;
+    int i,n=0,nch=sdrini.nch+(sdrini.nchL6?1:0);
+
+    for (i=0;i<nch&&i<MAXSAT;i++) {
+        if (!sdrch[i].flagacq&&!sdrch[i].acq.flagrun) continue;
+        loc=sdrch[i].trk.buffloc;
+        if (sdrch[i].ftype==FTYPE2) {
+            loc=(uint64_t)rcvcomloc(FTYPE2,(double)loc);
+        }
+        if (n==0||loc<*buffloc) *buffloc=loc;
+        n++;
+    }
+    return n;
+}
+/* replay window ---------------------------------------------------------------
+* max distance between file reader and slowest channel
+* args   : sdrini_t *ini    I   sdr initialization struct
+* return : uint64_t             replay window (sample)
+*-----------------------------------------------------------------------------*/
+static uint64_t replaywindow(sdrini_t *ini)
+{
+    uint64_t win,ring=(uint64_t)sdrstat.nblk*sdrstat.fendbuffsize;
+    int ms=ini->replaywin>0?ini->replaywin:REPLAYWIN;
+
+    win=(uint64_t)(ms*ini->f_sf[0]/1000.0);
+
+    /* reader must stay behind the oldest data used by channels */
+    if (win>ring/2) win=ring/2;
+    if (win<(uint64_t)2*sdrstat.fendbuffsize) win=2*sdrstat.fendbuffsize;
+    return win;
+}
+/* file replay flow control ----------------------------------------------------
+* wait until slowest sdr channel is within replay window from the head of the
+* memory buffer. without active channel the reader runs flat out
+* args   : sdrini_t *ini    I   sdr initialization struct
+* return : none
+* note : if REPLAY is not set, wait a fixed interval (5ms). in offline mode,
+*        the offline scheduler pushes the data only when it is needed
+*-----------------------------------------------------------------------------*/
+extern void rcvflowctrl(sdrini_t *ini)
+{
+    uint64_t slow=0,win;
+
+    if (ini->offline) return;
+
+    if (!ini->replay) {
+        sleepms(5);
+        return;
+    }
+    win=replaywindow(ini);
+
+    while (!sdrstat.stopflag) {
+        if (!slowestbuffloc(&slow)||slow+win>=rcvheadloc()) break;
+        sleepms(1);
+    }
+}
+/* wait buffer -----------------------------------------------------------------
+* wait until the head of stream reaches the buffer location
+* args   : int    ftype     I   front end type (FTYPE1 or FTYPE2)
+*          uint64_t buffloc I   buffer location (sample of stream)
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void rcvwaitbuff(int ftype, uint64_t buffloc)
+{
+    while (!sdrstat.stopflag&&rcvstrmhead(ftype)<buffloc) {
+        sleepms(1);
+    }
+}
+/* end of IF file --------------------------------------------------------------
+* stop receiver at the end of IF file. in replay mode, wait until all sdr
+* channels consume the data in memory buffer
+* args   : none
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void rcveof(void)
+{
+    uint64_t head,slow=0,prev=0;
+    int stall=0;
+
+    SDRPRINTF("end of file!\n");
+
+    if (sdrini.replay&&!sdrini.offline) {
+        head=rcvheadloc();
+
+        /* channels stop when remained data is less than a code period */
+        while (!sdrstat.stopflag&&slowestbuffloc(&slow)&&stall<1000) {
+            if (slow+sdrstat.fendbuffsize>=head) break;
+            stall=slow==prev?stall+1:0;
+            prev=slow;
+            sleepms(1);
+        }
+    }
+    sdrstat.stopflag=ON;
+}
 /* push data to memory buffer --------------------------------------------------
 * post-processing function: push data to memory buffer
 * args   : none
@@ -417,33 +900,77 @@ extern int rcvgetbuff(sdrini_t *ini, uint64_t buffloc, int n, int ftype,
 *-----------------------------------------------------------------------------*/
 extern void file_pushtomembuf(void) 
 {
-    size_t nread1=0,nread2=0;
+    size_t nread1=0;
+    int len1=sdrini.dtype[0]*FILE_BUFFSIZE;
+    uint8_t *p;
 
+    if (sdrstat.map[0].p!=NULL) {
+        file_pushtomap();
+        return;
+    }
+    if (sdrstat.rd!=NULL) {
+        file_pushfromreader();
+        return;
+    }
     mlock(hbuffmtx);
     if(sdrini.fp1!=NULL) {
-        nread1=fread(&sdrstat.buff[(sdrstat.buffcnt%MEMBUFFLEN)*
-            sdrini.dtype[0]*FILE_BUFFSIZE],1,sdrini.dtype[0]*FILE_BUFFSIZE,
-            sdrini.fp1);
-    }
-    if(sdrini.fp2!=NULL) {
-        nread2=fread(&sdrstat.buff2[(sdrstat.buffcnt%MEMBUFFLEN)*
-            sdrini.dtype[1]*FILE_BUFFSIZE],1,sdrini.dtype[1]*FILE_BUFFSIZE,
-            sdrini.fp2);
+        p=&sdrstat.buff[(sdrstat.buffcnt&sdrstat.nblkmask)*len1];
+        nread1=sdrstat.pack[0].hdr.bits?packread(&sdrstat.pack[0],(char *)p,
+            len1):fread(p,1,len1,sdrini.fp1);
     }
     unmlock(hbuffmtx);
 
-    if ((sdrini.fp1!=NULL&&(int)nread1<sdrini.dtype[0]*FILE_BUFFSIZE)||
-        (sdrini.fp2!=NULL&&(int)nread2<sdrini.dtype[1]*FILE_BUFFSIZE)) {
-        sdrstat.stopflag=ON;
-        SDRPRINTF("end of file!\n");
+    /* FILE2 is pushed by stream (sdrstrm.c) */
+    if ((sdrini.fp1!=NULL&&(int)nread1<len1)||
+        (sdrini.filelen>0&&
+        (sdrstat.buffcnt+1)*FILE_BUFFSIZE>=sdrini.filelen)) {
+        rcveof();
     }
 
     mlock(hreadmtx);
     sdrstat.buffcnt++;
     unmlock(hreadmtx);
 }
-/* get current data buffer from IF file ----------------------------------------
-* post-processing function: get current data buffer from memory buffer
+/* advance memory-mapped IF file -----------------------------------------------
+* post-processing function: advance head of memory-mapped IF file without
+* copy. readahead follows the distance between head and the slowest channel
+* args   : none
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void file_pushtomap(void)
+{
+    uint64_t end,head,slow,lag,keep,amin=(uint64_t)MAPAHEAD*FILE_BUFFSIZE;
+    uint64_t ahead,rel;
+    int i;
+
+    end=(sdrstat.buffcnt+1)*FILE_BUFFSIZE;
+
+    /* data beyond end of FILE2 are padded by zero */
+    if ((uint64_t)sdrini.dtype[0]*end>sdrstat.map[0].size||
+        (sdrini.filelen>0&&end>=sdrini.filelen)) {
+        rcveof();
+    }
+    mlock(hreadmtx);
+    sdrstat.buffcnt++;
+    head=sdrstat.buffcnt*FILE_BUFFSIZE;
+    unmlock(hreadmtx);
+
+    /* readahead and release window */
+    slow=head;
+    if (!slowestbuffloc(&slow)||slow>head) slow=head;
+    lag=head-slow;
+    if (lag<amin) lag=amin;
+    keep=(uint64_t)(MAPKEEP*sdrini.f_sf[0]/1000.0);
+
+    for (i=0;i<2;i++) {
+        if (sdrstat.map[i].p==NULL) continue;
+        ahead=(uint64_t)rcvstrmloc(i+1,(double)(head+lag));
+        rel=slow>keep?(uint64_t)rcvstrmloc(i+1,(double)(slow-keep)):0;
+        mapadvise(&sdrstat.map[i],sdrini.dtype[i]*ahead,sdrini.dtype[i]*rel);
+    }
+}
+/* get current data buffer from memory buffer ----------------------------------
+* get current data buffer (int8) from memory buffer or memory-mapped IF file
 * args   : uint64_t buffloc I   buffer location
 *          int    n         I   number of grab data 
 *          int    ftype     I   front end type (FTYPE1 or FTYPE2)
@@ -451,16 +978,27 @@ extern void file_pushtomembuf(void)
 *          char   *expbuff  O   extracted data buffer
 * return : none
 *-----------------------------------------------------------------------------*/
-extern void file_getbuff(uint64_t buffloc, int n, int ftype, int dtype, 
-                         char *expbuf)
+extern void membuff_getbuff(uint64_t buffloc, int n, int ftype, int dtype,
+                            char *expbuf)
 {
-    uint64_t membuffloc=dtype*buffloc%(MEMBUFFLEN*dtype*FILE_BUFFSIZE);
+    uint64_t size=(uint64_t)dtype*rcvringlen(ftype);
+    uint64_t membuffloc=dtype*buffloc%size;
+    const sdrmap_t *map=&sdrstat.map[ftype==FTYPE2?1:0];
+    sdrstrm_t *st=ftype==FTYPE2?sdrstat.strm:NULL;
+    const char *p;
     int nout;
 
+    /* memory-mapped IF file */
+    if (map->p!=NULL) {
+        p=mapspan(map,dtype*buffloc,dtype*n,expbuf);
+        if (p!=expbuf) memcpy(expbuf,p,dtype*n);
+        return;
+    }
     n=dtype*n;
-    nout=(int)((membuffloc+n)-(MEMBUFFLEN*dtype*FILE_BUFFSIZE));
+    nout=(int)((membuffloc+n)-size);
 
-    mlock(hbuffmtx);
+    /* stream of FILE2 has own mutex */
+    if (st!=NULL) mlock(st->mtx); else mlock(hbuffmtx);
     if (ftype==FTYPE1) {
         if (nout>0) {
             memcpy(expbuf,&sdrstat.buff[membuffloc],n-nout);
@@ -477,5 +1015,5 @@ extern void file_getbuff(uint64_t buffloc, int n, int ftype, int dtype,
             memcpy(expbuf,&sdrstat.buff2[membuffloc],n);
         }
     }
-    unmlock(hbuffmtx);
+    if (st!=NULL) unmlock(st->mtx); else unmlock(hbuffmtx);
 }
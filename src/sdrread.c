@@ -0,0 +1,347 @@
+/*------------------------------------------------------------------------------
+* sdrread.c : SDR asynchronous IF file reader functions
+*
+* Copyright (C) 2014 Taro Suzuki <gnsssdrlib@gmail.com>
+*-----------------------------------------------------------------------------*/
+#ifndef WIN32
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+#include "sdr.h"
+
+/* open IF file ----------------------------------------------------------------
+* open IF file for positional read
+* args   : sdrreader_t *rd  I/O reader struct
+*          int    i         I   file index (0:FILE1 1:FILE2)
+*          char   *file     I   file path
+* return : int                  status 0:okay -1:failure
+* note : if direct i/o is not supported by file system, the file is opened
+*        without direct i/o
+*-----------------------------------------------------------------------------*/
+static int openfile(sdrreader_t *rd, int i, const char *file)
+{
+#ifdef WIN32
+    DWORD flag=rd->direct?FILE_FLAG_NO_BUFFERING:FILE_FLAG_SEQUENTIAL_SCAN;
+
+    rd->hfile[i]=CreateFileA(file,GENERIC_READ,FILE_SHARE_READ,NULL,
+        OPEN_EXISTING,flag,NULL);
+    if (rd->hfile[i]==INVALID_HANDLE_VALUE&&rd->direct) {
+        SDRPRINTF("warning: direct i/o not supported: %s\n",file);
+        rd->hfile[i]=CreateFileA(file,GENERIC_READ,FILE_SHARE_READ,NULL,
+            OPEN_EXISTING,FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+    }
+    return rd->hfile[i]==INVALID_HANDLE_VALUE?-1:0;
+#else
+    rd->fd[i]=-1;
+#ifdef O_DIRECT
+    if (rd->direct&&(rd->fd[i]=open(file,O_RDONLY|O_DIRECT))<0) {
+        SDRPRINTF("warning: direct i/o not supported: %s\n",file);
+    }
+#endif
+    if (rd->fd[i]<0&&(rd->fd[i]=open(file,O_RDONLY))<0) return -1;
+#if !defined(O_DIRECT)&&defined(F_NOCACHE)
+    if (rd->direct) fcntl(rd->fd[i],F_NOCACHE,1);
+#endif
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(rd->fd[i],0,0,POSIX_FADV_SEQUENTIAL);
+#endif
+    return 0;
+#endif
+}
+/* close IF file ---------------------------------------------------------------
+* args   : sdrreader_t *rd  I/O reader struct
+*          int    i         I   file index (0:FILE1 1:FILE2)
+* return : none
+*-----------------------------------------------------------------------------*/
+static void closefile(sdrreader_t *rd, int i)
+{
+#ifdef WIN32
+    if (rd->hfile[i]!=INVALID_HANDLE_VALUE) CloseHandle(rd->hfile[i]);
+    rd->hfile[i]=INVALID_HANDLE_VALUE;
+#else
+    if (rd->fd[i]>=0) close(rd->fd[i]);
+    rd->fd[i]=-1;
+#endif
+}
+/* read IF file at offset ------------------------------------------------------
+* read data from IF file at offset without changing file position
+* args   : sdrreader_t *rd  I   reader struct
+*          int    i         I   file index (0:FILE1 1:FILE2)
+*          uint64_t off     I   offset from start of file (bytes)
+*          uint8_t *buf     O   data buffer
+*          int    len       I   length of data (bytes)
+* return : int                  length of read data (bytes)
+*-----------------------------------------------------------------------------*/
+static int readat(sdrreader_t *rd, int i, uint64_t off, uint8_t *buf, int len)
+{
+    int n=0;
+#ifdef WIN32
+    OVERLAPPED ov;
+    DWORD nr;
+
+    while (n<len) {
+        memset(&ov,0,sizeof(ov));
+        ov.Offset    =(DWORD)((off+n)&0xFFFFFFFF);
+        ov.OffsetHigh=(DWORD)((off+n)>>32);
+        if (!ReadFile(rd->hfile[i],buf+n,len-n,&nr,&ov)||nr==0) break;
+        n+=(int)nr;
+    }
+#else
+    ssize_t nr;
+
+    while (n<len) {
+        if ((nr=pread(rd->fd[i],buf+n,len-n,(off_t)(off+n)))<0) {
+            if (errno==EINTR) continue;
+            break;
+        }
+        if (nr==0) break;
+        n+=(int)nr;
+    }
+#endif
+    return n;
+}
+/* opened IF file --------------------------------------------------------------
+* args   : sdrreader_t *rd  I   reader struct
+*          int    i         I   file index (0:FILE1 1:FILE2)
+* return : int                  1:opened 0:not opened
+*-----------------------------------------------------------------------------*/
+static int isopened(sdrreader_t *rd, int i)
+{
+#ifdef WIN32
+    return rd->hfile[i]!=INVALID_HANDLE_VALUE;
+#else
+    return rd->fd[i]>=0;
+#endif
+}
+/* read blocks -----------------------------------------------------------------
+* read contiguous blocks of IF files to memory buffer by one request
+* args   : sdrreader_t *rd  I   reader struct
+*          uint64_t cnt     I   first block number
+*          int    nblk      I   number of blocks (not wrapped in memory buffer)
+* return : int                  number of completely read blocks
+*-----------------------------------------------------------------------------*/
+static int readblks(sdrreader_t *rd, uint64_t cnt, int nblk)
+{
+    uint8_t *buf;
+    int i,n,nb=nblk;
+
+    for (i=0;i<2;i++) {
+        if (!isopened(rd,i)) continue;
+        buf=(i==0?sdrstat.buff:sdrstat.buff2)+
+            (cnt&sdrstat.nblkmask)*rd->blklen[i];
+        n=readat(rd,i,rd->off[i]+cnt*rd->blklen[i],buf,nblk*rd->blklen[i]);
+        if (n/rd->blklen[i]<nb) nb=n/rd->blklen[i];
+    }
+    return nb;
+}
+/* wait free blocks ------------------------------------------------------------
+* wait until memory buffer has free blocks for reader
+* args   : sdrreader_t *rd  I/O reader struct
+*          uint64_t cnt     I   next block number to read
+* return : int                  number of free blocks (0: quit)
+*-----------------------------------------------------------------------------*/
+static int waitfree(sdrreader_t *rd, uint64_t cnt)
+{
+    int n;
+#ifdef WIN32
+    while (cnt>=rd->cscnt+rd->depth&&!rd->quit) {
+        WaitForSingleObject(rd->freed,INFINITE);
+    }
+    n=rd->quit?0:(int)(rd->cscnt+rd->depth-cnt);
+#else
+    mlock(rd->mtx);
+    while (cnt>=rd->cscnt+rd->depth&&!rd->quit) waitevent(rd->freed,rd->mtx);
+    n=rd->quit?0:(int)(rd->cscnt+rd->depth-cnt);
+    unmlock(rd->mtx);
+#endif
+    return n;
+}
+/* publish read blocks ---------------------------------------------------------
+* args   : sdrreader_t *rd  I/O reader struct
+*          uint64_t cnt     I   number of read blocks
+*          int    eof       I   end of file reached at last block
+* return : none
+*-----------------------------------------------------------------------------*/
+static void publish(sdrreader_t *rd, uint64_t cnt, int eof)
+{
+    mlock(rd->mtx);
+    rd->rdcnt=cnt;
+    rd->eof=eof;
+    setevent(rd->filled);
+    unmlock(rd->mtx);
+}
+/* reader thread ---------------------------------------------------------------
+* read IF files ahead of the head of memory buffer. free contiguous blocks are
+* read by one request to keep the disk busy
+* args   : void   *arg      I   reader struct
+* return : none
+*-----------------------------------------------------------------------------*/
+#ifdef WIN32
+static void readthread(void *arg)
+#else
+static void *readthread(void *arg)
+#endif
+{
+    sdrreader_t *rd=(sdrreader_t *)arg;
+    uint64_t cnt=0,last=0;
+    int nblk,nb,eof=0;
+
+    sdrrtthread(RT_GRAB);
+
+    /* last block to process */
+    if (sdrini.filelen>0) {
+        last=(sdrini.filelen+FILE_BUFFSIZE-1)/FILE_BUFFSIZE-1;
+    }
+    while (!eof&&(nblk=waitfree(rd,cnt))>0) {
+
+        /* blocks are not wrapped around the end of memory buffer */
+        if (nblk>sdrstat.nblk-(int)(cnt&sdrstat.nblkmask)) {
+            nblk=sdrstat.nblk-(int)(cnt&sdrstat.nblkmask);
+        }
+        if (sdrini.filelen>0&&cnt+nblk>last) {
+            nblk=(int)(last-cnt)+1;
+            eof=1;
+        }
+        /* short block is the last block */
+        if ((nb=readblks(rd,cnt,nblk))<nblk) {
+            nblk=nb+1;
+            eof=1;
+        }
+        cnt+=nblk;
+        publish(rd,cnt,eof);
+    }
+    return THRETVAL;
+}
+/* initialize IF file reader ---------------------------------------------------
+* open IF files, allocate memory buffers and start reader thread
+* args   : sdrini_t *ini    I   sdr initialization struct
+* return : int                  status 0:okay -1:failure
+* note : direct i/o requires the start offset aligned to RDALIGN, otherwise
+*        buffered i/o is used
+*-----------------------------------------------------------------------------*/
+extern int readerinit(sdrini_t *ini)
+{
+    sdrreader_t *rd;
+    int i;
+
+    if (!(rd=(sdrreader_t *)calloc(1,sizeof(sdrreader_t)))) {
+        SDRPRINTF("error: readerinit memory allocation\n");
+        return -1;
+    }
+    sdrstat.rd=rd;
+    rd->depth=ini->readdepth>0?ini->readdepth:RDDEPTH;
+    if (rd->depth>sdrstat.nblk/4) {
+        SDRPRINTF("error: wrong file reader depth: %d (max %d)\n",rd->depth,
+            sdrstat.nblk/4);
+        return -1;
+    }
+    rd->direct=ini->directio;
+
+    for (i=0;i<2;i++) {
+#ifdef WIN32
+        rd->hfile[i]=INVALID_HANDLE_VALUE;
+#else
+        rd->fd[i]=-1;
+#endif
+        rd->blklen[i]=ini->dtype[i]*FILE_BUFFSIZE;
+        rd->off[i]=ini->fileoff*ini->dtype[i];
+    }
+    if (rd->off[0]%RDALIGN&&rd->direct) {
+        SDRPRINTF("warning: file offset not aligned, direct i/o off\n");
+        rd->direct=0;
+    }
+    /* FILE2 is read by stream (sdrstrm.c) */
+    if (openfile(rd,0,ini->file1)<0) {
+        SDRPRINTF("error: failed to open file(FILE1)\n");
+        return -1;
+    }
+    /* memory buffer (aligned by MEMHDR for direct i/o) */
+    if (!(sdrstat.buff=(uint8_t *)sdrmemalloc((size_t)rd->blklen[0]*
+        sdrstat.nblk,ini->hugepage))) {
+        SDRPRINTF("error: failed to allocate memory for the buffer\n");
+        return -1;
+    }
+    initmlock(rd->mtx);
+    initevent(rd->filled);
+    initevent(rd->freed);
+
+    cratethread(rd->hread,readthread,rd);
+    rd->run=1;
+
+    SDRPRINTF("Data is taken from file by reader thread (%d blocks%s)\n",
+        rd->depth,rd->direct?", direct i/o":"");
+    return 0;
+}
+/* stop IF file reader ---------------------------------------------------------
+* stop reader thread and close IF files
+* args   : none
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void readerquit(void)
+{
+    sdrreader_t *rd=sdrstat.rd;
+    int i;
+
+    if (rd==NULL) return;
+
+    if (rd->run) {
+        mlock(rd->mtx);
+        rd->quit=1;
+        setevent(rd->freed);
+        unmlock(rd->mtx);
+        waitthread(rd->hread);
+
+        delmlock(rd->mtx);
+        delevent(rd->filled);
+        delevent(rd->freed);
+    }
+    for (i=0;i<2;i++) closefile(rd,i);
+    sdrstat.rd=NULL;
+    free(rd);
+}
+/* push data to memory buffer from reader --------------------------------------
+* post-processing function: wait the next block read by reader thread and
+* advance the head of memory buffer
+* args   : none
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void file_pushfromreader(void)
+{
+    sdrreader_t *rd=sdrstat.rd;
+    int ready,eof;
+
+    /* wait next block */
+#ifdef WIN32
+    while (rd->rdcnt<=sdrstat.buffcnt&&!rd->eof) {
+        WaitForSingleObject(rd->filled,INFINITE);
+    }
+    mlock(rd->mtx);
+#else
+    mlock(rd->mtx);
+    while (rd->rdcnt<=sdrstat.buffcnt&&!rd->eof) {
+        waitevent(rd->filled,rd->mtx);
+    }
+#endif
+    ready=rd->rdcnt>sdrstat.buffcnt;
+    eof=rd->eof&&rd->rdcnt==sdrstat.buffcnt+1;
+    unmlock(rd->mtx);
+
+    if (!ready) { /* all blocks consumed */
+        sdrstat.stopflag=ON;
+        return;
+    }
+    if (eof) rcveof();
+
+    mlock(hreadmtx);
+    sdrstat.buffcnt++;
+    unmlock(hreadmtx);
+
+    /* release consumed block to reader */
+    mlock(rd->mtx);
+    rd->cscnt=sdrstat.buffcnt;
+    setevent(rd->freed);
+    unmlock(rd->mtx);
+}
@@ -0,0 +1,303 @@
+/*------------------------------------------------------------------------------
+* sdrrt.c : SDR real-time scheduling functions
+*
+* Copyright (C) 2014 Taro Suzuki <gnsssdrlib@gmail.com>
+*-----------------------------------------------------------------------------*/
+#ifndef WIN32
+#define _GNU_SOURCE
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+#include "sdr.h"
+
+#define HUGE2MB ((size_t)1<<21)         /* 2MB huge page */
+#define HUGE1GB ((size_t)1<<30)         /* 1GB huge page */
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+/* parse cpu list --------------------------------------------------------------
+* convert cpu list string (e.g. "0,2,4-7") to cpu mask
+* args   : char   *str      I   cpu list string
+*          uint64_t *mask   O   cpu mask (bit n: cpu n)
+* return : int                  0:okay -1:error
+*-----------------------------------------------------------------------------*/
+extern int parsecpulist(const char *str, uint64_t *mask)
+{
+    const char *p=str;
+    char *q;
+    long s,e,i;
+
+    *mask=0;
+    while (*p) {
+        if (*p==' '||*p=='\t'||*p==',') { p++; continue; }
+        s=strtol(p,&q,10);
+        if (q==p) return -1;
+        e=s;
+        p=q;
+        if (*p=='-') {
+            e=strtol(p+1,&q,10);
+            if (q==p+1) return -1;
+            p=q;
+        }
+        if (s<0||e<s||e>=RT_MAXCPU) return -1;
+        for (i=s;i<=e;i++) *mask|=(uint64_t)1<<i;
+    }
+    return 0;
+}
+/* set cpu affinity of current thread ------------------------------------------
+* args   : uint64_t mask    I   cpu mask (0: no affinity is set)
+* return : int                  0:okay -1:error
+*-----------------------------------------------------------------------------*/
+extern int setthreadaffinity(uint64_t mask)
+{
+#ifdef WIN32
+    if (mask==0) return 0;
+    if (!SetThreadAffinityMask(GetCurrentThread(),(DWORD_PTR)mask)) {
+        return -1;
+    }
+    return 0;
+#else
+    cpu_set_t set;
+    int i;
+
+    if (mask==0) return 0;
+    CPU_ZERO(&set);
+    for (i=0;i<RT_MAXCPU;i++) {
+        if (mask&((uint64_t)1<<i)) CPU_SET(i,&set);
+    }
+    if (pthread_setaffinity_np(pthread_self(),sizeof(set),&set)) {
+        return -1;
+    }
+    return 0;
+#endif
+}
+/* get cpu affinity of current thread ------------------------------------------
+* args   : none
+* return : uint64_t              cpu mask (0: unknown)
+*-----------------------------------------------------------------------------*/
+extern uint64_t getthreadaffinity(void)
+{
+#ifdef WIN32
+    DWORD_PTR pmask,smask;
+    if (!GetProcessAffinityMask(GetCurrentProcess(),&pmask,&smask)) return 0;
+    return (uint64_t)pmask;
+#else
+    cpu_set_t set;
+    uint64_t mask=0;
+    int i;
+
+    if (pthread_getaffinity_np(pthread_self(),sizeof(set),&set)) return 0;
+    for (i=0;i<RT_MAXCPU;i++) {
+        if (CPU_ISSET(i,&set)) mask|=(uint64_t)1<<i;
+    }
+    return mask;
+#endif
+}
+/* set scheduling priority of current thread -----------------------------------
+* args   : int    policy    I   scheduling policy (RT_FIFO/RT_RR)
+*          int    prio      I   real-time priority (1-99, 0: normal)
+* return : int                  0:okay -1:error
+* note : real-time policy is not inherited by child processes (gnuplot).
+*        prio<=0 resets the thread to normal policy, so threads created by
+*        real-time threads do not inherit the real-time policy
+*-----------------------------------------------------------------------------*/
+extern int setthreadprio(int policy, int prio)
+{
+#ifdef WIN32
+    int p=THREAD_PRIORITY_NORMAL;
+    if (prio>0) {
+        p=prio>=50?THREAD_PRIORITY_TIME_CRITICAL:THREAD_PRIORITY_HIGHEST;
+    }
+    if (!SetThreadPriority(GetCurrentThread(),p)) return -1;
+    return 0;
+#else
+    struct sched_param prm={0};
+    int pol=policy==RT_RR?SCHED_RR:SCHED_FIFO;
+
+    if (prio<=0) { /* normal policy */
+        if (pthread_setschedparam(pthread_self(),SCHED_OTHER,&prm)) return -1;
+        return 0;
+    }
+#ifdef SCHED_RESET_ON_FORK
+    pol|=SCHED_RESET_ON_FORK;
+#endif
+    if (prio<sched_get_priority_min(SCHED_FIFO))
+        prio=sched_get_priority_min(SCHED_FIFO);
+    if (prio>sched_get_priority_max(SCHED_FIFO))
+        prio=sched_get_priority_max(SCHED_FIFO);
+    prm.sched_priority=prio;
+    if (pthread_setschedparam(pthread_self(),pol,&prm)) return -1;
+    return 0;
+#endif
+}
+/* cpu mask of thread type -----------------------------------------------------
+* get cpu mask of thread type by [RT] setting
+* args   : int    type      I   thread type (RT_GRAB/RT_CH/RT_SYNC/RT_OUT/
+*                               RT_PLOT)
+* return : uint64_t              cpu mask (0: no affinity)
+* note : if RT_PLOT cpus are not set, plotting threads run on cpus which are
+*        not used by grabber and channel threads
+*-----------------------------------------------------------------------------*/
+extern uint64_t rtcpumask(int type)
+{
+    uint64_t mask,used;
+
+    if (type<0||type>=RT_NTYPE) return 0;
+
+    mask=sdrini.rtcpu[type];
+    if (type==RT_PLOT&&mask==0) {
+        used=sdrini.rtcpu[RT_GRAB]|sdrini.rtcpu[RT_CH];
+        if (used!=0) mask=getthreadaffinity()&~used;
+    }
+    return mask;
+}
+/* set real-time attribute of current thread -----------------------------------
+* set priority and cpu affinity of current thread by [RT] setting
+* args   : int    type      I   thread type (RT_GRAB/RT_CH/RT_SYNC/RT_OUT/
+*                               RT_PLOT)
+* return : int                  0:okay -1:error
+*-----------------------------------------------------------------------------*/
+extern int sdrrtthread(int type)
+{
+    int ret=0,prio=0;
+
+    if (type<0||type>=RT_NTYPE) return -1;
+
+    if (setthreadaffinity(rtcpumask(type))<0) {
+        SDRPRINTF("error: failed to set cpu affinity: type=%d\n",type);
+        ret=-1;
+    }
+    if (type==RT_GRAB) prio=sdrini.rtprio;
+    if (type==RT_CH)   prio=sdrini.rtchprio;
+    if (setthreadprio(sdrini.rtpolicy,prio)<0) {
+        SDRPRINTF("error: failed to set real-time priority: type=%d prio=%d "
+            "(permission?)\n",type,prio);
+        ret=-1;
+    }
+    return ret;
+}
+/* lock memory -----------------------------------------------------------------
+* lock all current and future memory pages and pre-fault data buffer
+* args   : void   *p        I   data buffer (NULL: no pre-fault)
+*          size_t size      I   data buffer size (bytes)
+* return : int                  0:okay -1:error
+*-----------------------------------------------------------------------------*/
+extern int sdrrtmemlock(void *p, size_t size)
+{
+    volatile unsigned char *buf=(volatile unsigned char *)p;
+    size_t i,page=4096;
+    int ret=0;
+
+#ifdef WIN32
+    SIZE_T wmin,wmax;
+    if (GetProcessWorkingSetSize(GetCurrentProcess(),&wmin,&wmax)) {
+        SetProcessWorkingSetSize(GetCurrentProcess(),wmin+size,wmax+size);
+    }
+    if (p!=NULL&&!VirtualLock(p,size)) {
+        SDRPRINTF("error: failed to lock memory\n");
+        ret=-1;
+    }
+#else
+    long ps=sysconf(_SC_PAGESIZE);
+    if (ps>0) page=(size_t)ps;
+    if (mlockall(MCL_CURRENT|MCL_FUTURE)<0) {
+        SDRPRINTF("error: failed to lock memory (RLIMIT_MEMLOCK?)\n");
+        ret=-1;
+    }
+#endif
+    /* pre-fault data buffer */
+    if (buf!=NULL) {
+        for (i=0;i<size;i+=page) buf[i]=0;
+        if (size>0) buf[size-1]=0;
+    }
+    return ret;
+}
+/* allocate memory buffer ------------------------------------------------------
+* allocate page-aligned memory buffer of front end data. if huge pages are
+* requested, explicit huge pages (1GB/2MB) are tried first, then transparent
+* huge pages are advised. normal pages are used if both are unavailable
+* args   : size_t size      I   size of memory buffer (bytes)
+*          int    huge      I   huge pages (0:off 1:on)
+* return : void*                memory buffer (NULL: error)
+* note : returned buffer is aligned by MEMHDR (page and cache line). free the
+*        buffer by sdrmemfree()
+*-----------------------------------------------------------------------------*/
+extern void *sdrmemalloc(size_t size, int huge)
+{
+    uint8_t *p=NULL;
+    size_t len=size+MEMHDR;
+    const char *type="normal";
+
+#ifdef WIN32
+    SIZE_T lp=huge?GetLargePageMinimum():0;
+
+    /* large pages (needs SeLockMemoryPrivilege) */
+    if (lp>0) {
+        len=(size+MEMHDR+lp-1)/lp*lp;
+        p=(uint8_t *)VirtualAlloc(NULL,len,MEM_RESERVE|MEM_COMMIT|
+            MEM_LARGE_PAGES,PAGE_READWRITE);
+        type="large";
+    }
+    if (p==NULL) {
+        len=size+MEMHDR;
+        p=(uint8_t *)VirtualAlloc(NULL,len,MEM_RESERVE|MEM_COMMIT,
+            PAGE_READWRITE);
+        type="normal";
+    }
+    if (p==NULL) return NULL;
+#else
+    int prot=PROT_READ|PROT_WRITE,flag=MAP_PRIVATE|MAP_ANONYMOUS;
+    void *q=MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    /* explicit huge pages (reserved by vm.nr_hugepages) */
+    if (huge&&size>=HUGE1GB/2) {
+        len=(size+MEMHDR+HUGE1GB-1)/HUGE1GB*HUGE1GB;
+        q=mmap(NULL,len,prot,flag|MAP_HUGETLB|(30<<MAP_HUGE_SHIFT),-1,0);
+        type="1GB huge";
+    }
+    if (huge&&q==MAP_FAILED) {
+        len=(size+MEMHDR+HUGE2MB-1)/HUGE2MB*HUGE2MB;
+        q=mmap(NULL,len,prot,flag|MAP_HUGETLB|(21<<MAP_HUGE_SHIFT),-1,0);
+        type="2MB huge";
+    }
+#endif
+    if (q==MAP_FAILED) {
+        len=huge?(size+MEMHDR+HUGE2MB-1)/HUGE2MB*HUGE2MB:size+MEMHDR;
+        q=mmap(NULL,len,prot,flag,-1,0);
+        type="normal";
+#ifdef MADV_HUGEPAGE
+        /* transparent huge pages */
+        if (huge&&q!=MAP_FAILED&&!madvise(q,len,MADV_HUGEPAGE)) {
+            type="transparent huge";
+        }
+#endif
+    }
+    if (q==MAP_FAILED) return NULL;
+    p=(uint8_t *)q;
+#endif
+    ((size_t *)p)[0]=len;
+
+    if (huge) {
+        SDRPRINTF("memory buffer: %.1f MB (%s pages)\n",size/1048576.0,type);
+    }
+    return p+MEMHDR;
+}
+/* free memory buffer ----------------------------------------------------------
+* args   : void   *p        I   memory buffer allocated by sdrmemalloc()
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void sdrmemfree(void *p)
+{
+    uint8_t *q;
+
+    if (p==NULL) return;
+    q=(uint8_t *)p-MEMHDR;
+#ifdef WIN32
+    VirtualFree(q,0,MEM_RELEASE);
+#else
+    munmap(q,((size_t *)q)[0]);
+#endif
+}
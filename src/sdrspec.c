@@ -34,6 +34,9 @@ extern void *specthread(void * arg)
     uint64_t buffloc;
     double *xI,*yI,*xQ,*yQ,*freq,*pspec;
 
+    /* isolate from grabber and channel threads */
+    sdrrtthread(RT_PLOT);
+
     /* check front end */
     if (sdrini.fend==FEND_FILE) {
         if (spec->ftype==FTYPE2&&(!sdrini.useif2)) {
@@ -41,7 +44,8 @@ extern void *specthread(void * arg)
             return THRETVAL;
         }
     }
-    if (sdrini.fend==FEND_GN3SV2||sdrini.fend==FEND_GN3SV3) {
+    if (sdrini.fend==FEND_GN3SV2||sdrini.fend==FEND_GN3SV3||
+        sdrini.fend==FEND_NET) {
         if (spec->ftype==FTYPE2) {
             SDRPRINTF("error: spectrum analysis FE2 doesn't exist\n");
             return THRETVAL;
@@ -67,9 +71,7 @@ extern void *specthread(void * arg)
         sleepms(SPEC_MS);
 
         /* current buffer location */
-        mlock(hreadmtx);
-        buffloc=(sdrstat.fendbuffsize*sdrstat.buffcnt)-SPEC_LEN*spec->nsamp;
-        unmlock(hreadmtx);
+        buffloc=rcvstrmhead(spec->ftype)-SPEC_LEN*spec->nsamp;
 
         /* get current if data */
         rcvgetbuff(&sdrini,buffloc,SPEC_LEN*spec->nsamp,spec->ftype,
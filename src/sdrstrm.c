@@ -0,0 +1,177 @@
+/*------------------------------------------------------------------------------
+* sdrstrm.c : SDR multi-stream IF data ingest functions
+*
+* Copyright (C) 2014 Taro Suzuki <gnsssdrlib@gmail.com>
+*-----------------------------------------------------------------------------*/
+#include "sdr.h"
+
+/* read block of stream --------------------------------------------------------
+* read next block of IF file to ring of stream. samples before the start of
+* IF file (negative offset) are zero-filled
+* args   : sdrstrm_t *st    I/O stream struct
+*          uint8_t *p       O   block of ring
+* return : int                  number of read samples (<blklen: end of file)
+*-----------------------------------------------------------------------------*/
+static int readblk(sdrstrm_t *st, uint8_t *p)
+{
+    int nz=0,n,len;
+
+    if (st->pos<0) {
+        nz=-st->pos<st->blklen?(int)-st->pos:st->blklen;
+        memset(p,0,st->dtype*nz);
+        st->pos+=nz;
+    }
+    len=st->dtype*(st->blklen-nz);
+    n=st->pack?packread(st->pack,(char *)p+st->dtype*nz,len):
+        (int)fread(p+st->dtype*nz,1,len,st->fp);
+    if (n<len) memset(p+st->dtype*nz+n,0,len-n);
+    return nz+n/st->dtype;
+}
+/* fill ring of stream ---------------------------------------------------------
+* read one block if the head of stream is behind the head of FTYPE1 in time
+* args   : sdrstrm_t *st    I/O stream struct
+* return : int                  1:block pushed 0:no block pushed
+* note : the block counter is updated under the mutex of stream, so readers
+*        of FTYPE1 and stream are not serialized
+*-----------------------------------------------------------------------------*/
+static int fillring(sdrstrm_t *st)
+{
+    uint64_t head=st->cnt*st->blklen;
+    uint8_t *p=st->buff+(st->cnt%st->nblk)*st->dtype*st->blklen;
+    int n;
+
+    if (st->eof||(double)head>=rcvstrmloc(st->ftype,(double)rcvheadloc())) {
+        return 0;
+    }
+    n=readblk(st,p);
+
+    mlock(st->mtx);
+    if (n>0) st->cnt++;
+    if (n<st->blklen) st->eof=1;
+    unmlock(st->mtx);
+
+    if (st->eof) SDRPRINTF("end of file! (FILE2)\n");
+    return n>0;
+}
+/* stream reader thread --------------------------------------------------------
+* read IF file of stream following the head of FTYPE1 in time
+* args   : void   *arg      I   stream struct
+* return : none
+*-----------------------------------------------------------------------------*/
+#ifdef WIN32
+static void strmthread(void *arg)
+#else
+static void *strmthread(void *arg)
+#endif
+{
+    sdrstrm_t *st=(sdrstrm_t *)arg;
+
+    sdrrtthread(RT_GRAB);
+
+    while (!st->quit&&!st->eof) {
+        if (!fillring(st)) sleepms(1);
+    }
+    return THRETVAL;
+}
+/* initialize stream -----------------------------------------------------------
+* set sample clock of FILE2 stream. stream samples are counted from the common
+* time origin (start of FILE1), FILE2 is aligned by SKEW2 or START1/START2
+* args   : sdrini_t *ini    I   sdr initialization struct
+* return : int                  status 0:okay -1:failure
+* note : call after FILE2 is opened, before FILE2 is mapped or positioned.
+*        FILE2 is positioned to pos (>0) by front end
+*-----------------------------------------------------------------------------*/
+extern int strminit(sdrini_t *ini)
+{
+    sdrstrm_t *st;
+    double start;
+
+    if (ini->fp2==NULL) return 0;
+
+    if (!(st=(sdrstrm_t *)calloc(1,sizeof(sdrstrm_t)))) {
+        SDRPRINTF("error: strminit memory allocation\n");
+        return -1;
+    }
+    st->ftype=FTYPE2;
+    st->dtype=ini->dtype[1];
+    st->ratio=ini->f_sf[1]/ini->f_sf[0];
+
+    /* sample of FILE2 at common time origin */
+    start=ini->skew2+ini->fileoff*st->ratio;
+    st->pos=(int64_t)floor(start);
+    st->frac=start-st->pos;
+    st->blklen=FILE_BUFFSIZE;
+    st->fp=ini->fp2;
+    st->pack=sdrstat.pack[1].hdr.bits?&sdrstat.pack[1]:NULL;
+    initmlock(st->mtx);
+    sdrstat.strm=st;
+    return 0;
+}
+/* start stream ----------------------------------------------------------------
+* allocate ring of stream and start reader thread
+* args   : sdrini_t *ini    I   sdr initialization struct
+* return : int                  status 0:okay -1:failure
+* note : ring has the same depth in time as FTYPE1 (RINGMS). in offline mode,
+*        the grabber pushes the stream by strmpush() (deterministic)
+*-----------------------------------------------------------------------------*/
+extern int strmstart(sdrini_t *ini)
+{
+    sdrstrm_t *st=sdrstat.strm;
+    int ms=ini->ringms>0?ini->ringms:RINGMS;
+
+    if (st==NULL||sdrstat.map[1].p!=NULL) return 0;
+
+    st->nblk=(int)ceil(ms*1E-3*ini->f_sf[1]/st->blklen);
+    if (st->nblk<RINGMINBLK) st->nblk=RINGMINBLK;
+
+    if (!(st->buff=(uint8_t *)sdrmemalloc((size_t)st->dtype*st->blklen*
+        st->nblk,ini->hugepage))) {
+        SDRPRINTF("error: failed to allocate memory for the buffer\n");
+        return -1;
+    }
+    sdrstat.buff2=st->buff;
+
+    if (st->pos>0) st->pos=0; /* IF file is positioned by front end */
+    st->sync=ini->offline;
+
+    if (!st->sync) {
+        cratethread(st->hread,strmthread,st);
+        st->run=1;
+    }
+    SDRPRINTF("FILE2 stream: offset=%.3f sample ratio=%.6f\n",
+        ini->skew2+ini->fileoff*st->ratio,st->ratio);
+    return 0;
+}
+/* stop stream -----------------------------------------------------------------
+* stop reader thread of stream. the ring is freed with memory buffer
+* args   : none
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void strmquit(void)
+{
+    sdrstrm_t *st=sdrstat.strm;
+
+    if (st==NULL) return;
+
+    if (st->run) {
+        st->quit=1;
+        waitthread(st->hread);
+    }
+    delmlock(st->mtx);
+    sdrstat.strm=NULL;
+    free(st);
+}
+/* push stream synchronously ---------------------------------------------------
+* push blocks of stream until the stream reaches the head of FTYPE1 in time.
+* called by grabber after FTYPE1 is pushed (offline mode)
+* args   : none
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void strmpush(void)
+{
+    sdrstrm_t *st=sdrstat.strm;
+
+    if (st==NULL||!st->sync||st->buff==NULL) return;
+
+    while (fillring(st)) ;
+}
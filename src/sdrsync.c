@@ -5,25 +5,23 @@
 *-----------------------------------------------------------------------------*/
 #include "sdr.h"
 
-/* synchronization thread ------------------------------------------------------
-* synchronization thread for pseudo range computation  
-* args   : void   *arg      I   not used
-* return : none
-* note : this thread collects all data of sdr channel thread and compute pseudo
-*        range at every output timing.
+/* initialize synchronization --------------------------------------------------
+* start tcp servers, create rinex files, allocate synchronization buffers and
+* start observation output and single point positioning
+* args   : sdrsync_t *sync  O   sdr synchronization struct
+* return : int                  status 0:okay -1:failure
 *-----------------------------------------------------------------------------*/
-#ifdef WIN32
-extern void syncthread(void * arg)
-#else
-extern void *syncthread(void * arg)
-#endif
+extern int initsync(sdrsync_t *sync)
 {
-    int i,j,nsat,isat[MAXOBS],ind[MAXSAT]={0},refi;
-    uint64_t sampref,sampbase,codei[MAXSAT],diffcnt,mincodei;
-    double codeid[OBSINTERPN],remcode[MAXSAT],samprefd,reftow=0,oldreftow;
-    sdrobs_t obs[MAXSAT];
-    sdrtrk_t trk[MAXSAT]={{0}};
-
+    sync->reftow=0;
+    sync->epoch=0;
+    sync->npass=0;
+    memset(sync->lag,0,sizeof(sync->lag));
+    memset(sync->hint,0,sizeof(sync->hint));
+    if (!(sync->obsh=(sdrobsh_t *)calloc(MAXSAT,sizeof(sdrobsh_t)))) {
+        SDRPRINTF("error: initsync memory allocation\n");
+        return -1;
+    }
     /* start tcp server (rtcm) */
     if (sdrini.rtcm) {
         sdrout.soc_rtcm.port=sdrini.rtcmport;
@@ -46,127 +44,305 @@ extern void *syncthread(void * arg)
     }
     sdrout.obsd=(obsd_t *)calloc(MAXSAT,sizeof(obsd_t));
 
-	//***************************************************************************
+    /* observation output queue and single point positioning */
+    if (obsqinit(&sdrini)<0||pvtinit(&sdrini)<0) sdrstat.stopflag=ON;
+    return 0;
+}
+/* active channel of observation data ------------------------------------------
+* args   : int    i         I   channel index
+*          int    *week     O   gps week of ephemeris
+* return : int                  1:active 0:not active
+*-----------------------------------------------------------------------------*/
+static int activech(int i, int *week)
+{
+    sdreph_t eph;
 
-    while (!sdrstat.stopflag) 
-	{
+    if (!sdrch[i].nav.flagdec) return 0;
+    navgeteph(&sdrch[i].nav,&eph); /* ephemeris published by decoder */
+    *week=eph.week_gpst;
+    return eph.eph.week!=0;
+}
+/* copy observation histories --------------------------------------------------
+* copy observation histories of active channels whose newest tow is later than
+* or equal to tow
+* args   : sdrsync_t *sync  I/O sdr synchronization struct
+*          double tow       I   minimum tow of newest data (s)
+* return : none
+*-----------------------------------------------------------------------------*/
+static void copyobsh(sdrsync_t *sync, double tow)
+{
+    sdrobsh_t *h;
+    sdrtrksnap_t snap;
+    int i,week;
 
-        mlock(hobsmtx);
+    for (i=sync->nsat=0;i<sdrini.nch;i++) {
+        if (!activech(i,&week)) continue;
+        h=&sync->obsh[sync->nsat];
+        obsgethist(&sdrch[i].trk,h);
+        if (h->tow[h->head]<tow-1E-4) continue;
+        trkgetsnap(&sdrch[i].trk,&snap);
+        sync->S[sync->nsat]=snap.S;
+        sync->isat[sync->nsat]=i;
+        sync->week[sync->nsat++]=week;
+    }
+}
+/* output observation data -----------------------------------------------------
+* compute pseudo range, carrier phase and doppler at reference tow from copied
+* observation histories and output observation and navigation data
+* args   : sdrsync_t *sync  I/O sdr synchronization struct
+*          double reftow    I   reference tow (s)
+* return : int                  1:observation data output 0:no output
+*-----------------------------------------------------------------------------*/
+static int outobs(sdrsync_t *sync, double reftow)
+{
+    int i,n,ind[MAXSAT],refi,ftype,*isat=sync->isat;
+    uint64_t sampref,diffcnt;
+    double codec[MAXSAT],mincodec,sampbase,samprefd;
+    sdrobs_t obs[MAXSAT];
+    sdrobsh_t *h=sync->obsh;
+    sdreph_t eph;
 
-        /* copy all tracking data */
-        for (i=nsat=0;i<sdrini.nch;i++) {
-            if (sdrch[i].nav.flagdec&&sdrch[i].nav.sdreph.eph.week!=0) {
-                memcpy(&trk[nsat],&sdrch[i].trk,sizeof(sdrch[i].trk));
-                isat[nsat]=i;
-                nsat++;
-            }
+    /* select same timing index */
+    for (i=n=0;i<sync->nsat;i++) {
+        if ((ind[n]=obsfindtow(&h[i],reftow))<0) {
+            SDRPRINTF("error:%s reftow=%.1f tow=%.1f\n",sdrch[isat[i]].satstr,
+                h[i].tow[obsidx(&h[i],OBSINTERPN-1)],reftow);
+            continue;
         }
+        if (n<i) {
+            memcpy(&h[n],&h[i],sizeof(sdrobsh_t));
+            sync->S[n]=sync->S[i];
+            sync->isat[n]=sync->isat[i];
+            sync->week[n]=sync->week[i];
+        }
+        n++;
+    }
+    if ((sync->nsat=n)==0) return 0;
 
-        unmlock(hobsmtx);
-
-        /* find minimum tow channel (most distant satellite) */
-        oldreftow=reftow;
-        reftow=3600*24*7;
-        for (i=0;i<nsat;i++) {
-            if (trk[i].tow[0]<reftow)
-                reftow=trk[i].tow[0];
+    /* decide reference satellite (nearest satellite). code timing of
+       channels is compared by common time index of front end streams */
+    mincodec=0.0;
+    refi=0;
+    for (i=0;i<n;i++) {
+        codec[i]=rcvcomloc(sdrch[isat[i]].ftype,(double)h[i].codei[ind[i]]);
+        if (i==0||codec[i]<mincodec) {
+            refi=i;
+            mincodec=codec[i];
         }
-        /* output timing check */
-        if (nsat==0 || oldreftow==reftow || ((int)(reftow*1000) % sdrini.outms)!=0) 
+        codec[i]=rcvcomloc(sdrch[isat[i]].ftype,
+            (double)h[i].codei[ind[i]]-h[i].remcout[ind[i]]);
+    }
+    /* reference satellite */
+    ftype=sdrch[isat[refi]].ftype;
+    diffcnt=h[refi].cntout[ind[refi]]-sdrch[isat[refi]].nav.firstsfcnt;
+    sampref=sdrch[isat[refi]].nav.firstsf+
+        (uint64_t)(sdrch[isat[refi]].nsamp*
+        (-PTIMING/(1000*sdrch[isat[refi]].ctime)+diffcnt));
+    sampbase=rcvcomloc(ftype,(double)(h[refi].codei[obsidx(&h[refi],
+        OBSINTERPN-1)]-10*sdrch[isat[refi]].nsamp));
+    samprefd=rcvcomloc(ftype,(double)sampref)-sampbase;
+
+    /* computation observation data */
+    for (i=0;i<n;i++) {
+        obs[i].sys=sdrch[isat[i]].sys;
+        obs[i].prn=sdrch[isat[i]].prn;
+        obs[i].week=sync->week[i];
+        obs[i].tow=reftow+(double)(PTIMING)/1000; 
+        obs[i].P=CLIGHT*(codec[i]-sampbase-samprefd)/sdrini.f_sf[0];
+        
+        /* interpolation at common time index */
+        obsinterp(&h[i],sdrch[isat[i]].ftype,sampbase,samprefd,
+            &sync->hint[isat[i]],&obs[i].L,&obs[i].D);
+        obs[i].S=sync->S[i];
+    }
+    sdrout.nsat=n;
+    sdrobs2obsd(obs,n,sdrout.obsd);
+
+    /* single point positioning */
+    pvtsolve(sdrout.obsd,n,isat,rcvcomloc(ftype,(double)sampref));
+
+    /* rinex and binary obs output (writer thread) */
+    obsqpush(sdrout.obsd,sdrout.nsat);
+    /* rtcm obs output */
+    if (sdrini.rtcm&&sdrout.soc_rtcm.flag) 
+        sendrtcmobs(sdrout.obsd,&sdrout.soc_rtcm,sdrout.nsat);
+
+    /* navigation data output */
+    for (i=0;i<sdrini.nch;i++)
+	{
+        /* ephemeris completed by decoder */
+        if (sdrch[i].nav.ephnew!=sdrch[i].nav.ephout) 
 		{
-            continue;
-        }
-        /* select same timing index */
-        for (i=0;i<nsat;i++) {
-            for (j=0;j<OBSINTERPN;j++) {
-                if (fabs(trk[i].tow[j]-reftow)<1E-4) {
-                    ind[i]=j;
-                    break;
+            sdrch[i].nav.ephout=sdrch[i].nav.ephnew;
+            navgeteph(&sdrch[i].nav,&eph);
+
+            /* rtcm nav output */
+            if (sdrini.rtcm&&sdrout.soc_rtcm.flag) 
+                sendrtcmnav(&eph,&sdrout.soc_rtcm);
+
+            /* rinex nav output */
+            if (sdrini.rinex) {
+                if (writerinexnav(sdrout.rinexnav,
+                    &sdrout.opt,&eph)<0) {
+                    
+                    sdrstat.stopflag=ON;
                 }
             }
-            if (j==OBSINTERPN-1&&ind[i]==0) 
-                SDRPRINTF("error:%s reftow=%.1f tow=%.1f\n",
-                    sdrch[isat[i]].satstr,trk[i].tow[OBSINTERPN-1],reftow);
         }
+    }
+    return 1;
+}
+/* synchronization of observation data -----------------------------------------
+* collect tracking data of all sdr channels and compute pseudo range at output
+* timing
+* args   : sdrsync_t *sync  I/O sdr synchronization struct
+* return : int                  1:observation data output 0:no output
+* note : output timing is detected by polling (offline mode)
+*-----------------------------------------------------------------------------*/
+extern int syncobs(sdrsync_t *sync)
+{
+    int i;
+    double reftow,oldreftow;
+    sdrobsh_t *h=sync->obsh;
 
-        /* decide reference satellite (nearest satellite) */
-        mincodei=UINT64_MAX;
-        refi=0;
-        for (i=0;i<nsat;i++) {
-            codei[i]=trk[i].codei[ind[i]];
-            remcode[i]=trk[i].remcout[ind[i]];
-            if (trk[i].codei[ind[i]]<mincodei) {
-                refi=i;
-                mincodei=trk[i].codei[ind[i]];
-            }
-        }
-        /* reference satellite */
-        diffcnt=trk[refi].cntout[ind[refi]]-sdrch[isat[refi]].nav.firstsfcnt;
-        sampref=sdrch[isat[refi]].nav.firstsf+
-            (uint64_t)(sdrch[isat[refi]].nsamp*
-            (-PTIMING/(1000*sdrch[isat[refi]].ctime)+diffcnt));
-        sampbase=trk[refi].codei[OBSINTERPN-1]-10*sdrch[isat[refi]].nsamp;
-        samprefd=(double)(sampref-sampbase);
-
-        /* computation observation data */
-        for (i=0;i<nsat;i++) {
-            obs[i].sys=sdrch[isat[i]].sys;
-            obs[i].prn=sdrch[isat[i]].prn;
-            obs[i].week=sdrch[isat[i]].nav.sdreph.week_gpst;
-            obs[i].tow=reftow+(double)(PTIMING)/1000; 
-            obs[i].P=CLIGHT*sdrch[isat[i]].ti*
-                ((double)(codei[i]-sampref)-remcode[i]); /* pseudo range */
-            
-            /* uint64 to double for interp1 */
-            uint64todouble(trk[i].codei,sampbase,OBSINTERPN,codeid);
-            obs[i].L=interp1(codeid,trk[i].L,OBSINTERPN,samprefd);
-            obs[i].D=interp1(codeid,trk[i].D,OBSINTERPN,samprefd);
-            obs[i].S=trk[i].S[0];
-        }
-        sdrout.nsat=nsat;
-        sdrobs2obsd(obs,nsat,sdrout.obsd);
+    /* copy all tracking data */
+    copyobsh(sync,0.0);
 
-		// SEND!
+    /* find minimum tow channel (most distant satellite) */
+    oldreftow=sync->reftow;
+    reftow=3600*24*7;
+    for (i=0;i<sync->nsat;i++) {
+        if (h[i].tow[h[i].head]<reftow)
+            reftow=h[i].tow[h[i].head];
+    }
+    sync->reftow=reftow;
 
-        /* rinex obs output */
-        if (sdrini.rinex) {
-            if (writerinexobs(sdrout.rinexobs,&sdrout.opt,sdrout.obsd,
-                sdrout.nsat)<0) {
-                    sdrstat.stopflag=ON;
-            }
+    /* output timing check */
+    if (sync->nsat==0 || oldreftow==reftow || 
+        ((int)(reftow*1000) % sdrini.outms)!=0) 
+	{
+        return 0;
+    }
+    return outobs(sync,reftow);
+}
+/* schedule output epoch -------------------------------------------------------
+* check that all active channels passed the next output epoch. channels which
+* do not pass the epoch in SYNCLAG ms are excluded until they pass an epoch
+* args   : sdrsync_t *sync  I/O sdr synchronization struct
+* return : int                  0:output epoch
+*                               >0:wait time for next check (ms)
+* note : call with locked hobsmtx, so epoch events are not lost before wait
+*-----------------------------------------------------------------------------*/
+static int schedobs(sdrsync_t *sync)
+{
+    sdrtrksnap_t snap;
+    double tow[MAXSAT],tmin=0.0;
+    int i,n=0,npass=0,nwait=0,act[MAXSAT],week,t;
+
+    for (i=0;i<sdrini.nch;i++) {
+        if (!(act[i]=activech(i,&week))) continue;
+        trkgetsnap(&sdrch[i].trk,&snap);
+        tow[i]=snap.tow*1000.0;
+        if (n++==0||tow[i]<tmin) tmin=tow[i];
+    }
+    if (n==0) {
+        sync->epoch=0;
+        return SYNCIDLE;
+    }
+    /* first epoch, or all channels passed next epoch (week rollover) */
+    if (sync->epoch==0||tmin>=sync->epoch+sdrini.outms||
+        tmin<sync->epoch-302400000.0) {
+        sync->epoch=(int)floor(tmin/sdrini.outms+1E-6)*sdrini.outms;
+        sync->npass=0;
+    }
+    for (i=0;i<sdrini.nch;i++) {
+        if (!act[i]) continue;
+        if (tow[i]>=sync->epoch-0.1) {
+            sync->lag[i]=0;
+            npass++;
         }
-        /* rtcm obs output */
-        if (sdrini.rtcm&&sdrout.soc_rtcm.flag) 
-            sendrtcmobs(sdrout.obsd,&sdrout.soc_rtcm,sdrout.nsat);
+        else if (!sync->lag[i]) nwait++;
+    }
+    if (npass==0) {
+        sync->npass=0;
+        return SYNCIDLE;
+    }
+    /* wait for lagging channels */
+    if (nwait>0) {
+        if (sync->npass==0) {
+            sync->npass=npass;
+            sync->tpass=tickget();
+        }
+        if ((t=(int)(tickget()-sync->tpass))<SYNCLAG) return SYNCLAG-t;
 
-        /* navigation data output */
-        for (i=0;i<sdrini.nch;i++)
-		{
-            if ((sdrch[i].nav.sdreph.update)&&
-                (sdrch[i].nav.sdreph.cnt >= sdrch[i].nav.sdreph.cntth)) 
-			{
-                sdrch[i].nav.sdreph.cnt=0;
-                sdrch[i].nav.sdreph.update=OFF;
-
-                /* rtcm nav output */
-                if (sdrini.rtcm&&sdrout.soc_rtcm.flag) 
-                    sendrtcmnav(&sdrch[i].nav.sdreph,&sdrout.soc_rtcm);
-
-                /* rinex nav output */
-                if (sdrini.rinex) {
-                    if (writerinexnav(sdrout.rinexnav,
-                        &sdrout.opt,&sdrch[i].nav.sdreph)<0) {
-                        
-                        sdrstat.stopflag=ON;
-                    }
-                }
-            }
+        for (i=0;i<sdrini.nch;i++) {
+            if (act[i]&&tow[i]<sync->epoch-0.1) sync->lag[i]=1;
         }
     }
-    /* thread termination */
-    free(sdrout.obsd);
+    sync->npass=0;
+    return 0;
+}
+/* terminate synchronization ---------------------------------------------------
+* free synchronization buffers, stop observation output and single point
+* positioning and close tcp servers
+* args   : sdrsync_t *sync  I/O sdr synchronization struct
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void quitsync(sdrsync_t *sync)
+{
+    free(sync->obsh); sync->obsh=NULL;
+    free(sdrout.obsd); sdrout.obsd=NULL;
+    obsqquit();
+    pvtquit();
     tcpsvrclose(&sdrout.soc_rtcm);
     tcpsvrclose(&sdrout.soc_sbas);
+}
+/* synchronization thread ------------------------------------------------------
+* synchronization thread for pseudo range computation  
+* args   : void   *arg      I   not used
+* return : none
+* note : this thread collects all data of sdr channel thread and compute pseudo
+*        range at every output timing. the thread sleeps until channels signal
+*        that their tow passed an output epoch
+*-----------------------------------------------------------------------------*/
+#ifdef WIN32
+extern void syncthread(void * arg)
+#else
+extern void *syncthread(void * arg)
+#endif
+{
+    sdrsync_t sync;
+    int ms;
+
+    /* cpu affinity of synchronization thread */
+    sdrrtthread(RT_SYNC);
+
+    if (initsync(&sync)<0) {
+        sdrstat.stopflag=ON;
+        return THRETVAL;
+    }
+
+	//***************************************************************************
+
+    /* epoch scheduler: wake on epoch events of channels or timeout */
+    mlock(hobsmtx);
+    while (!sdrstat.stopflag) 
+	{
+        if ((ms=schedobs(&sync))>0) {
+            sdrwaitevent(&hobseve,&hobsmtx,ms);
+            continue;
+        }
+        unmlock(hobsmtx);
+
+        copyobsh(&sync,sync.epoch*1E-3);
+        outobs(&sync,sync.epoch*1E-3);
+        sync.epoch+=sdrini.outms;
+
+        mlock(hobsmtx);
+    }
+    unmlock(hobsmtx);
+    /* thread termination */
+    quitsync(&sync);
     SDRPRINTF("SDR syncthread finished!\n");
 
     return THRETVAL;
@@ -0,0 +1,275 @@
+/*------------------------------------------------------------------------------
+* sdrtee.c : SDR tee recording and triggered capture functions
+*
+* Copyright (C) 2014 Taro Suzuki <gnsssdrlib@gmail.com>
+*-----------------------------------------------------------------------------*/
+#include "sdr.h"
+
+/* open output file ------------------------------------------------------------
+* args   : char   *file     I   output file path
+*          int    bits      I   bits of output (0:raw int8, 1,2,4,8:packed)
+*          sdrpack_t *out   O   output file
+* return : int                  status 0:okay -1:failure
+*-----------------------------------------------------------------------------*/
+static int openout(const char *file, int bits, sdrpack_t *out)
+{
+    sdrpackhdr_t hdr={0};
+
+    if (bits==0) {
+        memset(out,0,sizeof(sdrpack_t));
+        if (!(out->fp=fopen(file,"wb"))) {
+            SDRPRINTF("error: failed to open file: %s\n",file);
+            return -1;
+        }
+        return 0;
+    }
+    hdr.f_sf =sdrini.f_sf[0];
+    hdr.f_if =sdrini.f_if[0];
+    hdr.f_cf =sdrini.f_cf[0];
+    hdr.dtype=sdrini.dtype[0];
+    hdr.bits =bits;
+    strncpy(hdr.fend,sdrstat.fend->name,31);
+    return packcreate(file,&hdr,out);
+}
+/* write output file ---------------------------------------------------------*/
+static int writeout(sdrpack_t *out, const char *p, int n)
+{
+    if (out->hdr.bits==0) return fwrite(p,1,n,out->fp)==(size_t)n?0:-1;
+    return packwrite(out,p,n);
+}
+/* close output file ---------------------------------------------------------*/
+static void closeout(sdrpack_t *out)
+{
+    if (out->fp==NULL) return;
+    if (out->hdr.bits==0) {
+        fclose(out->fp);
+        out->fp=NULL;
+    }
+    else packfinish(out);
+}
+/* head block of memory buffer -----------------------------------------------*/
+static uint64_t headblk(void)
+{
+    return rcvheadloc()/sdrstat.fendbuffsize;
+}
+/* write block -----------------------------------------------------------------
+* write block of memory buffer to output file. blocks which are about to be
+* overwritten by front end are not written
+* args   : sdrtee_t *tee    I   tee recording struct
+*          sdrpack_t *out   I/O output file
+*          uint64_t blk     I   block number
+* return : int                  status 1:written 0:late -1:error
+*-----------------------------------------------------------------------------*/
+static int writeblk(sdrtee_t *tee, sdrpack_t *out, uint64_t blk)
+{
+    const char *p=(const char *)sdrstat.buff+
+        (blk&sdrstat.nblkmask)*tee->blklen;
+
+    if (headblk()-blk>sdrstat.nblk/2) return 0;
+    return writeout(out,p,tee->blklen)<0?-1:1;
+}
+/* triggered capture -----------------------------------------------------------
+* dump data of last TRIGSEC seconds in memory buffer to new file
+* args   : sdrtee_t *tee    I/O tee recording struct
+*          uint64_t head    I   head block at trigger
+* return : none
+*-----------------------------------------------------------------------------*/
+static void capture(sdrtee_t *tee, uint64_t head)
+{
+    sdrpack_t out;
+    char file[1100];
+    uint64_t blk,nblk;
+    int n=0;
+
+    nblk=(uint64_t)(sdrini.trigsec*sdrini.f_sf[0]/sdrstat.fendbuffsize)+1;
+    if (nblk>(uint64_t)sdrstat.nblk/2) { /* data kept in memory buffer */
+        nblk=sdrstat.nblk/2;
+    }
+    if (nblk>head) nblk=head;
+
+    sprintf(file,"%s_%03d.%s",sdrini.trigfile[0]?sdrini.trigfile:"trig",
+        ++tee->ntrig,sdrini.teebits?"pkd":"bin");
+    if (openout(file,sdrini.teebits,&out)<0) return;
+
+    for (blk=head-nblk;blk<head;blk++) {
+        if (writeblk(tee,&out,blk)>0) n++;
+    }
+    closeout(&out);
+    SDRPRINTF("triggered capture: %s (%.2f s)\n",file,
+        (double)n*sdrstat.fendbuffsize/sdrini.f_sf[0]);
+}
+/* triggered capture thread ----------------------------------------------------
+* dump data at trigger apart from the writer thread, so the queue of tee
+* recording is drained during capture. triggers are accepted again after
+* the capture is finished
+* args   : void   *arg      I   tee recording struct
+* return : none
+*-----------------------------------------------------------------------------*/
+#ifdef WIN32
+static void capthread(void *arg)
+#else
+static void *capthread(void *arg)
+#endif
+{
+    sdrtee_t *tee=(sdrtee_t *)arg;
+
+    sdrrtthread(RT_OUT);
+
+    capture(tee,tee->trig-1);
+    sdrbarrier();
+    tee->trig=0;
+    tee->capdone=1;
+
+    return THRETVAL;
+}
+/* tee writer thread -----------------------------------------------------------
+* drain queue of filled blocks to tee recording file and start triggered
+* capture thread. front end never waits for the writer
+* args   : void   *arg      I   tee recording struct
+* return : none
+*-----------------------------------------------------------------------------*/
+#ifdef WIN32
+static void teethread(void *arg)
+#else
+static void *teethread(void *arg)
+#endif
+{
+    sdrtee_t *tee=(sdrtee_t *)arg;
+    uint64_t blk;
+    int quit,ret;
+
+    sdrrtthread(RT_OUT);
+
+    do {
+        quit=tee->quit;
+
+        if (tee->caprun&&tee->capdone) {
+            waitthread(tee->hcap);
+            tee->caprun=0;
+        }
+        if (!tee->caprun&&tee->trig&&!quit) {
+            tee->capdone=0;
+            cratethread(tee->hcap,capthread,tee);
+            tee->caprun=1;
+        }
+        while (tee->rp<tee->wp) {
+            sdrbarrier();
+            blk=tee->q[tee->rp&(tee->qlen-1)];
+
+            if ((ret=writeblk(tee,&tee->out,blk))>0) tee->nwrite++;
+            else if (ret==0) tee->nlate++;
+            else tee->nerr++;
+
+            sdrbarrier();
+            tee->rp++;
+        }
+        if (!quit) sleepms(TEEPOLL);
+    } while (!quit);
+
+    if (tee->caprun) waitthread(tee->hcap);
+
+    return THRETVAL;
+}
+/* initialize tee recording ----------------------------------------------------
+* start tee recording of front end data and/or triggered capture
+* args   : sdrini_t *ini    I   sdr initialization struct
+* return : int                  status 0:okay -1:failure
+* note : call after the memory buffer of front end is allocated
+*-----------------------------------------------------------------------------*/
+extern int teeinit(sdrini_t *ini)
+{
+    sdrtee_t *tee;
+
+    if (!ini->teefile[0]&&ini->trigsec<=0.0) return 0;
+
+    if (sdrstat.buff==NULL) {
+        SDRPRINTF("warning: tee recording needs memory buffer, tee is off\n");
+        return 0;
+    }
+    if (!(tee=(sdrtee_t *)calloc(1,sizeof(sdrtee_t)))) {
+        SDRPRINTF("error: teeinit memory allocation\n");
+        return -1;
+    }
+    /* queue length: power of 2 up to 1/4 of memory buffer */
+    for (tee->qlen=1;tee->qlen<ini->teequeue&&tee->qlen<sdrstat.nblk/4;) {
+        tee->qlen*=2;
+    }
+    tee->blklen=ini->dtype[0]*sdrstat.fendbuffsize;
+
+    if (!(tee->q=(uint64_t *)malloc(sizeof(uint64_t)*tee->qlen))||
+        (ini->teefile[0]&&openout(ini->teefile,ini->teebits,&tee->out)<0)) {
+        free(tee->q);
+        free(tee);
+        return -1;
+    }
+    sdrstat.tee=tee;
+    cratethread(tee->hwrite,teethread,tee);
+    tee->run=1;
+
+    if (ini->teefile[0]) {
+        SDRPRINTF("tee recording: %s (queue %d blocks)\n",ini->teefile,
+            tee->qlen);
+    }
+    return 0;
+}
+/* stop tee recording ----------------------------------------------------------
+* drain queue, close tee recording file and print statistics
+* args   : none
+* return : none
+* note : call before the memory buffer of front end is freed
+*-----------------------------------------------------------------------------*/
+extern void teequit(void)
+{
+    sdrtee_t *tee=sdrstat.tee;
+
+    if (tee==NULL) return;
+
+    sdrstat.tee=NULL;
+    if (tee->run) {
+        tee->quit=1;
+        waitthread(tee->hwrite);
+    }
+    if (tee->out.fp) {
+        SDRPRINTF("tee recording: written=%.0f dropped=%.0f late=%.0f "
+            "error=%.0f blocks\n",(double)tee->nwrite,(double)tee->ndrop,
+            (double)tee->nlate,(double)tee->nerr);
+    }
+    closeout(&tee->out);
+    free(tee->q);
+    free(tee);
+}
+/* push block to tee recording -------------------------------------------------
+* queue the last filled block of memory buffer. called by front end after the
+* buffer counter is incremented. if queue is full, the block is dropped
+* args   : none
+* return : none
+* note : single producer (front end) and single consumer (writer thread)
+*-----------------------------------------------------------------------------*/
+extern void teepush(void)
+{
+    sdrtee_t *tee=sdrstat.tee;
+
+    if (tee==NULL||tee->out.fp==NULL) return;
+
+    if (tee->wp-tee->rp>=(uint64_t)tee->qlen) {
+        tee->ndrop++;
+        return;
+    }
+    tee->q[tee->wp&(tee->qlen-1)]=sdrstat.buffcnt-1;
+    sdrbarrier();
+    tee->wp++;
+}
+/* trigger capture -------------------------------------------------------------
+* request capture of last TRIGSEC seconds of front end data (e.g. loss of
+* lock). requests during pending capture are ignored
+* args   : none
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void teetrigger(void)
+{
+    sdrtee_t *tee=sdrstat.tee;
+
+    if (tee==NULL||sdrini.trigsec<=0.0||tee->trig) return;
+
+    tee->trig=headblk()+1;
+}
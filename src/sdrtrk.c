@@ -15,6 +15,7 @@
 extern uint64_t sdrtracking(sdrch_t *sdr, uint64_t buffloc, uint64_t cnt)
 {
     char *data=NULL;
+    const char *span;
     uint64_t bufflocnow;
 
     sdr->flagtrk=OFF;
@@ -22,14 +23,8 @@ extern uint64_t sdrtracking(sdrch_t *sdr, uint64_t buffloc, uint64_t cnt)
     /* memory allocation */
     data=(char*)sdrmalloc(sizeof(char)*(sdr->nsamp+1000)*sdr->dtype);
 
-    /* current buffer location */
-    mlock(hreadmtx);
-
-	int fendbuffsize = sdrstat.fendbuffsize;
-	uint64_t buffcnt = sdrstat.buffcnt;
-
-    bufflocnow = fendbuffsize * buffcnt  - sdr->nsamp;
-    unmlock(hreadmtx);
+    /* current buffer location (head of stream of channel) */
+    bufflocnow=rcvstrmhead(sdr->ftype)-sdr->nsamp;
 
     if (bufflocnow > buffloc) 
 	{
@@ -40,8 +35,10 @@ extern uint64_t sdrtracking(sdrch_t *sdr, uint64_t buffloc, uint64_t cnt)
 		{
 			SDRPRINTF("Tracking: Currsample < 0\n");
 		}
-		//Copy sdr->currnsamp samples of data to the "data" buffer
-        rcvgetbuff(&sdrini, buffloc,sdr->currnsamp,sdr->ftype,sdr->dtype,data);
+		//Get sdr->currnsamp samples of data (copied to "data" buffer if needed)
+        span=rcvgetspan(&sdrini,buffloc,sdr->currnsamp,sdr->ftype,sdr->dtype,
+            data);
+        if (span==NULL) span=data;
 
 		//Copy II/QQ to oldI/oldQ before calculating new  II/QQ
         memcpy(sdr->trk.oldI,sdr->trk.II,1+2*sdr->trk.corrn*sizeof(double));
@@ -50,7 +47,7 @@ extern uint64_t sdrtracking(sdrch_t *sdr, uint64_t buffloc, uint64_t cnt)
         sdr->trk.oldremcode=sdr->trk.remcode;
         sdr->trk.oldremcarr=sdr->trk.remcarr;
         /* correlation - calculate II and QQ values for "corrn" points*/
-        correlator(data,sdr->dtype,sdr->ti,sdr->currnsamp,sdr->trk.carrfreq,
+        correlator(span,sdr->dtype,sdr->ti,sdr->currnsamp,sdr->trk.carrfreq,
             sdr->trk.oldremcarr,sdr->trk.codefreq, sdr->trk.oldremcode,
             sdr->trk.corrp, //sample arr.
 			sdr->trk.corrn,
@@ -61,7 +58,7 @@ extern uint64_t sdrtracking(sdrch_t *sdr, uint64_t buffloc, uint64_t cnt)
         sdrnavigation(sdr,buffloc,cnt); //todo - move to main
 
         sdr->flagtrk=ON;
-    } else {
+    } else if (!sdrini.offline) {
         sleepms(1);
     }
     sdrfree(data);
@@ -164,7 +161,10 @@ extern void dll(sdrch_t *sdr, sdrtrkprm_t *prm, double dt)
     sdr->trk.codeErr=codeErr;
 }
 /* set observation data --------------------------------------------------------
-* calculate doppler/carrier phase/SNR
+* calculate doppler/carrier phase/SNR and add them to ring of observation
+* history (newest data is replaced after OBSINTERPN updates). sync thread is
+* signaled when tow passes an output epoch. readers get consistent copies by
+* obsgethist() and trkgetsnap() without blocking tracking
 * args   : sdrch_t *sdr     I   sdr channel struct
 *          uint64_t buffloc I   current buffer location
 *          uint64_t cnt     I   current counter of sdr channel thread
@@ -175,32 +175,34 @@ extern void dll(sdrch_t *sdr, sdrtrkprm_t *prm, double dt)
 extern void setobsdata(sdrch_t *sdr, uint64_t buffloc, uint64_t cnt, 
                        sdrtrk_t *trk, int snrflag)
 {
-    shiftdata(&trk->tow[1],&trk->tow[0],sizeof(double),OBSINTERPN-1);
-    shiftdata(&trk->L[1],&trk->L[0],sizeof(double),OBSINTERPN-1);
-    shiftdata(&trk->D[1],&trk->D[0],sizeof(double),OBSINTERPN-1);
-    shiftdata(&trk->codei[1],&trk->codei[0],sizeof(uint64_t),OBSINTERPN-1);
-    shiftdata(&trk->cntout[1],&trk->cntout[0],sizeof(uint64_t),OBSINTERPN-1);
-    shiftdata(&trk->remcout[1],&trk->remcout[0],sizeof(double),OBSINTERPN-1);
-
-    trk->tow[0]=sdr->nav.firstsftow+
+    sdrobsh_t *h=&trk->obsh;
+    sdrtrksnap_t *snap;
+    int i=h->head==OBSINTERPN-1?0:h->head+1,e;
+
+    h->seq++; /* seqlock of observation history */
+    sdrbarrier();
+
+    h->L[i]=h->L[h->head]; /* carrier phase is accumulated */
+
+    h->tow[i]=sdr->nav.firstsftow+
         (double)(cnt-sdr->nav.firstsfcnt)*sdr->ctime;
-    trk->codei[0]=buffloc;
-    trk->cntout[0]=cnt;
-    trk->remcout[0]=trk->oldremcode*sdr->f_sf/trk->codefreq;
+    h->codei[i]=buffloc;
+    h->cntout[i]=cnt;
+    h->remcout[i]=trk->oldremcode*sdr->f_sf/trk->codefreq;
 
     /* doppler */
-    trk->D[0]=-(trk->carrfreq-sdr->f_if-sdr->foffset);
+    h->D[i]=-(trk->carrfreq-sdr->f_if-sdr->foffset);
 
     /* carrier phase */
     if (!trk->flagremcarradd) {
-        trk->L[0]-=trk->remcarr/DPI;
+        h->L[i]-=trk->remcarr/DPI;
         //SDRPRINTF("%s cnt=%llu inicarrier=%f m\n",sdr->satstr,cnt,CLIGHT/FREQ1*trk->remcarr/DPI);
         trk->flagremcarradd=ON;
     }
 
     if (sdr->nav.flagsyncf&&!trk->flagpolarityadd) {
         if (sdr->nav.polarity==1) {
-            trk->L[0]+=0.5;
+            h->L[i]+=0.5;
             //SDRPRINTF("%s cnt=%llu polarity=0.5\n",sdr->satstr,cnt);
         } else {
             //SDRPRINTF("%s cnt=%llu polarity=0.0\n",sdr->satstr,cnt);
@@ -208,18 +210,153 @@ extern void setobsdata(sdrch_t *sdr, uint64_t buffloc, uint64_t cnt,
         trk->flagpolarityadd=ON;
     }
 
-    trk->L[0]+=trk->D[0]*(trk->loopms*sdr->currnsamp/sdr->f_sf);
+    h->L[i]+=h->D[i]*(trk->loopms*sdr->currnsamp/sdr->f_sf);
+    h->head=i;
+
+    sdrbarrier();
+    h->seq++;
 
     trk->Isum+=fabs(trk->sumI[0]);
     if (snrflag) {
-        shiftdata(&trk->S[1],&trk->S[0],sizeof(double),OBSINTERPN-1);
-        shiftdata(&trk->codeisum[1],&trk->codeisum[0],
-            sizeof(uint64_t),OBSINTERPN-1);
+        i=trk->snri=trk->snri==OBSINTERPN-1?0:trk->snri+1;
 
         /* signal to noise ratio */
-        trk->S[0]=10*log(trk->Isum/100.0/100.0)+log(500.0)+5;
-        trk->codeisum[0]=buffloc;
+        trk->S[i]=10*log(trk->Isum/100.0/100.0)+log(500.0)+5;
+        trk->codeisum[i]=buffloc;
 		trk->Isum_fin = trk->Isum;
         trk->Isum=0;
     }
+    /* publish snapshot to unused buffer */
+    snap=&trk->snap[(trk->snapver+1)&1];
+    snap->tow=h->tow[h->head];
+    snap->codei=h->codei[h->head];
+    snap->cntout=h->cntout[h->head];
+    snap->L=h->L[h->head];
+    snap->D=h->D[h->head];
+    snap->S=trk->S[trk->snri];
+    snap->Isum=trk->Isum_fin;
+    sdrbarrier();
+    trk->snapver++;
+
+    /* epoch event to sync thread (tow passed output epoch) */
+    if (sdrini.outms>0&&
+        (e=(int)floor(snap->tow*1000.0/sdrini.outms+1E-6))!=h->epoch) {
+        h->epoch=e;
+        mlock(hobsmtx);
+        setevent(hobseve);
+        unmlock(hobsmtx);
+    }
+}
+/* index of observation history ------------------------------------------------
+* ring index of k-th newest data of observation history
+* args   : sdrobsh_t *obsh  I   observation history
+*          int    k         I   age of data (0:newest, OBSINTERPN-1:oldest)
+* return : int                  ring index
+*-----------------------------------------------------------------------------*/
+extern int obsidx(const sdrobsh_t *obsh, int k)
+{
+    int i=obsh->head-k;
+    return i<0?i+OBSINTERPN:i;
+}
+/* find tow in observation history ---------------------------------------------
+* search observation history from newest to oldest data
+* args   : sdrobsh_t *obsh  I   observation history
+*          double tow       I   time of week (s)
+* return : int                  ring index (-1:not found)
+*-----------------------------------------------------------------------------*/
+extern int obsfindtow(const sdrobsh_t *obsh, double tow)
+{
+    int k,i;
+
+    for (k=0;k<OBSINTERPN;k++) {
+        i=obsidx(obsh,k);
+        if (fabs(obsh->tow[i]-tow)<1E-4) return i;
+    }
+    return -1;
+}
+/* common time index of observation history ----------------------------------*/
+static double obsx(const sdrobsh_t *obsh, int ftype, double base, int p)
+{
+    int i=obsidx(obsh,OBSINTERPN-1-p); /* p=0:oldest */
+    return rcvcomloc(ftype,(double)obsh->codei[i])-base;
+}
+/* interpolate observation history ---------------------------------------------
+* quadratic lagrange interpolation of carrier phase and doppler at common time
+* index. the bracket is searched in ring order from the bracket of last call
+* and the three nearest data are used (same points as interp1()), so no data
+* is copied and no memory is allocated
+* args   : sdrobsh_t *obsh  I   observation history
+*          int    ftype     I   front end type of channel (FTYPE1 or FTYPE2)
+*          double base      I   common time index of origin (sample)
+*          double t         I   common time index to interpolate from base
+*          int    *hint     I/O ring index of last bracket
+*          double *L,*D     O   carrier phase (cycle), doppler (Hz)
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void obsinterp(const sdrobsh_t *obsh, int ftype, double base, double t,
+                      int *hint, double *L, double *D)
+{
+    double x[3],w[3];
+    int p,i,j,r[3];
+
+    /* position of bracket (0:oldest, OBSINTERPN-1:newest) */
+    p=OBSINTERPN-1-(obsh->head-*hint+OBSINTERPN)%OBSINTERPN;
+    if (p>OBSINTERPN-2) p=OBSINTERPN-2;
+
+    while (p>0&&t<obsx(obsh,ftype,base,p)) p--;
+    while (p<OBSINTERPN-2&&t>=obsx(obsh,ftype,base,p+1)) p++;
+    *hint=obsidx(obsh,OBSINTERPN-1-p);
+
+    /* third point next to nearer data */
+    if (fabs(t-obsx(obsh,ftype,base,p))<fabs(t-obsx(obsh,ftype,base,p+1))) p--;
+    if (p<0) p=0;
+    if (p>OBSINTERPN-3) p=OBSINTERPN-3;
+
+    for (i=0;i<3;i++) {
+        r[i]=obsidx(obsh,OBSINTERPN-1-(p+i));
+        x[i]=obsx(obsh,ftype,base,p+i);
+    }
+
+    for (i=0;i<3;i++) {
+        for (w[i]=1.0,j=0;j<3;j++) {
+            if (j!=i) w[i]*=(t-x[j])/(x[i]-x[j]);
+        }
+    }
+    *L=w[0]*obsh->L[r[0]]+w[1]*obsh->L[r[1]]+w[2]*obsh->L[r[2]];
+    *D=w[0]*obsh->D[r[0]]+w[1]*obsh->D[r[1]]+w[2]*obsh->D[r[2]];
+}
+/* get observation history -----------------------------------------------------
+* copy observation history of channel (seqlock reader)
+* args   : sdrtrk_t *trk    I   sdr tracking struct
+*          sdrobsh_t *obsh  O   observation history
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void obsgethist(const sdrtrk_t *trk, sdrobsh_t *obsh)
+{
+    uint32_t seq;
+
+    do {
+        while ((seq=trk->obsh.seq)&1) ;
+        sdrbarrier();
+        memcpy(obsh,&trk->obsh,sizeof(sdrobsh_t));
+        sdrbarrier();
+    } while (trk->obsh.seq!=seq);
+}
+/* get tracking snapshot -------------------------------------------------------
+* copy latest snapshot of channel. snapshot is double buffered, so tracking
+* never waits for readers
+* args   : sdrtrk_t *trk    I   sdr tracking struct
+*          sdrtrksnap_t *snap O snapshot
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void trkgetsnap(const sdrtrk_t *trk, sdrtrksnap_t *snap)
+{
+    uint32_t ver;
+
+    do {
+        ver=trk->snapver;
+        sdrbarrier();
+        *snap=trk->snap[ver&1];
+        sdrbarrier();
+    } while (trk->snapver!=ver);
 }